@@ -18,72 +18,113 @@ using std::endl;
 using std::setw;
 using std::vector;
 
-void Analyzer::DoDcAnalysis(const DcAnalysis dc_analysis) {
-    double frequency = 0;
-    AnalysisMatrix analysis_matrix = GetAnalysisMatrix(frequency);
+bool Analyzer::DoDcAnalysis(const DcAnalysis dc_analysis) {
+    bool linear = circuit->diode_vec.empty();
+    // The sparse solvers get a linear circuit assembled straight into CSC
+    bool sparse = linear && SparseAssembly();
+
+    // `reduced` means remove the 0(gnd) node.
+    AnalysisMatrix analysis_matrix;
+    SparseSystem system;
+    mat reduced_mat;
+    vec reduced_rhs;
+    std::vector<NodeName> reduced_node_vec;
+    if (sparse) {
+        system = SparseDc(*circuit, macromodel_vec);
+        reduced_rhs = system.rhs;
+        reduced_node_vec = system.node_vec;
+    } else {
+        analysis_matrix = AssembleDc();
+        int node_num = analysis_matrix.node_vec.size();
+        reduced_mat = GetReal(analysis_matrix.linear_analysis_mat(span(1, node_num - 1),
+                                                                  span(1, node_num - 1)));
+        reduced_rhs = GetReal(analysis_matrix.rhs(span(1, node_num - 1), 0));
+        reduced_node_vec = analysis_matrix.node_vec;
+        reduced_node_vec.erase(reduced_node_vec.begin());
+    }
+    // The matrices are all the sweep needs from here on
+    ReleaseCircuit();
 
     double start = dc_analysis.start;
     double end = dc_analysis.end;
     double step = dc_analysis.step;
 
-    int node_num = analysis_matrix.node_vec.size();
-
-    // `reduced` means remove the 0(gnd) node.
-    mat reduced_mat = GetReal(analysis_matrix.linear_analysis_mat(span(1, node_num - 1),
-                                                                  span(1, node_num - 1)));
+    int scan_vsrc_index = FindNode(reduced_node_vec, "i_" + dc_analysis.Vsrc_name);
 
-    std::vector<NodeName> reduced_node_vec = analysis_matrix.node_vec;
-    std::vector<NodeName>::iterator h = reduced_node_vec.begin();
-    reduced_node_vec.erase(h);
+    // Only the probed unknowns are kept for every sweep point.
+    std::vector<NodeName> saved_node_vec;
+    arma::uvec saved_index = SavedIndex(reduced_node_vec, saved_node_vec);
+    WaveformStore waveform = NewWaveformStore(saved_node_vec);
+
+    // The matrix is the same for every sweep point, factor it once.
+    FactorCache local_factor;
+    FactorCache& factor = Incremental() ? session->factor : local_factor;
+    bool factored = sparse ? PrepareFactor(factor, system.matrix)
+                           : linear && PrepareFactor(factor, reduced_mat);
+    if (sparse && !factored) {
+        cout << "Singular matrix, DC analysis skipped" << endl;
+        dc_result = DcResult{waveform, saved_node_vec};
+        return false;
+    }
 
-    mat reduced_rhs = GetReal(analysis_matrix.rhs(span(1, node_num - 1), 0));
+    RawWriter raw_writer;
+    OpenRawFile(raw_writer, "DC transfer characteristic", dc_analysis.Vsrc_name,
+                "voltage", saved_node_vec, false);
 
-    std::vector<vec> dc_result_vec;
-    std::vector<double> dc_value_vec;
+    int step_num = int((end + 1e-4 - start) / step) + 1;
+    int step_done = 0;
+    bool completed = true;
 
-    int scan_vsrc_index = FindNode(reduced_node_vec, "i_" + dc_analysis.Vsrc_name);
+    int newton_iterations = GetOptionValue(options, "newtoniter", NEWTON_MAX_ITERATIONS);
+    NewtonStats newton_stats;
 
+    vec result;
     for (double v = start; v <= end + 1e-4; v += step) {
-        mat scan_rhs = reduced_rhs;
+        vec scan_rhs = reduced_rhs;
         scan_rhs(scan_vsrc_index, 0) = v;
 
-        if (!circuit.diode_vec.empty()) {
-            cout << "Nonlinear" << endl;
-            // Nonlinear
-            vec result_n(node_num - 1, arma::fill::zeros);
-            vec result_n_plus_1(node_num - 1, arma::fill::zeros);
-
-            while (true) {
-                // Update the analysis matrix
-                arma::mat mat =
-                    AddExpTerm(analysis_matrix.exp_analysis_vec, result_n, reduced_mat);
-                // Update RHS
-                arma::mat rhs =
-                    AddExpTerm(analysis_matrix.exp_rhs_vec, result_n, scan_rhs);
-                // cout << "reduced_mat:" << endl << reduced_mat << endl;
-                // cout << "scan_rhs" << endl << scan_rhs << endl;
-                result_n_plus_1 = arma::solve(mat, rhs);
-                if (VecDifference(result_n, result_n_plus_1))
-                    break;
-                result_n = result_n_plus_1;
+        if (!linear) {
+            // Nonlinear, from the previous sweep point
+            if (result.n_elem != reduced_mat.n_rows)
+                result.zeros(reduced_mat.n_rows);
+            if (!NewtonSolve(reduced_mat, analysis_matrix.exp_analysis_vec, scan_rhs,
+                             analysis_matrix.exp_rhs_vec, newton_iterations, result,
+                             newton_stats)) {
+                // The point is kept, but the run is not complete
+                cout << "Newton did not converge at " << v << endl;
+                completed = false;
             }
-            dc_result_vec.push_back(result_n_plus_1);
-
         } else {
             // Linear
 
-            vec dc_result = arma::solve(reduced_mat, scan_rhs);
+            // The previous sweep point starts the iterative solver
+            if (factored)
+                result = factor.Solve(scan_rhs.col(0), result);
+            else
+                result = arma::solve(reduced_mat, scan_rhs);
 
-            // cout << "result: " << endl << dc_result << endl;
+            // cout << "result: " << endl << result << endl;
+        }
+
+        vec saved_result = result.elem(saved_index);
+        waveform.Append(v, saved_result.memptr());
+        raw_writer.AppendPoint(v, saved_result);
 
-            dc_result_vec.push_back(dc_result);
+        if (!ReportStep(++step_done, step_num, v, saved_node_vec, saved_result.memptr())) {
+            cout << "DC analysis stopped at " << v << endl;
+            completed = false;
+            break;
         }
-        dc_value_vec.push_back(v);
     }
-    dc_result = DcResult{dc_result_vec, dc_value_vec, reduced_node_vec};
+    if (factored)
+        PrintSolverSummary(factor);
+    PrintNewtonSummary(newton_stats);
+    PrintWaveformSummary(waveform);
+    dc_result = DcResult{waveform, saved_node_vec};
+    return completed;
 }
 
-void Analyzer::DoAcAnalysis(const AcAnalysis ac_analysis) {
+bool Analyzer::DoAcAnalysis(const AcAnalysis ac_analysis) {
     vector<double> scan_freq_vec;
 
     double f_start = ac_analysis.f_start;
@@ -131,9 +172,19 @@ void Analyzer::DoAcAnalysis(const AcAnalysis ac_analysis) {
         default: break;
     }
 
-    vector<arma::cx_vec> ac_result_vec;
+    // `.options acsolver=mixed` factors every frequency's matrix in single
+    // precision; the other solvers do not apply to the complex matrices
+    bool mixed = ReadSolverOptions().solver == MIXED_SOLVER;
+    MixedStats mixed_stats;
+
+    cx_mat ac_result_mat;
+    std::vector<NodeName> saved_node_vec;
+    arma::uvec saved_index;
+    RawWriter raw_writer;
+    bool completed = true;
 
-    for (auto f : scan_freq_vec) {
+    for (std::size_t k = 0; k < scan_freq_vec.size(); k++) {
+        double f = scan_freq_vec[k];
         AnalysisMatrix analysis_matrix = GetAnalysisMatrix(f);
         int node_num = analysis_matrix.node_vec.size();
 
@@ -147,24 +198,74 @@ void Analyzer::DoAcAnalysis(const AcAnalysis ac_analysis) {
 
         cx_mat reduced_rhs = analysis_matrix.rhs(span(1, node_num - 1), 0);
 
-        cx_vec ac_result = arma::solve(reduced_mat, reduced_rhs);
+        cx_vec ac_result;
+        MixedLu<complex<double>> mixed_lu;
+        if (mixed && mixed_lu.Factor(reduced_mat)) {
+            ac_result = mixed_lu.Solve(reduced_rhs.col(0));
+            mixed_stats.Add(mixed_lu.Stats());
+        } else {
+            ac_result = arma::solve(reduced_mat, reduced_rhs);
+        }
+
+        if (k == 0) {
+            saved_index = SavedIndex(reduced_node_vec, saved_node_vec);
+            ac_result_mat.set_size(scan_freq_vec.size(), saved_index.n_elem);
+            OpenRawFile(raw_writer, "AC Analysis", "frequency", "frequency",
+                        saved_node_vec, true);
+        }
 
-        ac_result_vec.push_back(ac_result);
+        cx_vec saved_result = ac_result.elem(saved_index);
+        raw_writer.AppendPoint(f, saved_result);
+        ac_result_mat.row(k) = saved_result.st();
+
+        if (!ReportStep(k + 1, scan_freq_vec.size(), f, saved_node_vec, nullptr)) {
+            cout << "AC analysis stopped at " << f << " Hz" << endl;
+            completed = false;
+            ac_result_mat.resize(k + 1, ac_result_mat.n_cols);
+            scan_freq_vec.resize(k + 1);
+            break;
+        }
     }
 
-    AnalysisMatrix analysis_matrix = GetAnalysisMatrix(0);
-    std::vector<NodeName> reduced_node_vec = analysis_matrix.node_vec;
-    std::vector<NodeName>::iterator h = reduced_node_vec.begin();
-    reduced_node_vec.erase(h);
+    PrintMixedSummary(mixed_stats);
+    ac_result = {ac_result_mat, scan_freq_vec, saved_node_vec};
+    return completed;
+}
 
-    ac_result = {ac_result_vec, scan_freq_vec, reduced_node_vec};
+/**
+ * @brief The DC matrices of the circuit. In incremental mode, if the circuit
+ * differs from the last run's in device values only, just the changed devices
+ * are restamped into the matrices kept from then.
+ *
+ * @return AnalysisMatrix
+ */
+AnalysisMatrix Analyzer::AssembleDc() {
+    if (!Incremental())
+        return GetAnalysisMatrix(0);
+
+    // DiffCircuit() does not see into macromodels, a reduced circuit is rebuilt
+    vector<DeviceName> changed_vec;
+    Circuit old_circuit;
+    if (session->analysis_type == DC && macromodel_vec.empty() &&
+        Flatten(*session->circuit, old_circuit) &&
+        DiffCircuit(old_circuit, *circuit, changed_vec)) {
+        RestampDc(session->dc_matrix, old_circuit, *circuit);
+        cout << "Incremental: " << changed_vec.size() << " devices changed" << endl;
+    } else {
+        cout << "Incremental: circuit changed, matrices rebuilt" << endl;
+        session->Clear();
+        session->analysis_type = DC;
+        session->dc_matrix = GetAnalysisMatrix(0);
+    }
+    session->circuit = parsed;
+    return session->dc_matrix;
 }
 
 AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
-    const double w = M_2_PI * frequency;  // w = 2 pi f
+    const double w = AngularFrequency(frequency);
 
     // ----- Generate NA metrix -----
-    int node_num = circuit.node_vec.size();
+    int node_num = circuit->node_vec.size();
     cx_mat NA_mat(node_num, node_num, arma::fill::zeros);
     std::vector<ExpTerm> exp_analysis_vec;
     std::vector<ExpTerm> exp_rhs_vec;
@@ -172,9 +273,9 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     cx_mat RHS(node_num, 1, arma::fill::zeros);
 
     // Add resistor stamps
-    for (Res res : circuit.res_vec) {
-        int node_1_index = FindNode(circuit.node_vec, res.node_1);
-        int node_2_index = FindNode(circuit.node_vec, res.node_2);
+    for (Res res : circuit->res_vec) {
+        int node_1_index = FindNode(circuit->node_vec, res.node_1);
+        int node_2_index = FindNode(circuit->node_vec, res.node_2);
         double conductance = 1 / res.value;
         NA_mat(node_1_index, node_1_index) += complex<double>(conductance, 0);
         NA_mat(node_1_index, node_2_index) += complex<double>(-1 * conductance, 0);
@@ -183,9 +284,9 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     }
 
     // Add capacitor stamps
-    for (Cap cap : circuit.cap_vec) {
-        int node_1_index = FindNode(circuit.node_vec, cap.node_1);
-        int node_2_index = FindNode(circuit.node_vec, cap.node_2);
+    for (Cap cap : circuit->cap_vec) {
+        int node_1_index = FindNode(circuit->node_vec, cap.node_1);
+        int node_2_index = FindNode(circuit->node_vec, cap.node_2);
         double value = cap.value * w;
         NA_mat(node_1_index, node_1_index) += complex<double>(0, value);
         NA_mat(node_1_index, node_2_index) += complex<double>(0, -1 * value);
@@ -194,9 +295,9 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     }
 
     // Add Current Source
-    for (Isrc isrc : circuit.isrc_vec) {
-        int node_1_index = FindNode(circuit.node_vec, isrc.node_1);
-        int node_2_index = FindNode(circuit.node_vec, isrc.node_2);
+    for (Isrc isrc : circuit->isrc_vec) {
+        int node_1_index = FindNode(circuit->node_vec, isrc.node_1);
+        int node_2_index = FindNode(circuit->node_vec, isrc.node_2);
         double value = isrc.value;
         // The current run from node_1 to node_2,
         // thus on the LHS, LHS(node_1) = -Ik => RHS(node_1) = +Ik.
@@ -206,11 +307,11 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     }
 
     // Add VCCS
-    for (VCCS vccs : circuit.vccs_vec) {
-        int node_1_index = FindNode(circuit.node_vec, vccs.node_1);
-        int node_2_index = FindNode(circuit.node_vec, vccs.node_2);
-        int ctrl_node_1_index = FindNode(circuit.node_vec, vccs.ctrl_node_1);
-        int ctrl_node_2_index = FindNode(circuit.node_vec, vccs.ctrl_node_2);
+    for (VCCS vccs : circuit->vccs_vec) {
+        int node_1_index = FindNode(circuit->node_vec, vccs.node_1);
+        int node_2_index = FindNode(circuit->node_vec, vccs.node_2);
+        int ctrl_node_1_index = FindNode(circuit->node_vec, vccs.ctrl_node_1);
+        int ctrl_node_2_index = FindNode(circuit->node_vec, vccs.ctrl_node_2);
         double value = vccs.value;
         NA_mat(node_1_index, ctrl_node_1_index) += complex<double>(value, 0);
         NA_mat(node_1_index, ctrl_node_2_index) += complex<double>(-1 * value, 0);
@@ -219,39 +320,47 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     }
 
     // Add diode
-    for (Diode diode : circuit.diode_vec) {
-        int node_1_index = FindNode(circuit.node_vec, diode.node_1);
-        int node_2_index = FindNode(circuit.node_vec, diode.node_2);
+    for (Diode diode : circuit->diode_vec) {
+        int node_1_index = FindNode(circuit->node_vec, diode.node_1);
+        int node_2_index = FindNode(circuit->node_vec, diode.node_2);
+        // i = i_sat (e^{40 x} - 1), g = di/dx = 40 i_sat e^{40 x}
+        double i_sat = DiodeSaturationCurrent(diode.model);
+        double g = 40 * i_sat;
         exp_analysis_vec.push_back(ExpTerm(node_1_index, node_1_index, node_1_index,
-                                           node_2_index, ExpCoeff(40, 40)));
+                                           node_2_index, ExpCoeff(g, 40)));
         exp_analysis_vec.push_back(ExpTerm(node_1_index, node_2_index, node_1_index,
-                                           node_2_index, ExpCoeff(-40, 40)));
+                                           node_2_index, ExpCoeff(-g, 40)));
         exp_analysis_vec.push_back(ExpTerm(node_2_index, node_1_index, node_1_index,
-                                           node_2_index, ExpCoeff(-40, 40)));
+                                           node_2_index, ExpCoeff(-g, 40)));
         exp_analysis_vec.push_back(ExpTerm(node_2_index, node_2_index, node_1_index,
-                                           node_2_index, ExpCoeff(40, 40)));
+                                           node_2_index, ExpCoeff(g, 40)));
 
         exp_rhs_vec.push_back(ExpTerm(node_1_index, node_1_index, node_2_index,
-                                      ExpCoeff(-1, 40, 1), ExpCoeff(40, 40)));
+                                      ExpCoeff(-i_sat, 40, i_sat), ExpCoeff(g, 40)));
         exp_rhs_vec.push_back(ExpTerm(node_2_index, node_1_index, node_2_index,
-                                      ExpCoeff(1, 40, -1), ExpCoeff(-40, 40)));
+                                      ExpCoeff(i_sat, 40, -i_sat), ExpCoeff(-g, 40)));
     }
 
     // ----- Generate MNA metrix -----
-    modified_node_vec = circuit.node_vec;
+    modified_node_vec = circuit->node_vec;
 
     // Every inducter contributes to one more branch node
-    for (Ind ind : circuit.ind_vec)
+    for (Ind ind : circuit->ind_vec)
         modified_node_vec.push_back("i_" + ind.name);
 
     // Every voltage source contributes to one more branch node
-    for (Vsrc vsrc : circuit.vsrc_vec)
+    for (Vsrc vsrc : circuit->vsrc_vec)
         modified_node_vec.push_back("i_" + vsrc.name);
 
     // Every VCVS contributes to one more branch node
-    for (VCVS vcvs : circuit.vcvs_vec)
+    for (VCVS vcvs : circuit->vcvs_vec)
         modified_node_vec.push_back("i_" + vcvs.name);
 
+    // Every macromodel state is one more unknown
+    for (auto& macromodel : macromodel_vec)
+        for (int k = 0; k < macromodel.state_num; k++)
+            modified_node_vec.push_back(macromodel.State(k));
+
     // Initialize MNA metrix
     int modified_node_num = modified_node_vec.size();
     cx_mat MNA_mat = NA_mat;
@@ -261,7 +370,7 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     RHS.resize(modified_node_num, 1);
 
     // Add inductor stamps
-    for (Ind ind : circuit.ind_vec) {
+    for (Ind ind : circuit->ind_vec) {
         int node_1_index = FindNode(modified_node_vec, ind.node_1);
         int node_2_index = FindNode(modified_node_vec, ind.node_2);
         double value = ind.value * w;
@@ -274,7 +383,7 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     }
 
     // Add voltage source stamps
-    for (Vsrc vsrc : circuit.vsrc_vec) {
+    for (Vsrc vsrc : circuit->vsrc_vec) {
         int node_1_index = FindNode(modified_node_vec, vsrc.node_1);
         int node_2_index = FindNode(modified_node_vec, vsrc.node_2);
         double value = vsrc.value;
@@ -288,7 +397,7 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
     }
 
     // Add VCVS
-    for (VCVS vcvs : circuit.vcvs_vec) {
+    for (VCVS vcvs : circuit->vcvs_vec) {
         int node_1_index = FindNode(modified_node_vec, vcvs.node_1);
         int node_2_index = FindNode(modified_node_vec, vcvs.node_2);
         int ctrl_node_1_index = FindNode(modified_node_vec, vcvs.ctrl_node_1);
@@ -303,7 +412,111 @@ AnalysisMatrix Analyzer::GetAnalysisMatrix(const double frequency) {
         MNA_mat(node_2_index, branch_index) += complex<double>(-1, 0);
     }
 
+    // Add macromodel stamps, G + jwC
+    for (auto& macromodel : macromodel_vec) {
+        vector<int> index_vec;
+        for (auto& port : macromodel.port_vec)
+            index_vec.push_back(FindNode(modified_node_vec, port));
+        for (int k = 0; k < macromodel.state_num; k++)
+            index_vec.push_back(FindNode(modified_node_vec, macromodel.State(k)));
+        for (std::size_t i = 0; i < index_vec.size(); i++)
+            for (std::size_t j = 0; j < index_vec.size(); j++)
+                MNA_mat(index_vec[i], index_vec[j]) +=
+                    complex<double>(macromodel.g(i, j), w * macromodel.c(i, j));
+    }
+
     AnalysisMatrix result_mat(MNA_mat, exp_analysis_vec, modified_node_vec, RHS,
                               exp_rhs_vec);
     return result_mat;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief The stamps of GetAnalysisMatrix(0) for a linear circuit, assembled
+ * into CSC with ground removed, for the sparse solvers
+ *
+ * @param circuit flat, without diodes
+ * @param macromodel_vec
+ * @return SparseSystem
+ */
+SparseSystem SparseDc(const Circuit& circuit, const vector<Macromodel>& macromodel_vec) {
+    SparseStamper stamper(circuit.node_vec);
+    for (Ind ind : circuit.ind_vec)
+        stamper.AddUnknown("i_" + ind.name);
+    for (Vsrc vsrc : circuit.vsrc_vec)
+        stamper.AddUnknown("i_" + vsrc.name);
+    for (VCVS vcvs : circuit.vcvs_vec)
+        stamper.AddUnknown("i_" + vcvs.name);
+    for (auto& macromodel : macromodel_vec)
+        for (int k = 0; k < macromodel.state_num; k++)
+            stamper.AddUnknown(macromodel.State(k));
+
+    SparseSystem system;
+    system.rhs.zeros(stamper.node_vec.size());
+    auto add_rhs = [&](const int index, const double value) {
+        if (index >= 0)
+            system.rhs(index) += value;
+    };
+    // The current of a branch unknown, from node_1 to node_2
+    auto add_branch = [&](const int branch_index, const NodeName node_1,
+                          const NodeName node_2) {
+        int node_1_index = stamper.Index(node_1);
+        int node_2_index = stamper.Index(node_2);
+        stamper.Add(branch_index, node_1_index, 1);
+        stamper.Add(branch_index, node_2_index, -1);
+        stamper.Add(node_1_index, branch_index, 1);
+        stamper.Add(node_2_index, branch_index, -1);
+    };
+
+    // Capacitors are open at DC, inductors short
+    for (Res res : circuit.res_vec)
+        stamper.AddConductance(stamper.Index(res.node_1), stamper.Index(res.node_2),
+                               1 / res.value);
+
+    for (Isrc isrc : circuit.isrc_vec) {
+        add_rhs(stamper.Index(isrc.node_1), isrc.value);
+        add_rhs(stamper.Index(isrc.node_2), -isrc.value);
+    }
+
+    for (VCCS vccs : circuit.vccs_vec) {
+        int node_1_index = stamper.Index(vccs.node_1);
+        int node_2_index = stamper.Index(vccs.node_2);
+        int ctrl_node_1_index = stamper.Index(vccs.ctrl_node_1);
+        int ctrl_node_2_index = stamper.Index(vccs.ctrl_node_2);
+        stamper.Add(node_1_index, ctrl_node_1_index, vccs.value);
+        stamper.Add(node_1_index, ctrl_node_2_index, -vccs.value);
+        stamper.Add(node_2_index, ctrl_node_1_index, -vccs.value);
+        stamper.Add(node_2_index, ctrl_node_2_index, vccs.value);
+    }
+
+    for (Ind ind : circuit.ind_vec)
+        add_branch(stamper.Index("i_" + ind.name), ind.node_1, ind.node_2);
+
+    for (Vsrc vsrc : circuit.vsrc_vec) {
+        int branch_index = stamper.Index("i_" + vsrc.name);
+        add_branch(branch_index, vsrc.node_1, vsrc.node_2);
+        add_rhs(branch_index, vsrc.value);
+    }
+
+    for (VCVS vcvs : circuit.vcvs_vec) {
+        int branch_index = stamper.Index("i_" + vcvs.name);
+        add_branch(branch_index, vcvs.node_1, vcvs.node_2);
+        stamper.Add(branch_index, stamper.Index(vcvs.ctrl_node_1), -vcvs.value);
+        stamper.Add(branch_index, stamper.Index(vcvs.ctrl_node_2), vcvs.value);
+    }
+
+    // Macromodels, G
+    for (auto& macromodel : macromodel_vec) {
+        vector<int> index_vec;
+        for (auto& port : macromodel.port_vec)
+            index_vec.push_back(stamper.Index(port));
+        for (int k = 0; k < macromodel.state_num; k++)
+            index_vec.push_back(stamper.Index(macromodel.State(k)));
+        for (std::size_t i = 0; i < index_vec.size(); i++)
+            for (std::size_t j = 0; j < index_vec.size(); j++)
+                stamper.Add(index_vec[i], index_vec[j], macromodel.g(i, j));
+    }
+
+    system.matrix = stamper.Matrix();
+    system.node_vec = stamper.node_vec;
+    return system;
+}
@@ -10,58 +10,193 @@
 
 #include <armadillo>
 #include <cmath>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "../parser/parser.h"
 #include "../utils/utils.h"
 #include "analyzer_type.h"
+#include "incremental.h"
+#include "plot_lod.h"
 #include "qcustomplot.h"
+#include "raw_writer.h"
+#include "result_cache.h"
 
 int FindNode(std::vector<NodeName> node_vec, NodeName name);
 
-void DcPlot(DcResult result, std::vector<PrintVariable> print_variable_vec);
-void AcPlot(AcResult result, std::vector<PrintVariable> print_variable_vec);
-void TranPlot(TranResult result, std::vector<PrintVariable> print_variable_vec);
-void Plot(std::vector<QVector<double>> x_vec, std::vector<QVector<double>> y_vec,
-          std::vector<NodeName> name_vec, QString x_label, QString y_label, bool x_log,
-          bool y_log);
+void DcLods(const DcResult& result, const std::vector<PrintVariable>& print_variable_vec,
+            const QString suffix, std::vector<PlotLod>& lod_vec,
+            std::vector<NodeName>& name_vec);
+void AcLods(const AcResult& result, const std::vector<PrintVariable>& print_variable_vec,
+            const QString suffix, std::vector<PlotLod>& lod_vec,
+            std::vector<NodeName>& name_vec);
+void TranLods(const TranResult& result,
+              const std::vector<PrintVariable>& print_variable_vec, const QString suffix,
+              std::vector<PlotLod>& lod_vec, std::vector<NodeName>& name_vec);
+void McLods(const McResult& result, const std::vector<PrintVariable>& print_variable_vec,
+            const QString suffix, std::vector<PlotLod>& lod_vec,
+            std::vector<NodeName>& name_vec);
+void PrintMcSummary(const arma::mat& sample_mat, const std::vector<NodeName>& node_vec);
+void PrintMixedSummary(const MixedStats& stats);
+void Plot(std::vector<PlotLod> lod_vec, std::vector<NodeName> name_vec, QString x_label,
+          QString y_label, bool x_log, bool y_log);
 
 arma::mat AddExpTerm(const std::vector<ExpTerm> exp_term_vec, const arma::vec result,
                      arma::mat mat);
 
 double VecDifference(arma::vec vec_old, arma::vec vec_new);
 
+// Newton iterations of one nonlinear solve, see `.options newtoniter=...`
+const int NEWTON_MAX_ITERATIONS = 100;
+
+struct NewtonStats {
+    long long solve_num = 0;
+    long long iteration_num = 0;
+    long long limited_num = 0;  // Steps damped by junction limiting
+    int failed_num = 0;
+};
+
+double DiodeSaturationCurrent(const ModelName model);
+double LimitJunction(const double v_new, const double v_old, const double vt,
+                     const double v_crit);
+bool NewtonSolve(const arma::mat& linear_mat, const std::vector<ExpTerm>& exp_analysis_vec,
+                 const arma::mat& linear_rhs, const std::vector<ExpTerm>& exp_rhs_vec,
+                 const int max_iterations, arma::vec& result, NewtonStats& stats);
+void PrintNewtonSummary(const NewtonStats& stats);
+
+// Linear DC / TRAN systems assembled straight into CSC, see SparseStamper
+SparseSystem SparseDc(const Circuit& circuit,
+                      const std::vector<Macromodel>& macromodel_vec);
+SparseSystem SparseBackEuler(const Circuit& circuit,
+                             const std::vector<Macromodel>& macromodel_vec,
+                             const double h);
+
+std::vector<Macromodel> ReduceCircuit(Circuit& circuit, const std::vector<NodeName>& keep_vec,
+                                      const std::vector<double>& s_vec, const int order);
+
+// w = 2 pi f of a frequency in Hz; AC stamps and PRIMA expansion points
+inline double AngularFrequency(const double frequency) { return 2 * M_PI * frequency; }
+
 const double EPSILON_ABS = 1e-5;
 const double EPSILON_REL = 1e-1;
 
+/**
+ * @brief One solved sweep point / frequency / time step, as reported while the
+ * analysis runs
+ */
+struct AnalysisStep {
+    int step;  // 1 based
+    int step_num;
+    double x;                               // Sweep value, frequency or time
+    const std::vector<NodeName>* node_vec;  // Saved signals
+    const double* value;                    // Saved values, nullptr for AC
+};
+
+// Called after every step; returning false stops the analysis there.
+typedef std::function<bool(const AnalysisStep& step)> StepCallback;
+
 class Analyzer {
   public:
     Analyzer() {}
     Analyzer(Parser parser);
     ~Analyzer() {}
 
+    bool Run(StepCallback callback = StepCallback());
+    void ShowPlots();
+    void CollectPlots(const QString suffix, std::vector<PlotLod>& lod_vec,
+                      std::vector<NodeName>& name_vec);
+    void PlotAxes(QString& x_label, bool& x_log);
+
+    bool CanStep(const StepAnalysis& step_analysis) const;
+    bool ApplyStep(const StepAnalysis& step_analysis, const int index);
+
+    // Set an option the deck leaves unset, e.g. for every step of a sweep
+    void DefaultOption(const QString key, const QString value) {
+        options.insert({key, value});
+    }
+
+    // Keep matrices and factors across runs, see `.options incremental=1`
+    void SetSession(IncrementalSession* session) { this->session = session; }
+
     std::vector<AnalysisMatrix> GetAnalysisResults() { return analysis_matrix_vec; }
 
     void PrintMatrix(arma::cx_mat mat, std::vector<NodeName> nodes);
     void PrintRHS(arma::cx_mat rhs, std::vector<NodeName> nodes);
 
   private:
-    Circuit circuit;
+    // As parsed, one copy per subckt definition; shared by the copies of an
+    // analyzer, e.g. the steps of a sweep, until one of them changes it
+    std::shared_ptr<const Circuit> parsed;
+    DeviceName step_device;  // Set to step_value once flattened, see ApplyStep()
+    double step_value = 0;
+
+    // Flattened from `parsed` by Run() and released once the matrices are
+    // assembled (AC assembles them at every frequency and keeps it to the end)
+    std::shared_ptr<const Circuit> circuit;
+    bool Flatten(const Circuit& hierarchy, Circuit& flat) const;
+    void ReleaseCircuit() { circuit.reset(); }
     std::vector<NodeName> modified_node_vec;
 
+    // `.options reduce=prima`, see ReduceNetworks()
+    std::vector<Macromodel> macromodel_vec;
+    void ReduceNetworks();
+
+    QString title;
+    SimulationOptions options;
+    std::vector<PrintVariable> print_variable_vec;
+
+    AnalysisType analysis_type = NONE;
+    DcAnalysis dc_analysis;
+    AcAnalysis ac_analysis;
+    TranAnalysis tran_analysis;
+    McAnalysis mc_analysis;
+
+    StepCallback step_callback;
+    bool RunCached();
+    bool RunAnalysis();
+    bool ReportStep(const int step, const int step_num, const double x,
+                    const std::vector<NodeName>& node_vec, const double* value);
+
+    arma::uvec SavedIndex(const std::vector<NodeName> node_vec,
+                          std::vector<NodeName>& saved_node_vec);
+    WaveformStore NewWaveformStore(const std::vector<NodeName> saved_node_vec);
+    void PrintWaveformSummary(const WaveformStore& waveform);
+
     std::vector<AnalysisMatrix> analysis_matrix_vec;
 
+    IncrementalSession* session = nullptr;
+    bool Incremental();
+    AnalysisMatrix AssembleDc();
+    TranAnalysisMat AssembleTran(const double h);
+    SolverOptions ReadSolverOptions();
+    bool SparseAssembly();
+    bool PrepareFactor(FactorCache& factor, const arma::mat& matrix);
+    bool PrepareFactor(FactorCache& factor, const CscMatrix& matrix);
+    void PrintSolverSummary(const FactorCache& factor);
+
+    // `.options resultcache=<dir>`, see ResultCache
+    QByteArray ResultKey();
+    CachedResult CacheEntry(const double seconds);
+    bool ServeCached(const CachedResult& cached);
+
     TranResult tran_result;
     DcResult dc_result;
     AcResult ac_result;
+    McResult mc_result;
 
-    void DoDcAnalysis(const DcAnalysis dc_analysis);
-    void DoAcAnalysis(const AcAnalysis ac_analysis);
-    void DoTranAnalysis(const TranAnalysis tran_analysis);
+    bool DoDcAnalysis(const DcAnalysis dc_analysis);
+    bool DoAcAnalysis(const AcAnalysis ac_analysis);
+    bool DoTranAnalysis(const TranAnalysis tran_analysis);
+    bool DoMcAnalysis(const McAnalysis mc_analysis);
 
     AnalysisMatrix GetAnalysisMatrix(const double frequency);
+
+    bool OpenRawFile(RawWriter& raw_writer, const QString plot_name, const QString x_name,
+                     const QString x_type, const std::vector<NodeName> node_vec,
+                     const bool complex);
 };
 
 #endif  // ANALYZER_H
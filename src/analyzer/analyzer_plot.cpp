@@ -5,63 +5,100 @@
  * @date 2022-10-28
  */
 
+#include <algorithm>
+#include <memory>
+
 #include "analyzer.h"
 
 using std::complex;
 
-void DcPlot(DcResult result, std::vector<PrintVariable> print_variable_vec) {
-    std::vector<QVector<double>> x_vec, y_vec;
-    std::vector<NodeName> name_vec;
+// Points handed to QCustomPlot per pixel of the plot width
+const int LOD_POINTS_PER_PIXEL = 2;
 
+/**
+ * @brief Level of detail for a signal of a waveform store. The pyramid is built
+ * from the decoded view in place; full resolution windows are decoded from the
+ * store on demand.
+ */
+PlotLod WaveformLod(WaveformView& view, const int signal) {
+    std::shared_ptr<const WaveformStore> waveform = view.Store();
+    return PlotLod(view.X(), view.Signal(signal),
+                   [waveform, signal](double x_from, double x_to, std::vector<double>& x_vec,
+                                      std::vector<double>& y_vec) {
+                       waveform->ReadWindow(signal, x_from, x_to, x_vec, y_vec);
+                   });
+}
+
+/**
+ * @brief Level of detail for data already in memory, x is shared by every
+ * signal of the result
+ */
+PlotLod VectorLod(std::shared_ptr<const std::vector<double>> x,
+                  std::shared_ptr<const std::vector<double>> y) {
+    return PlotLod(*x, *y,
+                   [x, y](double x_from, double x_to, std::vector<double>& x_vec,
+                          std::vector<double>& y_vec) {
+                       if (x->size() != y->size())
+                           return;
+                       std::size_t first =
+                           std::lower_bound(x->begin(), x->end(), x_from) - x->begin();
+                       std::size_t last =
+                           std::upper_bound(x->begin(), x->end(), x_to) - x->begin();
+                       x_vec.assign(x->begin() + first, x->begin() + last);
+                       y_vec.assign(y->begin() + first, y->begin() + last);
+                   });
+}
+
+/**
+ * @brief Add the probes of a result to a plot; `suffix` tells the curves of
+ * different runs apart. Same for AcLods(), TranLods() and McLods().
+ */
+void DcLods(const DcResult& result, const std::vector<PrintVariable>& print_variable_vec,
+            const QString suffix, std::vector<PlotLod>& lod_vec,
+            std::vector<NodeName>& name_vec) {
+    WaveformView view(std::make_shared<const WaveformStore>(result.waveform));
     for (auto print_variable : print_variable_vec) {
         NodeName node = print_variable.node;
         int node_index = FindNode(result.node_vec, node);
-        QVector<double> x;
-        for (auto dc_value : result.dc_value_vec)
-            x.push_back(dc_value);
-
-        QVector<double> y;
-        for (auto dc_result : result.dc_result_vec)
-            y.push_back(dc_result(node_index));
+        if (node_index < 0)
+            continue;
 
-        x_vec.push_back(x);
-        y_vec.push_back(y);
-        name_vec.push_back(node);
+        lod_vec.push_back(WaveformLod(view, node_index));
+        name_vec.push_back(node + suffix);
     }
-
-    Plot(x_vec, y_vec, name_vec, QString("Vsrc"), QString("Value"), false, false);
 }
 
-void AcPlot(AcResult result, std::vector<PrintVariable> print_variable_vec) {
-    std::vector<QVector<double>> x_vec, y_vec;
-    std::vector<NodeName> name_vec;
-
+void AcLods(const AcResult& result, const std::vector<PrintVariable>& print_variable_vec,
+            const QString suffix, std::vector<PlotLod>& lod_vec,
+            std::vector<NodeName>& name_vec) {
+    auto freq = std::make_shared<const std::vector<double>>(result.freq_vec);
     for (auto print_variable : print_variable_vec) {
         NodeName node = print_variable.node;
         int node_index = FindNode(result.node_vec, node);
+        if (node_index < 0)
+            continue;
 
-        QVector<double> freq;
-        for (auto f : result.freq_vec)
-            freq.push_back(f);
+        // Samples of one signal are contiguous
+        const complex<double>* signal = result.ac_result_mat.colptr(node_index);
 
-        QVector<double> y;
-        for (auto ac_result : result.ac_result_vec) {
-            complex<double> r = ac_result(node_index);
+        auto y = std::make_shared<std::vector<double>>();
+        for (std::size_t k = 0; k < freq->size(); k++) {
+            complex<double> r = signal[k];
             switch (print_variable.analysis_variable_type) {
                 case MAG: {
-                    y.push_back(sqrt(pow(r.real(), 2) + pow(r.imag(), 2)));
+                    y->push_back(sqrt(pow(r.real(), 2) + pow(r.imag(), 2)));
                     break;
                 }
                 case REAL: {
-                    y.push_back(r.real());
+                    y->push_back(r.real());
                     break;
                 }
                 case IMAGINE: {
-                    y.push_back(r.imag());
+                    y->push_back(r.imag());
                     break;
                 }
                 case PHASE: {
-                    y.push_back(atan(r.imag() / r.real()));
+                    y->push_back(atan(r.imag() / r.real()));
                     break;
                 }
                 case DB: {
@@ -70,56 +107,91 @@ void AcPlot(AcResult result, std::vector<PrintVariable> print_variable_vec) {
                 }
             }
         }
-        x_vec.push_back(freq);
-        y_vec.push_back(y);
-        name_vec.push_back(node);
+        lod_vec.push_back(VectorLod(freq, y));
+        name_vec.push_back(node + suffix);
     }
-
-    Plot(x_vec, y_vec, name_vec, QString("Frequency"), QString("Value"), true, false);
 }
 
-void TranPlot(TranResult result, std::vector<PrintVariable> print_variable_vec) {
-    std::vector<QVector<double>> x_vec, y_vec;
-    std::vector<NodeName> name_vec;
+void TranLods(const TranResult& result,
+              const std::vector<PrintVariable>& print_variable_vec, const QString suffix,
+              std::vector<PlotLod>& lod_vec, std::vector<NodeName>& name_vec) {
+    WaveformView view(std::make_shared<const WaveformStore>(result.waveform));
+    for (auto print_variable : print_variable_vec) {
+        NodeName node = print_variable.node;
+        int node_index = FindNode(result.node_vec, node);
+        if (node_index < 0)
+            continue;
 
+        lod_vec.push_back(WaveformLod(view, node_index));
+        name_vec.push_back(node + suffix);
+    }
+}
+
+/**
+ * @brief Distribution of every probe over the Monte Carlo samples: the sorted
+ * values against their cumulative probability
+ */
+void McLods(const McResult& result, const std::vector<PrintVariable>& print_variable_vec,
+            const QString suffix, std::vector<PlotLod>& lod_vec,
+            std::vector<NodeName>& name_vec) {
     for (auto print_variable : print_variable_vec) {
         NodeName node = print_variable.node;
         int node_index = FindNode(result.node_vec, node);
+        if (node_index < 0)
+            continue;
 
-        QVector<double> t;
-        for (auto t_p : result.time_point_vec)
-            t.push_back(t_p);
+        arma::vec value = result.sample_mat.col(node_index);
+        value = arma::sort(value.elem(arma::find_finite(value)));
 
-        QVector<double> y;
-        for (int i = 0; i < result.tran_result_mat.n_cols; i++)
-            y.push_back(result.tran_result_mat(node_index, i));
+        auto x = std::make_shared<std::vector<double>>();
+        for (arma::uword k = 0; k < value.n_elem; k++)
+            x->push_back((k + 0.5) / value.n_elem);
+        auto y = std::make_shared<const std::vector<double>>(
+            arma::conv_to<std::vector<double>>::from(value));
 
-        x_vec.push_back(t);
-        y_vec.push_back(y);
-        name_vec.push_back(node);
+        lod_vec.push_back(VectorLod(x, y));
+        name_vec.push_back(node + suffix);
     }
-
-    Plot(x_vec, y_vec, name_vec, QString("Time"), QString("Value"), false, false);
 }
 
 // Plot with x and y
-void Plot(std::vector<QVector<double>> x_vec, std::vector<QVector<double>> y_vec,
-          std::vector<NodeName> name_vec, QString x_label, QString y_label, bool x_log,
-          bool y_log) {
+void Plot(std::vector<PlotLod> lod_vec, std::vector<NodeName> name_vec, QString x_label,
+          QString y_label, bool x_log, bool y_log) {
     QCustomPlot* plot = new QCustomPlot();
 
-    int plot_num = x_vec.size();
+    int plot_num = lod_vec.size();
 
     std::vector<QPen> pens = {QPen(Qt::blue), QPen(Qt::red), QPen(Qt::darkYellow)};
 
     for (int i = 0; i < plot_num; i++) {
         plot->addGraph(plot->xAxis, plot->yAxis);
-        plot->graph(i)->setPen(pens[i]);
+        // More curves than pens (stepped runs): spread them over the hues
+        if (plot_num <= static_cast<int>(pens.size()))
+            plot->graph(i)->setPen(pens[i]);
+        else
+            plot->graph(i)->setPen(QPen(QColor::fromHsv(i * 300 / plot_num, 255, 200)));
         plot->graph(i)->setLineStyle(QCPGraph::lsLine);
-        plot->graph(i)->setData(x_vec[i], y_vec[i]);
         plot->graph(i)->setName(name_vec[i]);
     }
 
+    // QCustomPlot only gets a screen resolution number of points, picked again
+    // from the pyramids whenever the visible range changes.
+    auto lods = std::make_shared<std::vector<PlotLod>>(lod_vec);
+    auto update_data = [plot, lods](const QCPRange& range) {
+        std::size_t max_points =
+            LOD_POINTS_PER_PIXEL * std::max(plot->axisRect()->width(), 450);
+        std::vector<double> x, y;
+        for (std::size_t i = 0; i < lods->size(); i++) {
+            (*lods)[i].Select(range.lower, range.upper, max_points, x, y);
+            plot->graph(i)->setData(QVector<double>::fromStdVector(x),
+                                    QVector<double>::fromStdVector(y), true);
+        }
+    };
+    update_data(QCPRange(-HUGE_VAL, HUGE_VAL));
+    QObject::connect(plot->xAxis,
+                     QOverload<const QCPRange&>::of(&QCPAxis::rangeChanged), plot,
+                     update_data);
+
     plot->legend->setVisible(true);
 
     if (x_log) {
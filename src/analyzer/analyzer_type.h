@@ -8,11 +8,14 @@
 #ifndef ANALYZER_TYPE_H
 #define ANALYZER_TYPE_H
 
+#include <QHash>
 #include <armadillo>
 #include <iostream>
 #include <vector>
 
 #include "../parser/parser.h"
+#include "../solver/sparse_matrix.h"
+#include "waveform_store.h"
 
 struct ExpCoeff {
     std::complex<double> exp;
@@ -93,9 +96,22 @@ struct AnalysisMatrix {
           exp_rhs_vec(exp_rhs_vec) {}
 };
 
+// A linear RLC network reduced to its ports, see ReduceCircuit(). Stamps
+// g + s c over the port nodes and `state_num` unknowns of its own, x_<name>_k.
+struct Macromodel {
+    QString name;
+    std::vector<NodeName> port_vec;
+    int state_num;
+    int internal_num;  // Nodes of the network it replaces
+    arma::mat g;       // Ports first, then the states
+    arma::mat c;
+
+    NodeName State(const int k) const { return QString("x_%1_%2").arg(name).arg(k); }
+};
+
+// Signal i of `waveform` is node_vec[i], the x axis is the time.
 struct TranResult {
-    arma::mat tran_result_mat;
-    std::vector<double> time_point_vec;
+    WaveformStore waveform;
     std::vector<NodeName> node_vec;
 };
 
@@ -117,16 +133,74 @@ struct TranAnalysisMat {
           exp_rhs_vec(exp_rhs_vec) {}
 };
 
+/**
+ * @brief A linear DC / TRAN system assembled straight into CSC for the sparse
+ * solvers, ground removed; the dense n x n MNA is never built.
+ */
+struct SparseSystem {
+    CscMatrix matrix;
+    arma::vec rhs;      // DC: the sources
+    CscMatrix rhs_gen;  // TRAN: RHS = rhs_gen x(t - h), plus the sources
+    std::vector<NodeName> node_vec;
+};
+
+/**
+ * @brief Collects stamps as triplets. Unknowns are numbered as the dense
+ * engines number them once ground is removed, and looked up in a hash rather
+ * than with FindNode(); stamps on ground are dropped.
+ */
+struct SparseStamper {
+    std::vector<NodeName> node_vec;
+    QHash<NodeName, int> index_map;
+    std::vector<Triplet> triplet_vec;
+
+    // circuit_node_vec[0] is ground, as in the dense engines
+    SparseStamper(const std::vector<NodeName>& circuit_node_vec) {
+        for (std::size_t i = 1; i < circuit_node_vec.size(); i++)
+            AddUnknown(circuit_node_vec[i]);
+    }
+
+    void AddUnknown(const NodeName name) {
+        index_map.insert(name, node_vec.size());
+        node_vec.push_back(name);
+    }
+    int Index(const NodeName name) const { return index_map.value(name, -1); }
+
+    void Add(const int row, const int col, const double value) {
+        if (row >= 0 && col >= 0)
+            triplet_vec.push_back(Triplet{row, col, value});
+    }
+    // A conductance between two nodes
+    void AddConductance(const int node_1, const int node_2, const double g) {
+        Add(node_1, node_1, g);
+        Add(node_1, node_2, -g);
+        Add(node_2, node_1, -g);
+        Add(node_2, node_2, g);
+    }
+
+    CscMatrix Matrix() const {
+        return FromTriplets(node_vec.size(), node_vec.size(), triplet_vec);
+    }
+};
+
+// Signal i of `waveform` is node_vec[i], the x axis is the source value.
 struct DcResult {
-    std::vector<arma::vec> dc_result_vec;
-    std::vector<double> dc_value_vec;
+    WaveformStore waveform;
     std::vector<NodeName> node_vec;
 };
 
+// One column per signal (node_vec[i]) and one row per frequency, so the
+// samples of a signal are contiguous: ac_result_mat.colptr(i).
 struct AcResult {
-    std::vector<arma::cx_vec> ac_result_vec;
+    arma::cx_mat ac_result_mat;
     std::vector<double> freq_vec;
     std::vector<NodeName> node_vec;
 };
 
+// One row per sample and one column per signal (node_vec[i]).
+struct McResult {
+    arma::mat sample_mat;
+    std::vector<NodeName> node_vec;
+};
+
 #endif  // ANALYZER_TYPE_H
\ No newline at end of file
@@ -7,6 +7,13 @@
 
 #include "analyzer.h"
 
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <algorithm>
+
+#include "../solver/prima.h"
+
 using arma::cx_mat;
 using std::cout;
 using std::endl;
@@ -14,40 +21,533 @@ using std::setw;
 using std::vector;
 
 Analyzer::Analyzer(Parser parser) {
-    circuit = parser.GetCircuit();
+    // The hierarchy is only elaborated by Run(), see Flatten()
+    parsed = std::make_shared<const Circuit>(parser.GetCircuit());
 
-    auto analysis_type = parser.GetAnalysisType();
-    auto dc_analysis = parser.GetDcAnalysis();
-    auto ac_analysis = parser.GetAcAnalysis();
-    auto tran_analysis = parser.GetTranAnalysis();
-    auto print_variable_vec = parser.GetPrintVariables();
+    analysis_type = parser.GetAnalysisType();
+    dc_analysis = parser.GetDcAnalysis();
+    ac_analysis = parser.GetAcAnalysis();
+    tran_analysis = parser.GetTranAnalysis();
+    mc_analysis = parser.GetMcAnalysis();
+    print_variable_vec = parser.GetPrintVariables();
+    title = parser.GetTitle();
+    options = parser.GetOptions();
+}
+
+/**
+ * @brief Run the analysis of the deck. May run on a worker thread; nothing
+ * here touches the GUI. With `.options resultcache=<dir>`, a run whose circuit
+ * and analysis are in the cache is served from there instead.
+ *
+ * @param callback called after every step, see AnalysisStep
+ * @return true : Completed
+ * @return false : Stopped by the callback, the results hold the steps so far, or
+ * the circuit could not be flattened or analyzed
+ */
+bool Analyzer::Run(StepCallback callback) {
+    step_callback = callback;
+    Circuit flat;
+    if (!Flatten(*parsed, flat)) {
+        cout << "Error: the subckt hierarchy could not be flattened, nothing simulated"
+             << endl;
+        return false;
+    }
+    circuit = std::make_shared<const Circuit>(std::move(flat));
+    bool completed = RunCached();
+    ReleaseCircuit();
+    return completed;
+}
+
+/**
+ * @brief Run() on the flat circuit: serve the run from the result cache, or
+ * run it and store it there
+ */
+bool Analyzer::RunCached() {
+    QString cache_dir = GetOption(options, "resultcache");
+    bool cacheable = analysis_type == DC || analysis_type == AC || analysis_type == TRAN ||
+                     analysis_type == MC;
+    if (cache_dir.isEmpty() || !cacheable)
+        return RunAnalysis();
+
+    ResultCache cache(cache_dir,
+                      GetOptionValue(options, "resultcachemb", DEFAULT_RESULT_CACHE_MB));
+    QByteArray key = ResultKey();
+    CachedResult cached;
+    bool completed;
+    if (cache.Load(key, cached)) {
+        cout << "Result cache hit, serving " << cached.x_vec.size() << " cached points" << endl;
+        completed = ServeCached(cached);
+    } else {
+        QElapsedTimer timer;
+        timer.start();
+        completed = RunAnalysis();
+        // A stopped run only holds part of the points, keep it out of the cache
+        if (completed)
+            cache.Store(key, CacheEntry(timer.elapsed() / 1000.0));
+    }
+    cache.PrintStats();
+    return completed;
+}
+
+bool Analyzer::RunAnalysis() {
+    if (analysis_type == DC || analysis_type == AC || analysis_type == TRAN)
+        ReduceNetworks();
 
     switch (analysis_type) {
         case DC: {
             cout << "Running DC analysis" << endl;
-            DoDcAnalysis(dc_analysis);
-            if (!print_variable_vec.empty())
-                DcPlot(dc_result, print_variable_vec);
-            break;
+            return DoDcAnalysis(dc_analysis);
         }
         case AC: {
             cout << "Running AC analysis" << endl;
-            DoAcAnalysis(ac_analysis);
-            if (!print_variable_vec.empty())
-                AcPlot(ac_result, print_variable_vec);
-            break;
+            return DoAcAnalysis(ac_analysis);
         }
         case TRAN: {
             cout << "Running TRAN analysis" << endl;
-            DoTranAnalysis(tran_analysis);
-            if (!print_variable_vec.empty())
-                TranPlot(tran_result, print_variable_vec);
-            break;
+            return DoTranAnalysis(tran_analysis);
+        }
+        case MC: {
+            cout << "Running Monte Carlo analysis" << endl;
+            return DoMcAnalysis(mc_analysis);
         }
+        default: return true;
+    }
+}
+
+/**
+ * @brief `.options reduce=prima` replaces the RLC networks of the circuit by
+ * macromodels of their ports (ReduceCircuit()). They match the networks at
+ * DC and, with `reducefreq=...`, around that frequency too, `reduceorder=...`
+ * block moments at each. A network without a DC path from its internal
+ * nodes to its ports (one joined to them by capacitors only) is singular at
+ * DC; that point is skipped, so its model matches it only around
+ * `reducefreq=...`, and it is kept whole without one. Probed nodes stay in
+ * the circuit; the other nodes of the networks are gone from the results,
+ * `save=all` included.
+ */
+void Analyzer::ReduceNetworks() {
+    QString method = GetOption(options, "reduce", "none").toLower();
+    if (method == "none" || method == "0")
+        return;
+    if (method != "prima") {
+        cout << "Unknown reduce " << method << ", circuit not reduced" << endl;
+        return;
+    }
+
+    vector<NodeName> keep_vec;
+    for (auto print_variable : print_variable_vec)
+        keep_vec.push_back(print_variable.node);
+
+    vector<double> s_vec = {0};
+    double frequency = GetOptionValue(options, "reducefreq", 0);
+    if (frequency > 0)
+        s_vec.push_back(AngularFrequency(frequency));
+    int order = std::max(1.0, GetOptionValue(options, "reduceorder", DEFAULT_PRIMA_ORDER));
+
+    Circuit reduced = *circuit;
+    macromodel_vec = ReduceCircuit(reduced, keep_vec, s_vec, order);
+    circuit = std::make_shared<const Circuit>(std::move(reduced));
+    int internal_num = 0;
+    int state_num = 0;
+    for (auto& macromodel : macromodel_vec) {
+        internal_num += macromodel.internal_num;
+        state_num += macromodel.state_num;
+    }
+    cout << "PRIMA: " << internal_num << " internal nodes of " << macromodel_vec.size()
+         << " networks reduced to " << state_num << " states" << endl;
+}
+
+/**
+ * @brief Plot the probes of the last run. Must be called on the GUI thread.
+ */
+void Analyzer::ShowPlots() {
+    std::vector<PlotLod> lod_vec;
+    std::vector<NodeName> name_vec;
+    CollectPlots(QString(), lod_vec, name_vec);
+    if (lod_vec.empty())
+        return;
+
+    QString x_label;
+    bool x_log;
+    PlotAxes(x_label, x_log);
+    Plot(lod_vec, name_vec, x_label, QString("Value"), x_log, false);
+}
+
+/**
+ * @brief Add the probes of the last run to a plot
+ *
+ * @param suffix appended to the curve names
+ * @param lod_vec
+ * @param name_vec
+ */
+void Analyzer::CollectPlots(const QString suffix, std::vector<PlotLod>& lod_vec,
+                            std::vector<NodeName>& name_vec) {
+    if (print_variable_vec.empty())
+        return;
+
+    switch (analysis_type) {
+        case DC: DcLods(dc_result, print_variable_vec, suffix, lod_vec, name_vec); break;
+        case AC: AcLods(ac_result, print_variable_vec, suffix, lod_vec, name_vec); break;
+        case TRAN:
+            TranLods(tran_result, print_variable_vec, suffix, lod_vec, name_vec);
+            break;
+        case MC: McLods(mc_result, print_variable_vec, suffix, lod_vec, name_vec); break;
         default: break;
     }
 }
 
+void Analyzer::PlotAxes(QString& x_label, bool& x_log) {
+    x_log = analysis_type == AC;
+    switch (analysis_type) {
+        case DC: x_label = "Vsrc"; break;
+        case AC: x_label = "Frequency"; break;
+        case TRAN: x_label = "Time"; break;
+        case MC: x_label = "Cumulative probability"; break;
+        default: x_label = QString(); break;
+    }
+}
+
+template <typename T>
+bool SetDeviceValue(std::vector<T>& device_vec, const DeviceName name, const double value) {
+    for (auto& device : device_vec) {
+        if (device.name == name) {
+            device.value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+bool HasDevice(const std::vector<T>& device_vec, const DeviceName name) {
+    for (auto& device : device_vec)
+        if (device.name == name)
+            return true;
+    return false;
+}
+
+/**
+ * @brief Set a device of the flat circuit to a value, whatever its kind
+ *
+ * @return true : Set
+ * @return false : No such device
+ */
+bool SetAnyDevice(Circuit& circuit, const DeviceName name, const double value) {
+    return SetDeviceValue(circuit.vsrc_vec, name, value) ||
+           SetDeviceValue(circuit.isrc_vec, name, value) ||
+           SetDeviceValue(circuit.vccs_vec, name, value) ||
+           SetDeviceValue(circuit.vcvs_vec, name, value) ||
+           SetDeviceValue(circuit.res_vec, name, value) ||
+           SetDeviceValue(circuit.cap_vec, name, value) ||
+           SetDeviceValue(circuit.ind_vec, name, value);
+}
+
+/**
+ * @brief Elaborate the subckt hierarchy for one run, with the device of a
+ * .step sweep set to its value
+ *
+ * @param hierarchy as parsed
+ * @param flat
+ * @return true : Flattened
+ * @return false : Unresolved instances, or no such step device
+ */
+bool Analyzer::Flatten(const Circuit& hierarchy, Circuit& flat) const {
+    if (!FlattenCircuit(hierarchy, flat))
+        return false;
+    return step_device.isEmpty() || SetAnyDevice(flat, step_device, step_value);
+}
+
+/**
+ * @brief Whether the parameter / device of a .step sweep exists. A device
+ * inside a subckt instance is looked up by its flat name, which takes
+ * flattening the circuit once.
+ */
+bool Analyzer::CanStep(const StepAnalysis& step_analysis) const {
+    DeviceName name = step_analysis.name;
+    if (step_analysis.param)
+        return parsed->param_table.Slot(str(name)) >= 0;
+    auto has_device = [&](const Circuit& c) {
+        return HasDevice(c.vsrc_vec, name) || HasDevice(c.isrc_vec, name) ||
+               HasDevice(c.vccs_vec, name) || HasDevice(c.vcvs_vec, name) ||
+               HasDevice(c.res_vec, name) || HasDevice(c.cap_vec, name) ||
+               HasDevice(c.ind_vec, name);
+    };
+    if (has_device(*parsed))
+        return true;
+    Circuit flat;
+    return FlattenCircuit(*parsed, flat) && has_device(flat);
+}
+
+/**
+ * @brief Set the parameter / device of a .step sweep to one of its values.
+ * The parsed circuit is shared with the analyzer this one was copied from: a
+ * parameter step takes its own copy of it, a device step is only applied when
+ * Run() flattens it. With a raw file, every step writes its own
+ * (`<name>_step<k>.raw`).
+ *
+ * @param step_analysis
+ * @param index of the value in step_analysis.value_vec
+ * @return true : Set
+ * @return false : No such parameter or device
+ */
+bool Analyzer::ApplyStep(const StepAnalysis& step_analysis, const int index) {
+    if (!CanStep(step_analysis))
+        return false;
+
+    double value = step_analysis.value_vec[index];
+    DeviceName name = step_analysis.name;
+    if (step_analysis.param) {
+        Circuit stepped = *parsed;
+        EvaluateParams(stepped, {{stepped.param_table.Slot(str(name)), value}});
+        parsed = std::make_shared<const Circuit>(std::move(stepped));
+    } else {
+        step_device = name;
+        step_value = value;
+    }
+
+    QString raw_file = GetOption(options, "rawfile");
+    if (!raw_file.isEmpty()) {
+        QFileInfo info(raw_file);
+        options["rawfile"] = info.dir().filePath(info.completeBaseName() + "_step" +
+                                                 QString::number(index + 1) + "." +
+                                                 info.suffix());
+    }
+    return true;
+}
+
+/**
+ * @brief Report a solved step to the caller of Run()
+ *
+ * @return true : Go on
+ * @return false : Stop the analysis
+ */
+bool Analyzer::ReportStep(const int step, const int step_num, const double x,
+                          const vector<NodeName>& node_vec, const double* value) {
+    if (!step_callback)
+        return true;
+    return step_callback(AnalysisStep{step, step_num, x, &node_vec, value});
+}
+
+/**
+ * @brief Open the raw file given by `.options rawfile=...`, if any
+ *
+ * @return true : Results of this analysis are streamed to the file
+ * @return false : No raw file requested
+ */
+bool Analyzer::OpenRawFile(RawWriter& raw_writer, const QString plot_name,
+                           const QString x_name, const QString x_type,
+                           const std::vector<NodeName> node_vec, const bool complex) {
+    QString raw_file = GetOption(options, "rawfile");
+    if (raw_file.isEmpty())
+        return false;
+    return raw_writer.Open(raw_file, title, plot_name, x_name, x_type, node_vec, complex);
+}
+
+/**
+ * @brief Select the unknowns kept in the results (and the raw file): only the
+ * ones referenced by .print / .plot, or all of them with `.options save=all`.
+ *
+ * @param node_vec unknowns of the reduced MNA system
+ * @param saved_node_vec output, names of the saved unknowns
+ * @return arma::uvec indices of the saved unknowns in node_vec
+ */
+arma::uvec Analyzer::SavedIndex(const vector<NodeName> node_vec,
+                                vector<NodeName>& saved_node_vec) {
+    vector<arma::uword> index_vec;
+    saved_node_vec.clear();
+
+    if (GetOption(options, "save").toLower() == "all") {
+        for (std::size_t i = 0; i < node_vec.size(); i++)
+            index_vec.push_back(i);
+        saved_node_vec = node_vec;
+    } else {
+        for (auto print_variable : print_variable_vec) {
+            int index = FindNode(node_vec, print_variable.node);
+            if (index < 0 || FindNode(saved_node_vec, print_variable.node) >= 0)
+                continue;
+            index_vec.push_back(index);
+            saved_node_vec.push_back(print_variable.node);
+        }
+    }
+
+    cout << "Saving " << index_vec.size() << " of " << node_vec.size() << " unknowns"
+         << endl;
+    return arma::uvec(index_vec);
+}
+
+/**
+ * @brief Create the store the results are written to. Waveforms are lossless
+ * unless `.options wavevtol=... waveitol=...` give an absolute tolerance for
+ * node voltages / branch currents.
+ *
+ * @param saved_node_vec
+ * @return WaveformStore
+ */
+WaveformStore Analyzer::NewWaveformStore(const vector<NodeName> saved_node_vec) {
+    double v_tolerance = GetOptionValue(options, "wavevtol", 0);
+    double i_tolerance = GetOptionValue(options, "waveitol", 0);
+
+    vector<double> tolerance_vec;
+    for (auto node : saved_node_vec)
+        tolerance_vec.push_back(node.startsWith("i_") ? i_tolerance : v_tolerance);
+    return WaveformStore(tolerance_vec);
+}
+
+void Analyzer::PrintWaveformSummary(const WaveformStore& waveform) {
+    std::size_t raw_bytes = waveform.PointNum() * (waveform.SignalNum() + 1) * sizeof(double);
+    cout << "Stored " << waveform.PointNum() << " points of " << waveform.SignalNum()
+         << " signals in " << waveform.StoredBytes() << " bytes (" << raw_bytes
+         << " uncompressed)" << endl;
+}
+
+/**
+ * @brief Whether matrices and factors are carried over from the last run:
+ * `.options incremental=1`, with a session set by the owner of the analyzer
+ */
+bool Analyzer::Incremental() {
+    return session != nullptr && GetOptionValue(options, "incremental", 0) != 0;
+}
+
+/**
+ * @brief How the running analysis solves its matrices, from the options
+ */
+SolverOptions Analyzer::ReadSolverOptions() {
+    // `.options solver=dense|sparse|schur|iterative|mixed`; `dcsolver=...`,
+    // `acsolver=...` and `transolver=...` set it for one analysis, and the
+    // same goes for the other solver options
+    QString prefix = QString::fromStdString(AnalysisType_lookup[analysis_type]).toLower();
+    auto solver_option = [&](const QString key, const QString default_value) {
+        return GetOption(options, prefix + key, GetOption(options, key, default_value));
+    };
+    auto solver_value = [&](const QString key, const double default_value) {
+        return GetOptionValue(options, prefix + key,
+                              GetOptionValue(options, key, default_value));
+    };
+    auto lookup = [&](const std::vector<std::string>& lookup_vec, const QString key,
+                      const int default_index) {
+        QString name = solver_option(key, QString::fromStdString(lookup_vec[default_index]));
+        auto it = std::find(lookup_vec.begin(), lookup_vec.end(), str(name.toLower()));
+        if (it != lookup_vec.end())
+            return int(it - lookup_vec.begin());
+        cout << "Unknown " << key << " " << name << ", using " << lookup_vec[default_index]
+             << endl;
+        return default_index;
+    };
+
+    SolverOptions solver_options;
+    solver_options.solver = SolverType(lookup(SolverType_lookup, "solver", DENSE_SOLVER));
+    solver_options.ordering =
+        OrderingType(lookup(OrderingType_lookup, "ordering", AMD_ORDERING));
+
+    // `.options partitions=...` for the Schur solver, `components=0` factors
+    // the circuit as one block
+    solver_options.partition_num = solver_value("partitions", 0);
+    solver_options.split = solver_value("components", 1) != 0;
+    solver_options.thread_num = solver_value("solverthreads", 0);
+
+    // `.options method=pcg|gmres|bicgstab precond=ilu0|ic0|amg|jacobi|none
+    // itol=... maxiter=...` for the iterative solver
+    solver_options.method = KrylovMethod(lookup(KrylovMethod_lookup, "method", AUTO_KRYLOV));
+    solver_options.preconditioner = PreconditionerType(
+        lookup(PreconditionerType_lookup, "precond", AUTO_PRECONDITIONER));
+    solver_options.tolerance = solver_value("itol", DEFAULT_ITERATIVE_TOL);
+    solver_options.max_iterations = solver_value("maxiter", DEFAULT_MAX_ITERATIONS);
+    return solver_options;
+}
+
+/**
+ * @brief Whether DC and TRAN assemble a linear circuit straight into CSC: the
+ * solvers that factor it sparse never need the dense matrix
+ */
+bool Analyzer::SparseAssembly() {
+    SolverType solver = ReadSolverOptions().solver;
+    return solver == SPARSE_SOLVER || solver == SCHUR_SOLVER ||
+           solver == ITERATIVE_SOLVER;
+}
+
+/**
+ * @brief Get factors of a linear engine's matrix. In incremental mode the
+ * session's factors follow the change since the last run, as a low rank update
+ * when at most `.options updaterank=...` rows / columns changed.
+ *
+ * @param factor
+ * @param matrix
+ * @return true : Factored, solve with `factor`
+ * @return false : Singular, solve the matrix directly
+ */
+bool Analyzer::PrepareFactor(FactorCache& factor, const arma::mat& matrix) {
+    return PrepareFactor(factor, ToCsc(matrix));
+}
+
+bool Analyzer::PrepareFactor(FactorCache& factor, const CscMatrix& matrix) {
+    SolverOptions solver_options = ReadSolverOptions();
+    factor.SetOptions(solver_options);
+
+    if (GetOptionValue(options, "orderreport", 0) != 0)
+        PrintOrderingReport(matrix);
+
+    FactorState state =
+        Incremental()
+            ? factor.Update(matrix, GetOptionValue(options, "updaterank", MAX_UPDATE_RANK))
+            : factor.Factor(matrix);
+
+    switch (state) {
+        case FACTOR_REUSED: cout << "Matrix unchanged, factors reused" << endl; break;
+        case FACTOR_UPDATED:
+            cout << "Factors updated, rank " << factor.Rank() << endl;
+            break;
+        case FACTOR_REFACTORED:
+            cout << (solver_options.solver == ITERATIVE_SOLVER ? "Preconditioner set up"
+                                                               : "Matrix factored");
+            if (factor.BlockNum() > 1)
+                cout << " as " << factor.BlockNum() << " independent blocks, largest "
+                     << factor.LargestBlock() << " of " << matrix.n_rows << " unknowns";
+            if (factor.PartitionNum() > 0)
+                cout << ", " << factor.PartitionNum() << " partitions joined by "
+                     << factor.InterfaceNum() << " interface unknowns";
+            cout << endl;
+            break;
+        case FACTOR_SINGULAR: cout << "Singular matrix, factors not kept" << endl; break;
+    }
+    return state != FACTOR_SINGULAR;
+}
+
+/**
+ * @brief Refinement steps the mixed precision solves took, and whether a
+ * matrix had to be factored in double precision after all
+ */
+void PrintMixedSummary(const MixedStats& stats) {
+    if (stats.solve_num == 0)
+        return;
+
+    cout << "Mixed precision: " << stats.solve_num << " solves, "
+         << double(stats.refine_num) / stats.solve_num << " refinement steps per solve";
+    if (stats.fallback)
+        cout << ", fell back to double precision";
+    cout << endl;
+}
+
+/**
+ * @brief What the iterative or mixed precision solver did over the analysis:
+ * iterations, and how many solves stopped above the tolerance; refinement
+ * steps, and fallbacks to double precision
+ */
+void Analyzer::PrintSolverSummary(const FactorCache& factor) {
+    PrintMixedSummary(factor.MixedSummary());
+
+    IterativeStats stats = factor.IterativeSummary();
+    if (stats.solve_num == 0)
+        return;
+
+    cout << "Iterative solver: " << stats.solve_num << " solves, "
+         << double(stats.iteration_num) / stats.solve_num << " iterations per solve, "
+         << "worst residual " << stats.worst_residual << endl;
+    if (stats.failed_num > 0)
+        cout << "Warning: " << stats.failed_num
+             << " solves did not converge, raise maxiter or itol, or use a direct solver"
+             << endl;
+}
+
 void Analyzer::PrintMatrix(cx_mat mat, vector<NodeName> nodes) {
     cout << "Matrix: " << endl << ' ';
     for (auto node : nodes) {
@@ -0,0 +1,178 @@
+/**
+ * @file batch_solver.cpp
+ * @author Yaotian Liu
+ * @brief Dense LU of many perturbed copies of one matrix at once
+ * @date 2026-10-19
+ */
+
+#include "batch_solver.h"
+
+#include <cmath>
+
+using arma::mat;
+using arma::uvec;
+using arma::vec;
+
+/**
+ * @brief Pick the row order on the nominal system and lay it out in every lane
+ *
+ * @param nominal_mat
+ * @param nominal_rhs
+ */
+BatchSolver::BatchSolver(const mat& nominal_mat, const vec& nominal_rhs)
+    : n(nominal_mat.n_rows) {
+    mat lower, upper, p;
+    if (n == 0 || !arma::lu(lower, upper, p, nominal_mat))
+        return;
+
+    // P^T L U = nominal_mat: row i of the batch is row perm(i) of the matrix
+    uvec perm = arma::conv_to<uvec>::from(p * arma::regspace<vec>(0, n - 1.0));
+    row_pos.resize(n);
+    for (int i = 0; i < n; i++)
+        row_pos[perm(i)] = i;
+
+    for (int k = 0; k < n; k++) {
+        nominal_pivot.push_back(std::fabs(upper(k, k)));
+        if (nominal_pivot.back() == 0)
+            return;
+    }
+
+    std::size_t lane_size = static_cast<std::size_t>(n) * BATCH_LANES;
+    nominal_mat_data.resize(lane_size * n);
+    nominal_rhs_data.resize(lane_size);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            double* entry = Entry(nominal_mat_data, i, j);
+            for (int s = 0; s < BATCH_LANES; s++)
+                entry[s] = nominal_mat(perm(i), j);
+        }
+        for (int s = 0; s < BATCH_LANES; s++)
+            nominal_rhs_data[i * BATCH_LANES + s] = nominal_rhs(perm(i));
+    }
+
+    Reset();
+    valid = true;
+}
+
+/**
+ * @brief Load the nominal system into every lane
+ */
+void BatchSolver::Reset() {
+    mat_data = nominal_mat_data;
+    rhs_data = nominal_rhs_data;
+}
+
+/**
+ * @brief matrix(row, col) += coeff * lane_value[s] in every lane s
+ */
+void BatchSolver::AddMat(const int row, const int col, const double coeff,
+                         const double* lane_value) {
+    double* entry = Entry(mat_data, row_pos[row], col);
+    for (int s = 0; s < BATCH_LANES; s++)
+        entry[s] += coeff * lane_value[s];
+}
+
+/**
+ * @brief rhs(row) += coeff * lane_value[s] in every lane s
+ */
+void BatchSolver::AddRhs(const int row, const double coeff, const double* lane_value) {
+    double* entry = rhs_data.data() + row_pos[row] * BATCH_LANES;
+    for (int s = 0; s < BATCH_LANES; s++)
+        entry[s] += coeff * lane_value[s];
+}
+
+/**
+ * @brief Factor and solve every lane. Lanes the nominal row order does not
+ * suit (a pivot much smaller than the nominal one) are solved again alone.
+ *
+ * @return int lanes solved alone
+ */
+int BatchSolver::Solve() {
+    lu_data = mat_data;
+    x_data = rhs_data;
+
+    bool lane_failed[BATCH_LANES] = {};
+    double inv_pivot[BATCH_LANES];
+    double factor[BATCH_LANES];
+
+    // Elimination, with the forward substitution of the rhs along
+    for (int k = 0; k < n; k++) {
+        const double* pivot = Entry(lu_data, k, k);
+        double limit = BATCH_PIVOT_RATIO * nominal_pivot[k];
+        for (int s = 0; s < BATCH_LANES; s++) {
+            lane_failed[s] = lane_failed[s] || std::fabs(pivot[s]) < limit;
+            inv_pivot[s] = 1 / pivot[s];
+        }
+
+        const double* b_k = x_data.data() + k * BATCH_LANES;
+        for (int i = k + 1; i < n; i++) {
+            double* l = Entry(lu_data, i, k);
+
+            // MNA matrices are sparse, most rows have nothing to eliminate
+            bool zero = true;
+            for (int s = 0; s < BATCH_LANES; s++)
+                zero = zero && l[s] == 0;
+            if (zero)
+                continue;
+
+            for (int s = 0; s < BATCH_LANES; s++) {
+                factor[s] = l[s] * inv_pivot[s];
+                l[s] = factor[s];
+            }
+            for (int j = k + 1; j < n; j++) {
+                double* a_ij = Entry(lu_data, i, j);
+                const double* a_kj = Entry(lu_data, k, j);
+                for (int s = 0; s < BATCH_LANES; s++)
+                    a_ij[s] -= factor[s] * a_kj[s];
+            }
+            double* b_i = x_data.data() + i * BATCH_LANES;
+            for (int s = 0; s < BATCH_LANES; s++)
+                b_i[s] -= factor[s] * b_k[s];
+        }
+    }
+
+    // Back substitution
+    for (int i = n - 1; i >= 0; i--) {
+        double* x_i = x_data.data() + i * BATCH_LANES;
+        for (int j = i + 1; j < n; j++) {
+            const double* a_ij = Entry(lu_data, i, j);
+            const double* x_j = x_data.data() + j * BATCH_LANES;
+            for (int s = 0; s < BATCH_LANES; s++)
+                x_i[s] -= a_ij[s] * x_j[s];
+        }
+        const double* pivot = Entry(lu_data, i, i);
+        for (int s = 0; s < BATCH_LANES; s++)
+            x_i[s] /= pivot[s];
+    }
+
+    int fallback_num = 0;
+    for (int s = 0; s < BATCH_LANES; s++) {
+        if (!lane_failed[s])
+            continue;
+
+        mat a(n, n);
+        vec b(n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++)
+                a(i, j) = Entry(mat_data, i, j)[s];
+            b(i) = rhs_data[i * BATCH_LANES + s];
+        }
+
+        vec x;
+        if (!arma::solve(x, a, b))
+            x = vec(n).fill(arma::datum::nan);
+        for (int i = 0; i < n; i++)
+            x_data[i * BATCH_LANES + s] = x(i);
+        fallback_num++;
+    }
+    return fallback_num;
+}
+
+/**
+ * @brief Solution of one lane, in the order of the nominal unknowns
+ */
+void BatchSolver::Solution(const int lane, vec& x) const {
+    x.set_size(n);
+    for (int i = 0; i < n; i++)
+        x(i) = x_data[i * BATCH_LANES + lane];
+}
@@ -0,0 +1,62 @@
+/**
+ * @file batch_solver.h
+ * @author Yaotian Liu
+ * @brief Dense LU of many perturbed copies of one matrix at once
+ * @date 2026-10-19
+ */
+
+#if !defined(BATCH_SOLVER_H)
+#define BATCH_SOLVER_H
+
+#include <armadillo>
+#include <vector>
+
+// Systems solved together. The values of one matrix entry are contiguous over
+// the lanes, so every inner loop runs over BATCH_LANES doubles with no branch
+// and the compiler turns it into full SIMD registers (4 doubles with AVX2, 8
+// with AVX-512).
+const int BATCH_LANES = 16;
+
+// A lane whose pivot falls below this fraction of the nominal pivot is solved
+// again on its own, with partial pivoting.
+const double BATCH_PIVOT_RATIO = 1e-3;
+
+/**
+ * @brief Solves BATCH_LANES systems A_s x_s = b_s that are perturbations of
+ * one nominal system. They share the row order chosen by partial pivoting on
+ * the nominal matrix, so the elimination is the same for every lane and runs
+ * lane-interleaved: entry (i, j) of lane s is at (i * n + j) * BATCH_LANES + s.
+ */
+class BatchSolver {
+  public:
+    BatchSolver(const arma::mat& nominal_mat, const arma::vec& nominal_rhs);
+
+    bool Valid() const { return valid; }
+
+    void Reset();
+    void AddMat(const int row, const int col, const double coeff, const double* lane_value);
+    void AddRhs(const int row, const double coeff, const double* lane_value);
+
+    int Solve();
+    void Solution(const int lane, arma::vec& x) const;
+
+  private:
+    bool valid = false;
+    int n;
+    std::vector<int> row_pos;  // Position of each row of the nominal matrix
+    std::vector<double> nominal_pivot;
+
+    std::vector<double> nominal_mat_data;
+    std::vector<double> nominal_rhs_data;
+
+    std::vector<double> mat_data;  // As loaded, kept for the fallback
+    std::vector<double> rhs_data;
+    std::vector<double> lu_data;
+    std::vector<double> x_data;
+
+    double* Entry(std::vector<double>& data, const int i, const int j) {
+        return data.data() + (static_cast<std::size_t>(i) * n + j) * BATCH_LANES;
+    }
+};
+
+#endif  // BATCH_SOLVER_H
@@ -0,0 +1,500 @@
+/**
+ * @file incremental.cpp
+ * @author Yaotian Liu
+ * @brief Re-simulation after value edits: restamping and factor updates
+ * @date 2026-10-19
+ */
+
+#include "incremental.h"
+
+#include <numeric>
+
+#include "../solver/components.h"
+#include "analyzer.h"
+
+using arma::cx_mat;
+using arma::mat;
+using arma::uvec;
+using arma::uword;
+using arma::vec;
+using std::complex;
+using std::vector;
+
+/**
+ * @brief Choose how the next factorization is done; factors made another
+ * way are dropped.
+ *
+ * @param options
+ */
+void FactorCache::SetOptions(const SolverOptions& options) {
+    if (!options.SameFactors(this->options))
+        Clear();
+    this->options = options;
+}
+
+WorkStealingPool& FactorCache::Pool() {
+    if (!pool || pool->ThreadNum() != WorkStealingPool(options.thread_num).ThreadNum())
+        pool = std::make_shared<WorkStealingPool>(options.thread_num);
+    return *pool;
+}
+
+/**
+ * @brief Factor a matrix from scratch, dropping any update
+ *
+ * @return FACTOR_REFACTORED, or FACTOR_SINGULAR if a pivot vanished
+ */
+FactorState FactorCache::Factor(const mat& matrix) { return Factor(ToCsc(matrix)); }
+
+FactorState FactorCache::Factor(const CscMatrix& matrix) {
+    Clear();
+    if (matrix.n_cols == 0)
+        return FACTOR_SINGULAR;
+
+    vector<vector<int>> component_vec;
+    if (options.split) {
+        component_vec = ConnectedComponents(SymmetricGraph(matrix));
+    } else {
+        component_vec.assign(1, vector<int>(matrix.n_cols));
+        std::iota(component_vec[0].begin(), component_vec[0].end(), 0);
+    }
+
+    // Position of every unknown in its block. The blocks do not couple, so the
+    // columns of a block only have rows of that block.
+    vector<int> local_index(matrix.n_rows);
+    block_vec.resize(component_vec.size());
+    for (std::size_t k = 0; k < component_vec.size(); k++) {
+        block_vec[k].index = arma::conv_to<uvec>::from(component_vec[k]);
+        for (std::size_t i = 0; i < component_vec[k].size(); i++)
+            local_index[component_vec[k][i]] = i;
+    }
+
+    auto factor_block = [&](const std::size_t k) {
+        if (block_vec.size() == 1)
+            return FactorAt(block_vec[k], matrix);
+        return FactorAt(block_vec[k], Extract(matrix, local_index, component_vec[k],
+                                              component_vec[k].size()));
+    };
+
+    vector<char> factored_vec(block_vec.size(), 0);
+    if (block_vec.size() == 1) {
+        factored_vec[0] = factor_block(0);
+    } else {
+        vector<WorkStealingPool::Job> job_vec;
+        for (std::size_t k = 0; k < block_vec.size(); k++)
+            job_vec.push_back([&, k]() { factored_vec[k] = factor_block(k); });
+        Pool().Run(job_vec);
+    }
+
+    for (auto block_factored : factored_vec) {
+        if (!block_factored) {
+            Clear();
+            return FACTOR_SINGULAR;
+        }
+    }
+
+    base = matrix;
+    factored = true;
+    return FACTOR_REFACTORED;
+}
+
+/**
+ * @brief Factor one diagonal block of the matrix
+ *
+ * @param block
+ * @param a the block, its unknowns numbered as in block.index
+ * @return true : Factored
+ * @return false : Singular
+ */
+bool FactorCache::FactorAt(FactorBlock& block, const CscMatrix& a) const {
+    if (options.solver == ITERATIVE_SOLVER)
+        return block.iterative.Setup(a, options.method, options.preconditioner);
+
+    if (options.solver == SPARSE_SOLVER || options.solver == SCHUR_SOLVER) {
+        // Small blocks, and blocks that do not partition, are factored whole
+        if (options.solver == SCHUR_SOLVER && a.n_cols >= SCHUR_MIN_SIZE &&
+            block.schur.Factor(a, options.partition_num, options.ordering, options.thread_num))
+            return true;
+        return block.sparse_lu.Factor(a, ComputeOrdering(a, options.ordering));
+    }
+
+    mat block_mat = ToDense(a);
+    if (options.solver == MIXED_SOLVER)
+        return block.mixed_lu.Factor(block_mat);
+
+    mat p;
+    if (!arma::lu(block.lower, block.upper, p, block_mat))
+        return false;
+
+    vec pivot = arma::abs(block.upper.diag());
+    if (pivot.min() <= pivot.max() * block_mat.n_rows * arma::datum::eps)
+        return false;
+
+    // P^T L U = block, keep P as a row index
+    block.perm = arma::conv_to<uvec>::from(p * arma::regspace<vec>(0, block_mat.n_rows - 1.0));
+    return true;
+}
+
+uword FactorCache::LargestBlock() const {
+    uword largest = 0;
+    for (auto& block : block_vec)
+        largest = std::max(largest, block.index.n_elem);
+    return largest;
+}
+
+int FactorCache::PartitionNum() const {
+    int partition_num = 0;
+    for (auto& block : block_vec)
+        partition_num += block.schur.PartitionNum();
+    return partition_num;
+}
+
+int FactorCache::InterfaceNum() const {
+    int interface_num = 0;
+    for (auto& block : block_vec)
+        interface_num += block.schur.InterfaceNum();
+    return interface_num;
+}
+
+/**
+ * @brief Solves of the iterative solver since the matrix was set up, over
+ * all blocks
+ */
+IterativeStats FactorCache::IterativeSummary() const {
+    IterativeStats summary;
+    for (auto& block : block_vec)
+        summary.Add(block.iterative.Stats());
+    return summary;
+}
+
+MixedStats FactorCache::MixedSummary() const {
+    MixedStats summary;
+    for (auto& block : block_vec)
+        summary.Add(block.mixed_lu.Stats());
+    return summary;
+}
+
+/**
+ * @brief Follow a change of the matrix: nothing if it is the factored one, a
+ * low rank update if at most `max_rank` rows and columns differ from it, a new
+ * factorization otherwise.
+ *
+ * @param matrix
+ * @param max_rank
+ * @return FactorState
+ */
+FactorState FactorCache::Update(const mat& matrix, const uword max_rank) {
+    return Update(ToCsc(matrix), max_rank);
+}
+
+FactorState FactorCache::Update(const CscMatrix& matrix, const uword max_rank) {
+    if (!factored || matrix.n_rows != base.n_rows || matrix.n_cols != base.n_cols)
+        return Factor(matrix);
+
+    // Add() keeps the entries that cancel, only the nonzero ones changed
+    CscMatrix delta = Add(matrix, base, -1);
+    vector<char> row_changed(matrix.n_rows, 0);
+    vector<uword> col_changed;
+    for (int j = 0; j < delta.n_cols; j++) {
+        bool changed = false;
+        for (int p = delta.col_ptr[j]; p < delta.col_ptr[j + 1]; p++) {
+            if (delta.value[p] != 0) {
+                row_changed[delta.row_index[p]] = 1;
+                changed = true;
+            }
+        }
+        if (changed)
+            col_changed.push_back(j);
+    }
+    vector<uword> row_changed_index;
+    for (int i = 0; i < matrix.n_rows; i++)
+        if (row_changed[i])
+            row_changed_index.push_back(i);
+    uvec row_index = arma::conv_to<uvec>::from(row_changed_index);
+    uvec col_index = arma::conv_to<uvec>::from(col_changed);
+
+    update_col_index.reset();
+    update_w.reset();
+    update_k.reset();
+
+    if (row_index.is_empty())
+        return FACTOR_REUSED;
+    if (row_index.n_elem > max_rank || col_index.n_elem > max_rank ||
+        options.solver == ITERATIVE_SOLVER)
+        return Factor(matrix);
+
+    // W = B^-1 R D, one solve with the old factors per changed column
+    mat w(matrix.n_rows, col_index.n_elem);
+    for (uword j = 0; j < col_index.n_elem; j++) {
+        vec u(matrix.n_rows, arma::fill::zeros);
+        uword col = col_index(j);
+        for (int p = delta.col_ptr[col]; p < delta.col_ptr[col + 1]; p++)
+            u(delta.row_index[p]) = delta.value[p];
+        w.col(j) = SolveBase(u);
+    }
+
+    mat k = arma::eye(col_index.n_elem, col_index.n_elem) + w.rows(col_index);
+    if (arma::rcond(k) < MIN_UPDATE_RCOND)
+        return Factor(matrix);
+
+    update_col_index = col_index;
+    update_w = w;
+    update_k = k;
+    return FACTOR_UPDATED;
+}
+
+void FactorCache::Clear() {
+    factored = false;
+    base = CscMatrix();
+    block_vec.clear();
+    update_col_index.reset();
+    update_w.reset();
+    update_k.reset();
+}
+
+/**
+ * @brief Solve one block; `guess` only starts the iterative solver
+ */
+vec FactorCache::SolveAt(FactorBlock& block, const vec& rhs, const vec& guess) {
+    if (options.solver == ITERATIVE_SOLVER)
+        return block.iterative.Solve(rhs, guess, options.tolerance, options.max_iterations);
+    if (options.solver == MIXED_SOLVER)
+        return block.mixed_lu.Solve(rhs);
+    if (block.schur.Factored())
+        return block.schur.Solve(rhs);
+    if (options.solver != DENSE_SOLVER)
+        return block.sparse_lu.Solve(rhs);
+
+    vec permuted = rhs.elem(block.perm);
+    vec y = arma::solve(arma::trimatl(block.lower), permuted);
+    return arma::solve(arma::trimatu(block.upper), y);
+}
+
+vec FactorCache::SolveBase(const vec& rhs, const vec& guess) {
+    if (block_vec.size() == 1)
+        return SolveAt(block_vec[0], rhs, guess);
+
+    // Blocks write disjoint entries of x
+    vec x(rhs.n_elem);
+    auto solve_block = [&](FactorBlock& block) {
+        vec block_guess = guess.n_elem == rhs.n_elem ? vec(guess.elem(block.index)) : vec();
+        x.elem(block.index) = SolveAt(block, rhs.elem(block.index), block_guess);
+    };
+    if (rhs.n_elem < PARALLEL_SOLVE_MIN) {
+        for (auto& block : block_vec)
+            solve_block(block);
+    } else {
+        vector<WorkStealingPool::Job> job_vec;
+        for (auto& block : block_vec)
+            job_vec.push_back([&]() { solve_block(block); });
+        Pool().Run(job_vec);
+    }
+    return x;
+}
+
+/**
+ * @brief Solve the current matrix (factored one plus update) for `rhs`
+ *
+ * @param rhs
+ * @param guess for the iterative solver, e.g. the previous solution; empty
+ * to start from zero
+ * @return vec
+ */
+vec FactorCache::Solve(const vec& rhs, const vec& guess) {
+    vec y = SolveBase(rhs, guess);
+    if (update_col_index.is_empty())
+        return y;
+
+    vec z = arma::solve(update_k, vec(y.elem(update_col_index)));
+    return y - update_w * z;
+}
+
+void IncrementalSession::Clear() {
+    analysis_type = NONE;
+    t_step = 0;
+    circuit.reset();
+    dc_matrix = AnalysisMatrix();
+    tran_matrix = TranAnalysisMat();
+    factor.Clear();
+}
+
+bool SameConnection(const BaseDevice& a, const BaseDevice& b) {
+    return a.name == b.name && a.node_1 == b.node_1 && a.node_2 == b.node_2;
+}
+
+bool SameConnection(const DependentSource& a, const DependentSource& b) {
+    return a.name == b.name && a.node_1 == b.node_1 && a.node_2 == b.node_2 &&
+           a.ctrl_node_1 == b.ctrl_node_1 && a.ctrl_node_2 == b.ctrl_node_2;
+}
+
+template <typename T>
+bool DiffDevices(const vector<T>& old_vec, const vector<T>& new_vec,
+                 vector<DeviceName>& changed_vec) {
+    if (old_vec.size() != new_vec.size())
+        return false;
+    for (std::size_t i = 0; i < old_vec.size(); i++) {
+        if (!SameConnection(old_vec[i], new_vec[i]))
+            return false;
+        if (old_vec[i].value != new_vec[i].value)
+            changed_vec.push_back(new_vec[i].name);
+    }
+    return true;
+}
+
+/**
+ * @brief Compare two flattened circuits device by device
+ *
+ * @param old_circuit
+ * @param new_circuit
+ * @param changed_vec output, devices whose value changed
+ * @return true : Same devices on the same nodes, only values may differ
+ * @return false : Devices or nodes were added, removed or reconnected
+ */
+bool DiffCircuit(const Circuit& old_circuit, const Circuit& new_circuit,
+                 vector<DeviceName>& changed_vec) {
+    changed_vec.clear();
+    if (old_circuit.node_vec != new_circuit.node_vec)
+        return false;
+
+    if (old_circuit.diode_vec.size() != new_circuit.diode_vec.size())
+        return false;
+    for (std::size_t i = 0; i < old_circuit.diode_vec.size(); i++) {
+        const Diode& a = old_circuit.diode_vec[i];
+        const Diode& b = new_circuit.diode_vec[i];
+        if (a.name != b.name || a.node_1 != b.node_1 || a.node_2 != b.node_2 ||
+            a.model != b.model)
+            return false;
+    }
+
+    return DiffDevices(old_circuit.vsrc_vec, new_circuit.vsrc_vec, changed_vec) &&
+           DiffDevices(old_circuit.isrc_vec, new_circuit.isrc_vec, changed_vec) &&
+           DiffDevices(old_circuit.vccs_vec, new_circuit.vccs_vec, changed_vec) &&
+           DiffDevices(old_circuit.vcvs_vec, new_circuit.vcvs_vec, changed_vec) &&
+           DiffDevices(old_circuit.res_vec, new_circuit.res_vec, changed_vec) &&
+           DiffDevices(old_circuit.cap_vec, new_circuit.cap_vec, changed_vec) &&
+           DiffDevices(old_circuit.ind_vec, new_circuit.ind_vec, changed_vec);
+}
+
+template <typename M>
+void StampAt(M& mat, const int row_index, const int col_index, const double value) {
+    if (row_index >= 0 && col_index >= 0)
+        mat(row_index, col_index) += value;
+}
+
+/**
+ * @brief Add the change of every device value to the matrices assembled by
+ * GetAnalysisMatrix(0) for the old circuit. The circuits must match in
+ * DiffCircuit().
+ */
+void RestampDc(AnalysisMatrix& analysis_matrix, const Circuit& old_circuit,
+               const Circuit& new_circuit) {
+    const vector<NodeName>& node_vec = analysis_matrix.node_vec;
+    cx_mat& mat = analysis_matrix.linear_analysis_mat;
+    cx_mat& rhs = analysis_matrix.rhs;
+
+    for (std::size_t i = 0; i < new_circuit.res_vec.size(); i++) {
+        const Res& res = new_circuit.res_vec[i];
+        double delta = 1 / res.value - 1 / old_circuit.res_vec[i].value;
+        if (delta == 0)
+            continue;
+        int node_1_index = FindNode(node_vec, res.node_1);
+        int node_2_index = FindNode(node_vec, res.node_2);
+        StampAt(mat, node_1_index, node_1_index, delta);
+        StampAt(mat, node_1_index, node_2_index, -delta);
+        StampAt(mat, node_2_index, node_1_index, -delta);
+        StampAt(mat, node_2_index, node_2_index, delta);
+    }
+
+    for (std::size_t i = 0; i < new_circuit.vccs_vec.size(); i++) {
+        const VCCS& vccs = new_circuit.vccs_vec[i];
+        double delta = vccs.value - old_circuit.vccs_vec[i].value;
+        if (delta == 0)
+            continue;
+        int node_1_index = FindNode(node_vec, vccs.node_1);
+        int node_2_index = FindNode(node_vec, vccs.node_2);
+        int ctrl_node_1_index = FindNode(node_vec, vccs.ctrl_node_1);
+        int ctrl_node_2_index = FindNode(node_vec, vccs.ctrl_node_2);
+        StampAt(mat, node_1_index, ctrl_node_1_index, delta);
+        StampAt(mat, node_1_index, ctrl_node_2_index, -delta);
+        StampAt(mat, node_2_index, ctrl_node_1_index, -delta);
+        StampAt(mat, node_2_index, ctrl_node_2_index, delta);
+    }
+
+    for (std::size_t i = 0; i < new_circuit.vcvs_vec.size(); i++) {
+        const VCVS& vcvs = new_circuit.vcvs_vec[i];
+        double delta = vcvs.value - old_circuit.vcvs_vec[i].value;
+        if (delta == 0)
+            continue;
+        int branch_index = FindNode(node_vec, "i_" + vcvs.name);
+        StampAt(mat, branch_index, FindNode(node_vec, vcvs.ctrl_node_1), -delta);
+        StampAt(mat, branch_index, FindNode(node_vec, vcvs.ctrl_node_2), delta);
+    }
+
+    for (std::size_t i = 0; i < new_circuit.vsrc_vec.size(); i++) {
+        const Vsrc& vsrc = new_circuit.vsrc_vec[i];
+        double delta = vsrc.value - old_circuit.vsrc_vec[i].value;
+        if (delta != 0)
+            StampAt(rhs, FindNode(node_vec, "i_" + vsrc.name), 0, delta);
+    }
+
+    for (std::size_t i = 0; i < new_circuit.isrc_vec.size(); i++) {
+        const Isrc& isrc = new_circuit.isrc_vec[i];
+        double delta = isrc.value - old_circuit.isrc_vec[i].value;
+        if (delta == 0)
+            continue;
+        StampAt(rhs, FindNode(node_vec, isrc.node_1), 0, delta);
+        StampAt(rhs, FindNode(node_vec, isrc.node_2), 0, -delta);
+    }
+
+    // Capacitors and inductors do not enter the matrix at w = 0.
+}
+
+/**
+ * @brief Add the change of every device value to the matrices assembled by
+ * BackEuler() for the old circuit with the same step. The circuits must match
+ * in DiffCircuit().
+ */
+void RestampTran(TranAnalysisMat& tran_analysis_mat, const Circuit& old_circuit,
+                 const Circuit& new_circuit, const double h) {
+    const vector<NodeName>& node_vec = tran_analysis_mat.node_vec;
+    mat& MNA = tran_analysis_mat.MNA;
+    mat& RHS_gen = tran_analysis_mat.RHS_gen;
+
+    for (std::size_t i = 0; i < new_circuit.res_vec.size(); i++) {
+        const Res& res = new_circuit.res_vec[i];
+        double delta = 1 / res.value - 1 / old_circuit.res_vec[i].value;
+        if (delta == 0)
+            continue;
+        int node_1_index = FindNode(node_vec, res.node_1);
+        int node_2_index = FindNode(node_vec, res.node_2);
+        StampAt(MNA, node_1_index, node_1_index, delta);
+        StampAt(MNA, node_1_index, node_2_index, -delta);
+        StampAt(MNA, node_2_index, node_1_index, -delta);
+        StampAt(MNA, node_2_index, node_2_index, delta);
+    }
+
+    for (std::size_t i = 0; i < new_circuit.ind_vec.size(); i++) {
+        const Ind& ind = new_circuit.ind_vec[i];
+        double delta = (ind.value - old_circuit.ind_vec[i].value) / h;
+        if (delta == 0)
+            continue;
+        int branch_index = FindNode(node_vec, "i_" + ind.name);
+        StampAt(MNA, branch_index, branch_index, -delta);
+        StampAt(RHS_gen, branch_index, branch_index, -delta);
+    }
+
+    for (std::size_t i = 0; i < new_circuit.cap_vec.size(); i++) {
+        const Cap& cap = new_circuit.cap_vec[i];
+        double delta = (cap.value - old_circuit.cap_vec[i].value) / h;
+        if (delta == 0)
+            continue;
+        int node_1_index = FindNode(node_vec, cap.node_1);
+        int node_2_index = FindNode(node_vec, cap.node_2);
+        int branch_index = FindNode(node_vec, "i_" + cap.name);
+        StampAt(MNA, branch_index, node_1_index, delta);
+        StampAt(MNA, branch_index, node_2_index, -delta);
+        StampAt(RHS_gen, branch_index, node_1_index, delta);
+        StampAt(RHS_gen, branch_index, node_2_index, -delta);
+    }
+
+    // Sources are read from the circuit at every time step.
+}
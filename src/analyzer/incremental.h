@@ -0,0 +1,137 @@
+/**
+ * @file incremental.h
+ * @author Yaotian Liu
+ * @brief Re-simulation after value edits: restamping and factor updates
+ * @date 2026-10-19
+ */
+
+#if !defined(INCREMENTAL_H)
+#define INCREMENTAL_H
+
+#include <armadillo>
+#include <memory>
+#include <vector>
+
+#include "../parser/parser.h"
+#include "../solver/iterative_solver.h"
+#include "../solver/mixed_lu.h"
+#include "../solver/schur_solver.h"
+#include "../solver/solver_options.h"
+#include "../solver/sparse_lu.h"
+#include "../utils/work_stealing_pool.h"
+#include "analyzer_type.h"
+
+// Changes touching more rows / columns than this refactor the matrix instead
+// of updating the factors; `.options updaterank=...` overrides it.
+const arma::uword MAX_UPDATE_RANK = 16;
+
+// The capacitance matrix of an update must be at least this well conditioned
+const double MIN_UPDATE_RCOND = 1e-12;
+
+// Solves of independent blocks run in parallel from this many unknowns on;
+// below it handing the blocks to the threads costs more than the solves.
+const arma::uword PARALLEL_SOLVE_MIN = 4096;
+
+enum FactorState { FACTOR_REUSED, FACTOR_UPDATED, FACTOR_REFACTORED, FACTOR_SINGULAR };
+
+// One independent diagonal block of a factored matrix
+struct FactorBlock {
+    arma::uvec index;  // Rows / columns of the block in the matrix
+    arma::mat lower;
+    arma::mat upper;
+    arma::uvec perm;  // Row i of L U is row perm(i) of the block
+    SparseLu sparse_lu;
+    SchurSolver schur;  // Factored instead of sparse_lu for large blocks
+    IterativeSolver iterative;
+    MixedLu<double> mixed_lu;
+};
+
+/**
+ * @brief LU factors of a matrix, kept to solve many right hand sides and to
+ * follow small changes of the matrix.
+ *
+ * A changed matrix A = B + R D C^T, where B is the factored matrix and D the
+ * changed entries (rows R, columns C), is solved with the Woodbury identity:
+ * A^-1 b = y - W K^-1 C^T y, with y = B^-1 b, W = B^-1 R D and
+ * K = I + C^T W. Updates are always taken against B, so they do not pile up;
+ * once too many entries changed, the matrix is factored again.
+ *
+ * B is factored dense (in double precision, or in single precision refined
+ * to double, see MixedLu), sparse after a fill-reducing ordering, or as
+ * partitions joined by a Schur complement (see SchurSolver). The iterative
+ * solver keeps a preconditioner instead of factors, and a change of the
+ * matrix always sets it up again. Parts of the circuit that only share ground
+ * give independent diagonal blocks, which are factored in parallel and solved
+ * on their own.
+ *
+ * The factors are taken from a CscMatrix. DC and TRAN of a linear circuit
+ * assemble it directly for the sparse, Schur and iterative solvers; the
+ * other matrices come in dense and are converted.
+ */
+class FactorCache {
+  public:
+    void SetOptions(const SolverOptions& options);
+    FactorState Factor(const arma::mat& matrix);
+    FactorState Factor(const CscMatrix& matrix);
+    FactorState Update(const arma::mat& matrix, const arma::uword max_rank);
+    FactorState Update(const CscMatrix& matrix, const arma::uword max_rank);
+    void Clear();
+
+    bool Factored() const { return factored; }
+    arma::uword Rank() const { return update_col_index.n_elem; }
+    std::size_t BlockNum() const { return block_vec.size(); }
+    arma::uword LargestBlock() const;
+    int PartitionNum() const;
+    int InterfaceNum() const;
+    IterativeStats IterativeSummary() const;
+    MixedStats MixedSummary() const;
+
+    arma::vec Solve(const arma::vec& rhs, const arma::vec& guess = arma::vec());
+
+  private:
+    bool factored = false;
+    CscMatrix base;
+    std::vector<FactorBlock> block_vec;
+
+    SolverOptions options;
+    // Threads of the parallel factorizations and solves, kept while the
+    // thread count stays, so the solves of every time step start none
+    std::shared_ptr<WorkStealingPool> pool;
+    WorkStealingPool& Pool();
+
+    arma::uvec update_col_index;
+    arma::mat update_w;
+    arma::mat update_k;
+
+    bool FactorAt(FactorBlock& block, const CscMatrix& a) const;
+    arma::vec SolveAt(FactorBlock& block, const arma::vec& rhs, const arma::vec& guess);
+    arma::vec SolveBase(const arma::vec& rhs, const arma::vec& guess = arma::vec());
+};
+
+/**
+ * @brief What is kept from one run to the next: the circuit as parsed (it is
+ * flattened again to diff it, see Analyzer::AssembleDc()), its assembled
+ * matrices and the factors. Lives as long as the worker, outside the Analyzer
+ * that is created for every run.
+ */
+struct IncrementalSession {
+    AnalysisType analysis_type = NONE;
+    double t_step = 0;
+    std::shared_ptr<const Circuit> circuit;
+
+    AnalysisMatrix dc_matrix;
+    TranAnalysisMat tran_matrix;
+    FactorCache factor;
+
+    void Clear();
+};
+
+bool DiffCircuit(const Circuit& old_circuit, const Circuit& new_circuit,
+                 std::vector<DeviceName>& changed_vec);
+
+void RestampDc(AnalysisMatrix& analysis_matrix, const Circuit& old_circuit,
+               const Circuit& new_circuit);
+void RestampTran(TranAnalysisMat& tran_analysis_mat, const Circuit& old_circuit,
+                 const Circuit& new_circuit, const double h);
+
+#endif  // INCREMENTAL_H
@@ -0,0 +1,263 @@
+/**
+ * @file mc_analyzer.cpp
+ * @author Yaotian Liu
+ * @brief Monte Carlo analysis of the operating point
+ * @date 2026-10-19
+ */
+
+#include <random>
+
+#include "analyzer.h"
+#include "batch_solver.h"
+
+using arma::mat;
+using arma::span;
+using arma::vec;
+using std::cout;
+using std::endl;
+using std::setw;
+using std::vector;
+
+// One entry of a device stamp in the reduced DC system: adds
+// coeff * parameter to matrix(row, col), or to rhs(row) if col < 0.
+struct StampEntry {
+    int row;
+    int col;
+    double coeff;
+};
+
+// A device with a tolerance. The stamped parameter is the conductance of a
+// resistor and the value of anything else.
+struct McDevice {
+    McTolerance tolerance;
+    double nominal;
+    bool conductance;
+    vector<StampEntry> entry_vec;
+};
+
+template <typename T>
+int FindDevice(const vector<T>& device_vec, const DeviceName name) {
+    for (std::size_t i = 0; i < device_vec.size(); i++)
+        if (device_vec[i].name == name)
+            return i;
+    return -1;
+}
+
+/**
+ * @brief Add an entry, given in indices of the full node list; entries on the
+ * ground row / column are dropped with it.
+ */
+void AddStampEntry(vector<StampEntry>& entry_vec, const int row_index, const int col_index,
+                   const double coeff) {
+    if (row_index > 0 && col_index > 0)
+        entry_vec.push_back(StampEntry{row_index - 1, col_index - 1, coeff});
+}
+
+void AddRhsEntry(vector<StampEntry>& entry_vec, const int row_index, const double coeff) {
+    if (row_index > 0)
+        entry_vec.push_back(StampEntry{row_index - 1, -1, coeff});
+}
+
+/**
+ * @brief Look up the devices of the .tol lines and how they enter the DC
+ * system (the stamps of GetAnalysisMatrix at w = 0)
+ *
+ * @param circuit flattened circuit
+ * @param tolerance_vec
+ * @param node_vec unknowns of the full MNA system, ground first
+ * @return vector<McDevice>
+ */
+vector<McDevice> CollectMcDevices(const Circuit& circuit,
+                                  const vector<McTolerance>& tolerance_vec,
+                                  const vector<NodeName>& node_vec) {
+    vector<McDevice> device_vec;
+
+    for (auto tolerance : tolerance_vec) {
+        McDevice device;
+        device.tolerance = tolerance;
+        device.conductance = false;
+        vector<StampEntry>& entry = device.entry_vec;
+        DeviceName name = tolerance.device;
+        int index;
+
+        if ((index = FindDevice(circuit.res_vec, name)) >= 0) {
+            const Res& res = circuit.res_vec[index];
+            int node_1_index = FindNode(node_vec, res.node_1);
+            int node_2_index = FindNode(node_vec, res.node_2);
+            device.nominal = res.value;
+            device.conductance = true;
+            AddStampEntry(entry, node_1_index, node_1_index, 1);
+            AddStampEntry(entry, node_1_index, node_2_index, -1);
+            AddStampEntry(entry, node_2_index, node_1_index, -1);
+            AddStampEntry(entry, node_2_index, node_2_index, 1);
+        } else if ((index = FindDevice(circuit.vccs_vec, name)) >= 0) {
+            const VCCS& vccs = circuit.vccs_vec[index];
+            int node_1_index = FindNode(node_vec, vccs.node_1);
+            int node_2_index = FindNode(node_vec, vccs.node_2);
+            int ctrl_node_1_index = FindNode(node_vec, vccs.ctrl_node_1);
+            int ctrl_node_2_index = FindNode(node_vec, vccs.ctrl_node_2);
+            device.nominal = vccs.value;
+            AddStampEntry(entry, node_1_index, ctrl_node_1_index, 1);
+            AddStampEntry(entry, node_1_index, ctrl_node_2_index, -1);
+            AddStampEntry(entry, node_2_index, ctrl_node_1_index, -1);
+            AddStampEntry(entry, node_2_index, ctrl_node_2_index, 1);
+        } else if ((index = FindDevice(circuit.vcvs_vec, name)) >= 0) {
+            const VCVS& vcvs = circuit.vcvs_vec[index];
+            int branch_index = FindNode(node_vec, "i_" + vcvs.name);
+            device.nominal = vcvs.value;
+            AddStampEntry(entry, branch_index, FindNode(node_vec, vcvs.ctrl_node_1), -1);
+            AddStampEntry(entry, branch_index, FindNode(node_vec, vcvs.ctrl_node_2), 1);
+        } else if ((index = FindDevice(circuit.vsrc_vec, name)) >= 0) {
+            const Vsrc& vsrc = circuit.vsrc_vec[index];
+            device.nominal = vsrc.value;
+            AddRhsEntry(entry, FindNode(node_vec, "i_" + vsrc.name), 1);
+        } else if ((index = FindDevice(circuit.isrc_vec, name)) >= 0) {
+            const Isrc& isrc = circuit.isrc_vec[index];
+            device.nominal = isrc.value;
+            AddRhsEntry(entry, FindNode(node_vec, isrc.node_1), 1);
+            AddRhsEntry(entry, FindNode(node_vec, isrc.node_2), -1);
+        } else if (FindDevice(circuit.cap_vec, name) >= 0 ||
+                   FindDevice(circuit.ind_vec, name) >= 0) {
+            cout << "Tolerance of " << name << " has no effect on the operating point"
+                 << endl;
+            continue;
+        } else {
+            cout << "Tolerance of unknown device " << name << " ignored" << endl;
+            continue;
+        }
+
+        device_vec.push_back(device);
+    }
+
+    return device_vec;
+}
+
+/**
+ * @brief Draw a value of a device from its tolerance
+ */
+double SampleValue(const McDevice& device, std::mt19937_64& rng) {
+    double tolerance = device.tolerance.tolerance;
+    double deviation = 0;
+    if (tolerance > 0) {
+        if (device.tolerance.distribution == UNIFORM)
+            deviation = std::uniform_real_distribution<double>(-tolerance, tolerance)(rng);
+        else
+            deviation = std::normal_distribution<double>(0, tolerance / 3)(rng);
+    }
+    return device.nominal * (1 + deviation);
+}
+
+void PrintMcSummary(const mat& sample_mat, const vector<NodeName>& node_vec) {
+    cout << "------ Monte Carlo: " << sample_mat.n_rows << " samples ------" << endl;
+    for (arma::uword i = 0; i < sample_mat.n_cols; i++) {
+        vec value = sample_mat.col(i);
+        value = value.elem(arma::find_finite(value));
+        if (value.is_empty())
+            continue;
+        cout << setw(8) << node_vec[i] << "  mean " << arma::mean(value) << "  sigma "
+             << arma::stddev(value) << "  min " << value.min() << "  max " << value.max()
+             << endl;
+    }
+}
+
+/**
+ * @brief Operating point of `sample_num` copies of the circuit, the devices of
+ * the .tol lines drawn from their tolerance. The copies are solved
+ * BATCH_LANES at a time by the BatchSolver.
+ *
+ * @param mc_analysis
+ * @return true : Completed
+ * @return false : Stopped by the step callback, or the circuit has diodes or
+ * is singular and nothing was sampled
+ */
+bool Analyzer::DoMcAnalysis(const McAnalysis mc_analysis) {
+    if (!circuit->diode_vec.empty()) {
+        cout << "Monte Carlo analysis supports linear circuits only" << endl;
+        return false;
+    }
+
+    AnalysisMatrix analysis_matrix = GetAnalysisMatrix(0);
+    int node_num = analysis_matrix.node_vec.size();
+
+    // `reduced` means remove the 0(gnd) node.
+    mat reduced_mat = GetReal(analysis_matrix.linear_analysis_mat(span(1, node_num - 1),
+                                                                  span(1, node_num - 1)));
+    vec reduced_rhs = GetReal(analysis_matrix.rhs(span(1, node_num - 1), 0));
+
+    std::vector<NodeName> reduced_node_vec = analysis_matrix.node_vec;
+    reduced_node_vec.erase(reduced_node_vec.begin());
+
+    vector<McDevice> device_vec =
+        CollectMcDevices(*circuit, mc_analysis.tolerance_vec, analysis_matrix.node_vec);
+    ReleaseCircuit();
+
+    std::vector<NodeName> saved_node_vec;
+    arma::uvec saved_index = SavedIndex(reduced_node_vec, saved_node_vec);
+
+    BatchSolver solver(reduced_mat, reduced_rhs);
+    if (!solver.Valid()) {
+        cout << "Singular matrix, Monte Carlo analysis skipped" << endl;
+        mc_result = McResult{mat(0, saved_index.n_elem), saved_node_vec};
+        return false;
+    }
+
+    RawWriter raw_writer;
+    OpenRawFile(raw_writer, "Monte Carlo", "sample", "notype", saved_node_vec, false);
+
+    std::mt19937_64 rng(mc_analysis.seed);
+    int sample_num = mc_analysis.sample_num;
+    mat sample_mat(sample_num, saved_index.n_elem);
+    int sample_done = 0;
+    int fallback_num = 0;
+    bool completed = true;
+
+    double lane_value[BATCH_LANES];
+    vec result;
+    for (int first = 0; first < sample_num && completed; first += BATCH_LANES) {
+        int lane_num = std::min(BATCH_LANES, sample_num - first);
+
+        // Every lane starts from the nominal circuit; the change of each
+        // parameter is stamped into all lanes at once.
+        solver.Reset();
+        for (auto& device : device_vec) {
+            for (int s = 0; s < BATCH_LANES; s++) {
+                lane_value[s] = 0;
+                if (s >= lane_num)
+                    continue;
+                double value = SampleValue(device, rng);
+                lane_value[s] = device.conductance ? 1 / value - 1 / device.nominal
+                                                   : value - device.nominal;
+            }
+            for (auto& entry : device.entry_vec) {
+                if (entry.col < 0)
+                    solver.AddRhs(entry.row, entry.coeff, lane_value);
+                else
+                    solver.AddMat(entry.row, entry.col, entry.coeff, lane_value);
+            }
+        }
+        fallback_num += solver.Solve();
+
+        for (int s = 0; s < lane_num; s++) {
+            solver.Solution(s, result);
+            vec saved_result = result.elem(saved_index);
+            sample_mat.row(sample_done) = saved_result.t();
+            raw_writer.AppendPoint(sample_done + 1, saved_result);
+            sample_done++;
+
+            if (!ReportStep(sample_done, sample_num, sample_done, saved_node_vec,
+                            saved_result.memptr())) {
+                cout << "Monte Carlo analysis stopped at sample " << sample_done << endl;
+                completed = false;
+                break;
+            }
+        }
+    }
+
+    if (fallback_num > 0)
+        cout << fallback_num << " samples solved again with pivoting" << endl;
+
+    sample_mat.resize(sample_done, sample_mat.n_cols);
+    PrintMcSummary(sample_mat, saved_node_vec);
+    mc_result = McResult{sample_mat, saved_node_vec};
+    return completed;
+}
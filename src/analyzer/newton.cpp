@@ -0,0 +1,154 @@
+/**
+ * @file newton.cpp
+ * @author Yaotian Liu
+ * @brief Newton-Raphson for the circuits with diodes, with junction voltage
+ * limiting
+ * @date 2026-10-19
+ */
+
+#include "analyzer.h"
+
+using arma::mat;
+using arma::vec;
+using std::cout;
+using std::endl;
+using std::vector;
+
+/**
+ * @brief i_sat of a diode model of diode_model_lut, which the parser checked
+ * the model against
+ *
+ * @param model
+ * @return double
+ */
+double DiodeSaturationCurrent(const ModelName model) {
+    for (auto& diode_model : diode_model_lut)
+        if (diode_model.model == model)
+            return diode_model.i_sat;
+    return diode_model_lut[0].i_sat;
+}
+
+/**
+ * @brief Limit the next Newton voltage of a pn junction (pnjlim of SPICE).
+ * Above the critical voltage, where the current turns on, a step grows the
+ * voltage only logarithmically, by as much as it would grow the current
+ * linearly, so exp(v / vt) cannot overflow on a far overshoot.
+ *
+ * @param v_new from the linear solve
+ * @param v_old where the junction was linearized
+ * @param vt thermal voltage
+ * @param v_crit critical voltage
+ * @return double the voltage to take
+ */
+double LimitJunction(const double v_new, const double v_old, const double vt,
+                     const double v_crit) {
+    if (v_new <= v_crit || std::fabs(v_new - v_old) <= 2 * vt)
+        return v_new;
+    if (v_old > 0) {
+        double arg = 1 + (v_new - v_old) / vt;
+        return arg > 0 ? v_old + vt * std::log(arg) : v_crit;
+    }
+    return vt * std::log(v_new / vt);
+}
+
+/**
+ * @brief Solve the circuit with its exponential terms by Newton-Raphson,
+ * linearizing them at the last iterate with AddExpTerm(). Every step is
+ * damped so that no junction voltage moves past LimitJunction(); a damped
+ * step never counts as converged.
+ *
+ * @param linear_mat linear part of the matrix, ground removed
+ * @param exp_analysis_vec
+ * @param linear_rhs linear part of the right hand side
+ * @param exp_rhs_vec
+ * @param max_iterations
+ * @param result in: the starting point, e.g. the last sweep point or time
+ * step; out: the last iterate
+ * @param stats iterations, limited steps and failures are added to it
+ * @return true : Converged
+ * @return false : Not within max_iterations, or the matrix was singular
+ */
+bool NewtonSolve(const mat& linear_mat, const vector<ExpTerm>& exp_analysis_vec,
+                 const mat& linear_rhs, const vector<ExpTerm>& exp_rhs_vec,
+                 const int max_iterations, vec& result, NewtonStats& stats) {
+    // Junctions of the exponential terms, x = V(node_1) - V(node_2). A
+    // conductance term is g = (i_sat / vt) e^{x / vt}, so it carries the
+    // i_sat of its own diode.
+    struct Junction {
+        int node_1_index;
+        int node_2_index;
+        double vt;
+        double v_crit;
+    };
+    vector<Junction> junction_vec;
+    for (const ExpTerm& term : exp_analysis_vec) {
+        double exponent = term.zero_order.exp.imag();
+        bool known = false;
+        for (const Junction& junction : junction_vec)
+            known = known || (junction.node_1_index == term.node_1_index &&
+                              junction.node_2_index == term.node_2_index);
+        if (known || exponent <= 0)
+            continue;
+
+        double vt = 1 / exponent;
+        double i_sat = std::fabs(term.zero_order.exp.real()) * vt;
+        if (i_sat <= 0)
+            continue;
+        double v_crit = vt * std::log(vt / (M_SQRT2 * i_sat));
+        junction_vec.push_back(
+            {term.node_1_index, term.node_2_index, vt, std::max(v_crit, vt)});
+    }
+    auto voltage = [](const Junction& junction, const vec& x) {
+        return (junction.node_1_index >= 0 ? x(junction.node_1_index) : 0) -
+               (junction.node_2_index >= 0 ? x(junction.node_2_index) : 0);
+    };
+
+    stats.solve_num++;
+    for (int k = 1; k <= max_iterations; k++) {
+        mat linearized = AddExpTerm(exp_analysis_vec, result, linear_mat);
+        mat linearized_rhs = AddExpTerm(exp_rhs_vec, result, linear_rhs);
+        vec next;
+        if (!arma::solve(next, linearized, linearized_rhs, arma::solve_opts::allow_ugly) ||
+            !next.is_finite()) {
+            stats.iteration_num += k;
+            stats.failed_num++;
+            return false;
+        }
+
+        double damping = 1;
+        for (const Junction& junction : junction_vec) {
+            double v_old = voltage(junction, result);
+            double v_new = voltage(junction, next);
+            double v_limited = LimitJunction(v_new, v_old, junction.vt, junction.v_crit);
+            if (v_limited != v_new)
+                damping = std::min(damping, (v_limited - v_old) / (v_new - v_old));
+        }
+        if (damping < 1) {
+            stats.limited_num++;
+            result += damping * (next - result);
+            continue;
+        }
+
+        bool converged = VecDifference(result, next);
+        result = next;
+        if (converged) {
+            stats.iteration_num += k;
+            return true;
+        }
+    }
+    stats.iteration_num += max_iterations;
+    stats.failed_num++;
+    return false;
+}
+
+void PrintNewtonSummary(const NewtonStats& stats) {
+    if (stats.solve_num == 0)
+        return;
+
+    cout << "Newton: " << stats.solve_num << " solves, "
+         << double(stats.iteration_num) / stats.solve_num << " iterations per solve, "
+         << stats.limited_num << " steps limited" << endl;
+    if (stats.failed_num > 0)
+        cout << "Warning: " << stats.failed_num
+             << " solves did not converge, raise newtoniter or check the circuit" << endl;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file plot_lod.cpp
+ * @author Yaotian Liu
+ * @brief Level of detail (min/max decimation) for plotting long waveforms
+ * @date 2026-10-19
+ */
+
+#include "plot_lod.h"
+
+#include <algorithm>
+
+/**
+ * @brief Keep the min and the max of every `group_size` points, in x order,
+ * so the decimated level is still sorted by x. The points are appended to
+ * `level_x` / `level_y`.
+ */
+void Decimate(const SignalView x_vec, const SignalView y_vec, std::vector<double>& level_x,
+              std::vector<double>& level_y, const std::size_t group_size) {
+    for (std::size_t first = 0; first < x_vec.size; first += group_size) {
+        std::size_t last = std::min(first + group_size, x_vec.size);
+        auto range = std::minmax_element(y_vec.begin() + first, y_vec.begin() + last);
+        std::size_t min = range.first - y_vec.begin();
+        std::size_t max = range.second - y_vec.begin();
+
+        if (min > max)
+            std::swap(min, max);
+        level_x.push_back(x_vec[min]);
+        level_y.push_back(y_vec[min]);
+        if (max != min) {
+            level_x.push_back(x_vec[max]);
+            level_y.push_back(y_vec[max]);
+        }
+    }
+}
+
+/**
+ * @brief Build the pyramid
+ *
+ * @param x_vec full resolution x, sorted; only read while building
+ * @param y_vec full resolution y
+ * @param reader reads full resolution windows later on
+ */
+PlotLod::PlotLod(const SignalView x_vec, const SignalView y_vec, WindowReader reader)
+    : reader(reader) {
+    while (true) {
+        SignalView x = level_x_vec.empty() ? x_vec : SignalView(level_x_vec.back());
+        SignalView y = level_y_vec.empty() ? y_vec : SignalView(level_y_vec.back());
+        if (x.size <= LOD_MIN_POINTS || x.size != y.size)
+            break;
+
+        std::vector<double> level_x, level_y;
+        Decimate(x, y, level_x, level_y);
+        level_x_vec.push_back(std::move(level_x));
+        level_y_vec.push_back(std::move(level_y));
+    }
+}
+
+/**
+ * @brief Points to draw for a visible x range: the finest level with at most
+ * `max_points` points in the range, plus one point on each side so the curve
+ * reaches the edges of the plot.
+ *
+ * @param x_from
+ * @param x_to
+ * @param max_points e.g. twice the width of the plot in pixels
+ * @param x_vec output
+ * @param y_vec output
+ */
+void PlotLod::Select(const double x_from, const double x_to, const std::size_t max_points,
+                     std::vector<double>& x_vec, std::vector<double>& y_vec) const {
+    x_vec.clear();
+    y_vec.clear();
+
+    if (level_x_vec.empty()) {
+        reader(x_from, x_to, x_vec, y_vec);
+        return;
+    }
+
+    for (std::size_t level = 0; level < level_x_vec.size(); level++) {
+        const std::vector<double>& level_x = level_x_vec[level];
+        const std::vector<double>& level_y = level_y_vec[level];
+
+        std::size_t first = std::lower_bound(level_x.begin(), level_x.end(), x_from) -
+                            level_x.begin();
+        std::size_t last =
+            std::upper_bound(level_x.begin(), level_x.end(), x_to) - level_x.begin();
+        first = first > 0 ? first - 1 : 0;
+        last = std::min(last + 1, level_x.size());
+
+        // The level below has about LOD_GROUP_SIZE / 2 times more points.
+        if (level == 0 && (last - first) * LOD_GROUP_SIZE / 2 <= max_points) {
+            reader(level_x[first], level_x[last - 1], x_vec, y_vec);
+            return;
+        }
+
+        if (last - first <= max_points || level + 1 == level_x_vec.size()) {
+            x_vec.assign(level_x.begin() + first, level_x.begin() + last);
+            y_vec.assign(level_y.begin() + first, level_y.begin() + last);
+            return;
+        }
+    }
+}
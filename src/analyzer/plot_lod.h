@@ -0,0 +1,52 @@
+/**
+ * @file plot_lod.h
+ * @author Yaotian Liu
+ * @brief Level of detail (min/max decimation) for plotting long waveforms
+ * @date 2026-10-19
+ */
+
+#if !defined(PLOT_LOD_H)
+#define PLOT_LOD_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "signal_view.h"
+
+// Every level keeps the min and the max of each group of this many points of
+// the level below, i.e. a quarter of its points.
+const std::size_t LOD_GROUP_SIZE = 8;
+// No coarser level is built once a level is this small.
+const std::size_t LOD_MIN_POINTS = 512;
+
+void Decimate(const SignalView x_vec, const SignalView y_vec, std::vector<double>& level_x,
+              std::vector<double>& level_y, const std::size_t group_size = LOD_GROUP_SIZE);
+
+/**
+ * @brief Min/max decimation pyramid over one waveform. A graph only needs a
+ * few points per pixel column; keeping the extremes of every group makes the
+ * decimated curve cover the same envelope as the full one, spikes included.
+ * The full resolution data is not copied, it is read back through `reader`
+ * when zoomed in far enough.
+ */
+class PlotLod {
+  public:
+    // Reads the full resolution points with x in [x_from, x_to]
+    typedef std::function<void(double x_from, double x_to, std::vector<double>& x_vec,
+                               std::vector<double>& y_vec)>
+        WindowReader;
+
+    PlotLod() {}
+    PlotLod(const SignalView x, const SignalView y, WindowReader reader);
+
+    void Select(const double x_from, const double x_to, const std::size_t max_points,
+                std::vector<double>& x_vec, std::vector<double>& y_vec) const;
+
+  private:
+    std::vector<std::vector<double>> level_x_vec;  // Level 1 (finest) first
+    std::vector<std::vector<double>> level_y_vec;
+    WindowReader reader;
+};
+
+#endif  // PLOT_LOD_H
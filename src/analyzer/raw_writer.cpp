@@ -0,0 +1,123 @@
+/**
+ * @file raw_writer.cpp
+ * @author Yaotian Liu
+ * @brief Streaming writer for SPICE raw (binary) waveform files
+ * @date 2026-10-19
+ */
+
+#include "raw_writer.h"
+
+#include <QDateTime>
+
+#include "../utils/utils.h"
+
+using std::cout;
+using std::endl;
+
+// Wide enough for any point count, so the header can be patched in place.
+const int POINT_NUM_WIDTH = 20;
+
+/**
+ * @brief Create the file and write the header
+ *
+ * @param file_name
+ * @param title
+ * @param plot_name e.g. `Transient Analysis`
+ * @param x_name name of the sweep variable, e.g. `time`
+ * @param x_type type of the sweep variable, e.g. `time`, `frequency`
+ * @param variable_vec unknowns of the MNA system; `i_x` are branch currents
+ * @param complex AC results
+ * @return true : Opened
+ * @return false : Failed to create the file
+ */
+bool RawWriter::Open(const QString file_name, const QString title,
+                     const QString plot_name, const QString x_name,
+                     const QString x_type, const std::vector<NodeName> variable_vec,
+                     const bool complex) {
+    Close();
+
+    file.setFileName(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        cout << "Failed to create raw file " << file_name << endl;
+        return false;
+    }
+
+    this->complex = complex;
+    point_num = 0;
+
+    QByteArray header;
+    header += "Title: " + title.toUtf8() + "\n";
+    header += "Date: " + QDateTime::currentDateTime().toString().toUtf8() + "\n";
+    header += "Plotname: " + plot_name.toUtf8() + "\n";
+    header += complex ? "Flags: complex\n" : "Flags: real\n";
+    header += "No. Variables: " + QByteArray::number(int(variable_vec.size() + 1)) + "\n";
+    header += "No. Points: ";
+    point_num_pos = header.size();
+    header += QByteArray(POINT_NUM_WIDTH, ' ') + "\n";
+    header += "Variables:\n";
+    header += "\t0\t" + x_name.toUtf8() + "\t" + x_type.toUtf8() + "\n";
+    for (std::size_t i = 0; i < variable_vec.size(); i++) {
+        NodeName name = variable_vec[i];
+        bool current = name.startsWith("i_");
+        QString raw_name = current ? "i(" + name.mid(2) + ")" : "v(" + name + ")";
+        header += "\t" + QByteArray::number(int(i + 1)) + "\t" + raw_name.toUtf8() +
+                  (current ? "\tcurrent\n" : "\tvoltage\n");
+    }
+    header += "Binary:\n";
+
+    file.write(header);
+    return true;
+}
+
+void RawWriter::AppendPoint(const double x, const arma::vec& values) {
+    if (!file.isOpen())
+        return;
+
+    record.clear();
+    record.push_back(x);
+    if (complex)
+        record.push_back(0);
+    for (auto v : values) {
+        record.push_back(v);
+        if (complex)
+            record.push_back(0);
+    }
+
+    file.write(reinterpret_cast<const char*>(record.data()),
+               record.size() * sizeof(double));
+    point_num++;
+}
+
+void RawWriter::AppendPoint(const double x, const arma::cx_vec& values) {
+    if (!file.isOpen())
+        return;
+
+    record.clear();
+    record.push_back(x);
+    if (complex)
+        record.push_back(0);
+    for (auto v : values) {
+        record.push_back(v.real());
+        if (complex)
+            record.push_back(v.imag());
+    }
+
+    file.write(reinterpret_cast<const char*>(record.data()),
+               record.size() * sizeof(double));
+    point_num++;
+}
+
+/**
+ * @brief Patch the number of points into the header and close the file
+ */
+void RawWriter::Close() {
+    if (!file.isOpen())
+        return;
+
+    QByteArray count = QByteArray::number(point_num).leftJustified(POINT_NUM_WIDTH, ' ');
+    file.seek(point_num_pos);
+    file.write(count);
+    file.close();
+
+    cout << "Wrote " << point_num << " points to " << file.fileName() << endl;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file raw_writer.h
+ * @author Yaotian Liu
+ * @brief Streaming writer for SPICE raw (binary) waveform files
+ * @date 2026-10-19
+ */
+
+#if !defined(RAW_WRITER_H)
+#define RAW_WRITER_H
+
+#include <QFile>
+#include <QString>
+#include <armadillo>
+#include <vector>
+
+#include "../parser/parser.h"
+
+/**
+ * @brief Writes the ngspice/LTspice compatible binary raw format: an ASCII
+ * header followed by one record per point, appended while the analysis runs.
+ * The point count is patched into the header on Close().
+ */
+class RawWriter {
+  public:
+    RawWriter() {}
+    ~RawWriter() { Close(); }
+
+    bool Open(const QString file_name, const QString title, const QString plot_name,
+              const QString x_name, const QString x_type,
+              const std::vector<NodeName> variable_vec, const bool complex);
+    void AppendPoint(const double x, const arma::vec& values);
+    void AppendPoint(const double x, const arma::cx_vec& values);
+    void Close();
+
+    bool IsOpen() { return file.isOpen(); }
+
+  private:
+    QFile file;
+    bool complex = false;
+    qint64 point_num = 0;
+    qint64 point_num_pos = 0;  // Where `No. Points:` is written in the header
+    std::vector<double> record;
+};
+
+#endif  // RAW_WRITER_H
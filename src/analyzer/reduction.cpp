@@ -0,0 +1,286 @@
+/**
+ * @file reduction.cpp
+ * @author Yaotian Liu
+ * @brief Replace the linear RLC networks of a circuit by reduced macromodels
+ * @date 2026-10-19
+ */
+
+#include "analyzer.h"
+
+#include <algorithm>
+#include <map>
+
+#include "../solver/prima.h"
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+/**
+ * @brief Reduce every RLC network hanging between the other devices of the
+ * circuit to a macromodel of its ports (PrimaReduce()). A node is internal
+ * when only resistors, capacitors and inductors touch it and it is neither
+ * ground nor kept; the internal nodes joined by those devices make one
+ * network, and the nodes it touches besides are its ports. A network is
+ * only replaced when its model is smaller than the network. The devices and
+ * nodes replaced are removed from the circuit.
+ *
+ * @param circuit flat
+ * @param keep_vec nodes (and i_<device> currents) that must stay visible
+ * @param s_vec expansion points of PrimaReduce()
+ * @param order block moments per expansion point
+ * @return vector<Macromodel>
+ */
+vector<Macromodel> ReduceCircuit(Circuit& circuit, const vector<NodeName>& keep_vec,
+                                 const vector<double>& s_vec, const int order) {
+    int node_num = circuit.node_vec.size();
+    std::map<NodeName, int> index_map;
+    for (int i = 0; i < node_num; i++)
+        index_map[circuit.node_vec[i]] = i;
+
+    vector<char> kept(node_num, 0);
+    auto keep = [&](const NodeName& node) {
+        auto it = index_map.find(node);
+        if (it != index_map.end())
+            kept[it->second] = 1;
+    };
+    keep("0");
+    for (auto& node : keep_vec)
+        keep(node);
+    for (auto& vsrc : circuit.vsrc_vec) {
+        keep(vsrc.node_1);
+        keep(vsrc.node_2);
+    }
+    for (auto& isrc : circuit.isrc_vec) {
+        keep(isrc.node_1);
+        keep(isrc.node_2);
+    }
+    for (auto& vccs : circuit.vccs_vec) {
+        for (auto& node : {vccs.node_1, vccs.node_2, vccs.ctrl_node_1, vccs.ctrl_node_2})
+            keep(node);
+    }
+    for (auto& vcvs : circuit.vcvs_vec) {
+        for (auto& node : {vcvs.node_1, vcvs.node_2, vcvs.ctrl_node_1, vcvs.ctrl_node_2})
+            keep(node);
+    }
+    for (auto& diode : circuit.diode_vec) {
+        keep(diode.node_1);
+        keep(diode.node_2);
+    }
+
+    // A probed branch current keeps its device out of the networks
+    auto probed = [&](const DeviceName& name) {
+        return std::find(keep_vec.begin(), keep_vec.end(), "i_" + name) != keep_vec.end();
+    };
+    vector<char> cap_fixed(circuit.cap_vec.size(), 0);
+    vector<char> ind_fixed(circuit.ind_vec.size(), 0);
+    for (std::size_t k = 0; k < circuit.cap_vec.size(); k++) {
+        if (probed(circuit.cap_vec[k].name)) {
+            cap_fixed[k] = 1;
+            keep(circuit.cap_vec[k].node_1);
+            keep(circuit.cap_vec[k].node_2);
+        }
+    }
+    for (std::size_t k = 0; k < circuit.ind_vec.size(); k++) {
+        if (probed(circuit.ind_vec[k].name)) {
+            ind_fixed[k] = 1;
+            keep(circuit.ind_vec[k].node_1);
+            keep(circuit.ind_vec[k].node_2);
+        }
+    }
+
+    // Networks: internal nodes joined by the RLC devices between them
+    vector<int> parent(node_num);
+    for (int i = 0; i < node_num; i++)
+        parent[i] = i;
+    auto find = [&](int i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    auto join = [&](const NodeName& node_1, const NodeName& node_2) {
+        int i = index_map[node_1];
+        int j = index_map[node_2];
+        if (!kept[i] && !kept[j])
+            parent[find(i)] = find(j);
+    };
+    for (auto& res : circuit.res_vec)
+        join(res.node_1, res.node_2);
+    for (std::size_t k = 0; k < circuit.cap_vec.size(); k++)
+        if (!cap_fixed[k])
+            join(circuit.cap_vec[k].node_1, circuit.cap_vec[k].node_2);
+    for (std::size_t k = 0; k < circuit.ind_vec.size(); k++)
+        if (!ind_fixed[k])
+            join(circuit.ind_vec[k].node_1, circuit.ind_vec[k].node_2);
+
+    // The network of a device is that of its internal end, -1 for none
+    auto network_of = [&](const NodeName& node_1, const NodeName& node_2) {
+        int i = index_map[node_1];
+        int j = index_map[node_2];
+        return !kept[i] ? find(i) : !kept[j] ? find(j) : -1;
+    };
+    vector<int> res_network(circuit.res_vec.size());
+    vector<int> cap_network(circuit.cap_vec.size(), -1);
+    vector<int> ind_network(circuit.ind_vec.size(), -1);
+    std::map<int, int> network_map;  // Root node -> network
+    auto add_network = [&](const int root) {
+        if (root >= 0 && !network_map.count(root)) {
+            int network = network_map.size();
+            network_map[root] = network;
+        }
+    };
+    for (std::size_t k = 0; k < circuit.res_vec.size(); k++) {
+        res_network[k] = network_of(circuit.res_vec[k].node_1, circuit.res_vec[k].node_2);
+        add_network(res_network[k]);
+    }
+    for (std::size_t k = 0; k < circuit.cap_vec.size(); k++) {
+        if (!cap_fixed[k])
+            cap_network[k] = network_of(circuit.cap_vec[k].node_1, circuit.cap_vec[k].node_2);
+        add_network(cap_network[k]);
+    }
+    for (std::size_t k = 0; k < circuit.ind_vec.size(); k++) {
+        if (!ind_fixed[k])
+            ind_network[k] = network_of(circuit.ind_vec[k].node_1, circuit.ind_vec[k].node_2);
+        add_network(ind_network[k]);
+    }
+
+    // Local unknowns of every network: ports, internal nodes, inductor currents
+    struct Network {
+        std::vector<int> port_vec;
+        std::vector<int> internal_vec;
+        std::map<int, int> local_map;  // Node -> unknown, ground absent
+        int ind_num = 0;
+        std::vector<Triplet> g_vec;
+        std::vector<Triplet> c_vec;
+    };
+    vector<Network> network_vec(network_map.size());
+    auto add_ports = [&](const int root, const NodeName& node_1, const NodeName& node_2) {
+        if (root < 0)
+            return;
+        Network& network = network_vec[network_map[root]];
+        for (auto& node : {node_1, node_2}) {
+            int i = index_map[node];
+            if (kept[i] && node != "0" && !network.local_map.count(i)) {
+                network.local_map[i] = network.port_vec.size();
+                network.port_vec.push_back(i);
+            }
+        }
+    };
+    for (std::size_t k = 0; k < circuit.res_vec.size(); k++)
+        add_ports(res_network[k], circuit.res_vec[k].node_1, circuit.res_vec[k].node_2);
+    for (std::size_t k = 0; k < circuit.cap_vec.size(); k++)
+        add_ports(cap_network[k], circuit.cap_vec[k].node_1, circuit.cap_vec[k].node_2);
+    for (std::size_t k = 0; k < circuit.ind_vec.size(); k++)
+        add_ports(ind_network[k], circuit.ind_vec[k].node_1, circuit.ind_vec[k].node_2);
+    for (int i = 0; i < node_num; i++) {
+        if (kept[i])
+            continue;
+        Network& network = network_vec[network_map[find(i)]];
+        network.internal_vec.push_back(i);
+        network.local_map[i] = network.port_vec.size() + network.internal_vec.size() - 1;
+    }
+
+    auto local = [&](Network& network, const NodeName& node) {
+        auto it = network.local_map.find(index_map[node]);
+        return it == network.local_map.end() ? -1 : it->second;
+    };
+    auto stamp = [](vector<Triplet>& triplet_vec, const int a, const int b,
+                    const double value) {
+        if (a >= 0)
+            triplet_vec.push_back({a, a, value});
+        if (b >= 0)
+            triplet_vec.push_back({b, b, value});
+        if (a >= 0 && b >= 0) {
+            triplet_vec.push_back({a, b, -value});
+            triplet_vec.push_back({b, a, -value});
+        }
+    };
+    for (std::size_t k = 0; k < circuit.res_vec.size(); k++) {
+        if (res_network[k] < 0)
+            continue;
+        Network& network = network_vec[network_map[res_network[k]]];
+        const Res& res = circuit.res_vec[k];
+        stamp(network.g_vec, local(network, res.node_1), local(network, res.node_2),
+              1 / res.value);
+    }
+    for (std::size_t k = 0; k < circuit.cap_vec.size(); k++) {
+        if (cap_network[k] < 0)
+            continue;
+        Network& network = network_vec[network_map[cap_network[k]]];
+        const Cap& cap = circuit.cap_vec[k];
+        stamp(network.c_vec, local(network, cap.node_1), local(network, cap.node_2),
+              cap.value);
+    }
+    for (std::size_t k = 0; k < circuit.ind_vec.size(); k++) {
+        if (ind_network[k] < 0)
+            continue;
+        Network& network = network_vec[network_map[ind_network[k]]];
+        const Ind& ind = circuit.ind_vec[k];
+        int branch = network.local_map.size() + network.ind_num++;
+        int n1 = local(network, ind.node_1);
+        int n2 = local(network, ind.node_2);
+        // The branch row is negated, -v_1 + v_2 + s L i = 0, so that
+        // G + G^T stays positive semidefinite
+        for (auto [node, sign] : {std::make_pair(n1, 1.0), std::make_pair(n2, -1.0)}) {
+            if (node >= 0) {
+                network.g_vec.push_back({node, branch, sign});
+                network.g_vec.push_back({branch, node, -sign});
+            }
+        }
+        network.c_vec.push_back({branch, branch, ind.value});
+    }
+
+    vector<Macromodel> macromodel_vec;
+    vector<char> network_reduced(network_vec.size(), 0);
+    for (std::size_t k = 0; k < network_vec.size(); k++) {
+        Network& network = network_vec[k];
+        int port_num = network.port_vec.size();
+        int unknown_num = network.local_map.size() + network.ind_num;
+
+        Macromodel macromodel;
+        macromodel.name = QString("prima%1").arg(macromodel_vec.size() + 1);
+        for (int i : network.port_vec)
+            macromodel.port_vec.push_back(circuit.node_vec[i]);
+        macromodel.internal_num = network.internal_vec.size();
+        if (!PrimaReduce(FromTriplets(unknown_num, unknown_num, network.g_vec),
+                         FromTriplets(unknown_num, unknown_num, network.c_vec), port_num,
+                         s_vec, order, macromodel.g, macromodel.c))
+            continue;
+        macromodel.state_num = macromodel.g.n_rows - port_num;
+        if (macromodel.state_num >= unknown_num - port_num)
+            continue;
+
+        network_reduced[k] = 1;
+        macromodel_vec.push_back(macromodel);
+    }
+
+    // Drop what the macromodels replace
+    auto replaced = [&](const int root) {
+        auto it = network_map.find(root);
+        return it != network_map.end() && network_reduced[it->second];
+    };
+    vector<Res> res_vec;
+    for (std::size_t k = 0; k < circuit.res_vec.size(); k++)
+        if (!replaced(res_network[k]))
+            res_vec.push_back(circuit.res_vec[k]);
+    vector<Cap> cap_vec;
+    for (std::size_t k = 0; k < circuit.cap_vec.size(); k++)
+        if (!replaced(cap_network[k]))
+            cap_vec.push_back(circuit.cap_vec[k]);
+    vector<Ind> ind_vec;
+    for (std::size_t k = 0; k < circuit.ind_vec.size(); k++)
+        if (!replaced(ind_network[k]))
+            ind_vec.push_back(circuit.ind_vec[k]);
+    vector<NodeName> node_vec;
+    for (int i = 0; i < node_num; i++)
+        if (kept[i] || !replaced(find(i)))
+            node_vec.push_back(circuit.node_vec[i]);
+
+    circuit.res_vec = res_vec;
+    circuit.cap_vec = cap_vec;
+    circuit.ind_vec = ind_vec;
+    circuit.node_vec = node_vec;
+    // Bindings point into the device arrays, and the values are final by now
+    circuit.param_binding_vec.clear();
+    return macromodel_vec;
+}
@@ -0,0 +1,548 @@
+/**
+ * @file result_cache.cpp
+ * @author Yaotian Liu
+ * @brief On-disk cache of analysis results, keyed by circuit and analysis
+ * @date 2026-10-19
+ */
+
+#include "result_cache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+
+#include "analyzer.h"
+
+using std::cout;
+using std::endl;
+
+const char RESULT_MAGIC[8] = {'S', 'E', 'D', 'A', 'R', 'E', 'S', '\0'};
+const quint32 RESULT_ENDIAN_TAG = 0x01020304;
+
+// Options that do not change the results
+const QStringList RESULT_KEY_IGNORED = {"rawfile", "resultcache", "resultcachemb",
+                                        "stepthreads", "solverthreads"};
+
+struct ResultHeader {
+    char magic[8];
+    quint32 version;
+    quint32 endian_tag;
+    char key[32];
+    qint32 analysis_type;
+    quint32 signal_num;
+    quint64 point_num;
+    double seconds;
+    quint32 complex;
+    quint32 name_bytes;
+};
+
+QString Exact(const double value) { return QString::number(value, 'g', 17); }
+
+QString Exact(const std::vector<double> value_vec) {
+    QStringList text_vec;
+    for (auto value : value_vec)
+        text_vec.push_back(Exact(value));
+    return text_vec.join(' ');
+}
+
+/**
+ * @brief The flattened circuit as text: one line per device with its evaluated
+ * value, sorted, so the order of the deck's lines, comments, spacing and how
+ * values were written (1k, 1000, {r}) do not change the key.
+ *
+ * @param circuit flattened, parameters evaluated
+ * @return QByteArray
+ */
+QByteArray CanonicalCircuit(const Circuit& circuit) {
+    QStringList line_vec;
+
+    for (auto& vsrc : circuit.vsrc_vec) {
+        QString line = QString("V %1 %2 %3 ").arg(vsrc.name, vsrc.node_1, vsrc.node_2);
+        const Pulse& p = vsrc.pulse;
+        const Sin& s = vsrc.sin;
+        if (p.chosen)
+            line += "pulse " + Exact({p.v1, p.v2, p.td, p.tr, p.tf, p.pw, p.per});
+        else if (s.chosen)
+            line += "sin " + Exact({s.v0, s.va, s.freq, s.td, s.theta});
+        else
+            line += QString("%1 %2").arg(vsrc.analysis_type).arg(Exact(vsrc.value));
+        line_vec.push_back(line);
+    }
+    for (auto& isrc : circuit.isrc_vec)
+        line_vec.push_back(QString("I %1 %2 %3 %4")
+                               .arg(isrc.name, isrc.node_1, isrc.node_2,
+                                    Exact({isrc.value, isrc.ac_value, isrc.tran_const_value})));
+    for (auto& vccs : circuit.vccs_vec)
+        line_vec.push_back(QString("G %1 %2 %3 %4 %5 %6")
+                               .arg(vccs.name, vccs.node_1, vccs.node_2, vccs.ctrl_node_1,
+                                    vccs.ctrl_node_2, Exact(vccs.value)));
+    for (auto& vcvs : circuit.vcvs_vec)
+        line_vec.push_back(QString("E %1 %2 %3 %4 %5 %6")
+                               .arg(vcvs.name, vcvs.node_1, vcvs.node_2, vcvs.ctrl_node_1,
+                                    vcvs.ctrl_node_2, Exact(vcvs.value)));
+    for (auto& res : circuit.res_vec)
+        line_vec.push_back(
+            QString("R %1 %2 %3 %4").arg(res.name, res.node_1, res.node_2, Exact(res.value)));
+    for (auto& cap : circuit.cap_vec)
+        line_vec.push_back(
+            QString("C %1 %2 %3 %4").arg(cap.name, cap.node_1, cap.node_2, Exact(cap.value)));
+    for (auto& ind : circuit.ind_vec)
+        line_vec.push_back(
+            QString("L %1 %2 %3 %4").arg(ind.name, ind.node_1, ind.node_2, Exact(ind.value)));
+    for (auto& diode : circuit.diode_vec)
+        line_vec.push_back(
+            QString("D %1 %2 %3 %4").arg(diode.name, diode.node_1, diode.node_2, diode.model));
+
+    line_vec.sort();
+    return line_vec.join('\n').toUtf8();
+}
+
+ResultCacheStats ReadStatsFile(const QString file_name) {
+    ResultCacheStats stats;
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return stats;
+
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QStringList item = stream.readLine().split('=');
+        if (item.size() != 2)
+            continue;
+        if (item[0] == "hits")
+            stats.hit_num = item[1].toLongLong();
+        else if (item[0] == "misses")
+            stats.miss_num = item[1].toLongLong();
+        else if (item[0] == "stores")
+            stats.store_num = item[1].toLongLong();
+        else if (item[0] == "evictions")
+            stats.evict_num = item[1].toLongLong();
+        else if (item[0] == "saved_seconds")
+            stats.saved_seconds = item[1].toDouble();
+    }
+    return stats;
+}
+
+void WriteStatsFile(const QString file_name, const ResultCacheStats& stats) {
+    QSaveFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+
+    QTextStream stream(&file);
+    stream << "hits=" << stats.hit_num << "\n";
+    stream << "misses=" << stats.miss_num << "\n";
+    stream << "stores=" << stats.store_num << "\n";
+    stream << "evictions=" << stats.evict_num << "\n";
+    stream << "saved_seconds=" << stats.saved_seconds << "\n";
+    stream.flush();
+    file.commit();
+}
+
+void AddTo(ResultCacheStats& stats, const ResultCacheStats& delta) {
+    stats.hit_num += delta.hit_num;
+    stats.miss_num += delta.miss_num;
+    stats.store_num += delta.store_num;
+    stats.evict_num += delta.evict_num;
+    stats.saved_seconds += delta.saved_seconds;
+}
+
+ResultCache::ResultCache(const QString dir, const double max_mb)
+    : dir(dir), max_bytes(static_cast<qint64>(max_mb * 1024 * 1024)) {
+    QDir().mkpath(dir);
+}
+
+QString ResultCache::EntryName(const QByteArray key) {
+    return QDir(dir).filePath(QString::fromLatin1(key.toHex()) + ".res");
+}
+
+/**
+ * @brief Read the entry of `key` and mark it as just used
+ *
+ * @param key
+ * @param result
+ * @return true : Hit
+ * @return false : Missing, from another version or corrupted
+ */
+bool ResultCache::Load(const QByteArray key, CachedResult& result) {
+    ResultCacheStats delta;
+    delta.miss_num = 1;
+
+    QFile file(EntryName(key));
+    QByteArray data;
+    if (file.open(QIODevice::ReadOnly))
+        data = file.readAll();
+
+    ResultHeader header;
+    bool valid = data.size() >= static_cast<int>(sizeof(header));
+    if (valid) {
+        std::memcpy(&header, data.constData(), sizeof(header));
+        valid = std::memcmp(header.magic, RESULT_MAGIC, sizeof(header.magic)) == 0 &&
+                header.version == RESULT_CACHE_VERSION &&
+                header.endian_tag == RESULT_ENDIAN_TAG && key.size() == static_cast<int>(sizeof(header.key)) &&
+                std::memcmp(header.key, key.constData(), sizeof(header.key)) == 0;
+    }
+
+    quint64 value_size = 0;
+    if (valid) {
+        value_size = header.signal_num * header.point_num * sizeof(double) *
+                     (header.complex ? 2 : 1);
+        valid = static_cast<quint64>(data.size()) == sizeof(header) + header.name_bytes +
+                                                         header.point_num * sizeof(double) +
+                                                         value_size;
+    }
+
+    if (valid) {
+        const char* cursor = data.constData() + sizeof(header);
+        const char* name_end = cursor + header.name_bytes;
+        result.node_vec.clear();
+        while (valid && cursor < name_end) {
+            quint32 length;
+            valid = name_end - cursor >= static_cast<std::ptrdiff_t>(sizeof(length));
+            if (!valid)
+                break;
+            std::memcpy(&length, cursor, sizeof(length));
+            cursor += sizeof(length);
+            valid = name_end - cursor >= static_cast<std::ptrdiff_t>(length);
+            if (valid)
+                result.node_vec.push_back(QString::fromUtf8(cursor, length));
+            cursor += length;
+        }
+        valid = valid && result.node_vec.size() == header.signal_num;
+
+        if (valid) {
+            result.analysis_type = static_cast<AnalysisType>(header.analysis_type);
+            result.seconds = header.seconds;
+            result.x_vec.resize(header.point_num);
+            std::memcpy(result.x_vec.data(), cursor, header.point_num * sizeof(double));
+            cursor += header.point_num * sizeof(double);
+            if (header.complex) {
+                result.cx_value_mat.set_size(header.signal_num, header.point_num);
+                std::memcpy(result.cx_value_mat.memptr(), cursor, value_size);
+            } else {
+                result.value_mat.set_size(header.signal_num, header.point_num);
+                std::memcpy(result.value_mat.memptr(), cursor, value_size);
+            }
+        }
+    }
+
+    if (valid) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        delta.miss_num = 0;
+        delta.hit_num = 1;
+        delta.saved_seconds = result.seconds;
+    } else if (!data.isEmpty()) {
+        cout << "Result cache entry " << file.fileName() << " is corrupted, ignored" << endl;
+    }
+    file.close();
+
+    AddStats(delta);
+    return valid;
+}
+
+/**
+ * @brief Write the entry of `key`, then evict the least recently used
+ * entries while the cache is over its size
+ *
+ * @param key
+ * @param result
+ * @return true : Stored
+ * @return false : Failed to write
+ */
+bool ResultCache::Store(const QByteArray key, const CachedResult& result) {
+    bool complex = result.analysis_type == AC;
+    std::size_t signal_num = result.node_vec.size();
+    std::size_t point_num = result.x_vec.size();
+
+    QByteArray names;
+    for (auto node : result.node_vec) {
+        QByteArray utf8 = node.toUtf8();
+        quint32 length = utf8.size();
+        names.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        names.append(utf8);
+    }
+
+    ResultHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RESULT_MAGIC, sizeof(header.magic));
+    header.version = RESULT_CACHE_VERSION;
+    header.endian_tag = RESULT_ENDIAN_TAG;
+    std::memcpy(header.key, key.constData(), std::min<int>(key.size(), sizeof(header.key)));
+    header.analysis_type = result.analysis_type;
+    header.signal_num = signal_num;
+    header.point_num = point_num;
+    header.seconds = result.seconds;
+    header.complex = complex;
+    header.name_bytes = names.size();
+
+    // Written next to the entry and renamed on commit
+    QSaveFile file(EntryName(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        cout << "Failed to write result cache entry " << EntryName(key) << endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(names);
+    file.write(reinterpret_cast<const char*>(result.x_vec.data()), point_num * sizeof(double));
+    if (complex)
+        file.write(reinterpret_cast<const char*>(result.cx_value_mat.memptr()),
+                   signal_num * point_num * sizeof(arma::cx_double));
+    else
+        file.write(reinterpret_cast<const char*>(result.value_mat.memptr()),
+                   signal_num * point_num * sizeof(double));
+    if (!file.commit()) {
+        cout << "Failed to write result cache entry " << EntryName(key) << endl;
+        return false;
+    }
+
+    ResultCacheStats delta;
+    delta.store_num = 1;
+    {
+        QLockFile lock(QDir(dir).filePath("lock"));
+        if (lock.tryLock(RESULT_CACHE_LOCK_MS))
+            delta.evict_num = Evict();
+    }
+    AddStats(delta);
+    return true;
+}
+
+/**
+ * @brief Remove the entries used least recently until the cache fits its
+ * size. The caller holds the lock.
+ *
+ * @return int number of entries removed
+ */
+int ResultCache::Evict() {
+    QFileInfoList entry_vec = QDir(dir).entryInfoList(
+        QStringList{"*.res"}, QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 total_bytes = 0;
+    for (auto& entry : entry_vec)
+        total_bytes += entry.size();
+
+    int evict_num = 0;
+    for (auto& entry : entry_vec) {
+        if (total_bytes <= max_bytes)
+            break;
+        if (QFile::remove(entry.absoluteFilePath())) {
+            total_bytes -= entry.size();
+            evict_num++;
+        }
+    }
+    return evict_num;
+}
+
+void ResultCache::AddStats(const ResultCacheStats& delta) {
+    AddTo(run_stats, delta);
+
+    QLockFile lock(QDir(dir).filePath("lock"));
+    if (!lock.tryLock(RESULT_CACHE_LOCK_MS))
+        return;
+    QString file_name = QDir(dir).filePath("stats");
+    ResultCacheStats stats = ReadStatsFile(file_name);
+    AddTo(stats, delta);
+    WriteStatsFile(file_name, stats);
+}
+
+void ResultCache::PrintStats() {
+    QFileInfoList entry_vec = QDir(dir).entryInfoList(QStringList{"*.res"}, QDir::Files);
+    qint64 total_bytes = 0;
+    for (auto& entry : entry_vec)
+        total_bytes += entry.size();
+
+    ResultCacheStats stats = ReadStatsFile(QDir(dir).filePath("stats"));
+    qint64 lookup_num = std::max<qint64>(1, stats.hit_num + stats.miss_num);
+
+    cout << "Result cache " << dir << ": " << entry_vec.size() << " entries, "
+         << total_bytes / 1024 << " of " << max_bytes / 1024 << " KB" << endl;
+    cout << "  This run: " << run_stats.hit_num << " hits, " << run_stats.miss_num
+         << " misses, " << run_stats.store_num << " stored, " << run_stats.evict_num
+         << " evicted" << endl;
+    cout << "  Total: " << stats.hit_num << " hits, " << stats.miss_num << " misses ("
+         << 100 * stats.hit_num / lookup_num << "% hit rate), " << stats.evict_num
+         << " evicted, " << stats.saved_seconds << " s of analysis saved" << endl;
+}
+
+/**
+ * @brief Key of the run: the canonical circuit, the settings of the analysis,
+ * the probes and the options that change the results
+ *
+ * @return QByteArray SHA-256
+ */
+QByteArray Analyzer::ResultKey() {
+    QStringList setting_vec;
+    setting_vec.push_back(QString("version %1").arg(RESULT_CACHE_VERSION));
+    setting_vec.push_back(QString("analysis %1").arg(analysis_type));
+
+    switch (analysis_type) {
+        case DC:
+            setting_vec.push_back(
+                QString("dc %1 %2")
+                    .arg(dc_analysis.Vsrc_name,
+                         Exact({dc_analysis.start, dc_analysis.end, dc_analysis.step})));
+            break;
+        case AC:
+            setting_vec.push_back(QString("ac %1 %2 %3 %4")
+                                      .arg(ac_analysis.Vsrc_name)
+                                      .arg(ac_analysis.variation_type)
+                                      .arg(ac_analysis.point_num)
+                                      .arg(Exact({ac_analysis.f_start, ac_analysis.f_end})));
+            break;
+        case TRAN:
+            setting_vec.push_back(QString("tran %1").arg(Exact(
+                {tran_analysis.t_step, tran_analysis.t_stop, tran_analysis.t_start})));
+            break;
+        case MC: {
+            setting_vec.push_back(
+                QString("mc %1 %2").arg(mc_analysis.sample_num).arg(mc_analysis.seed));
+            // Samples are drawn in the order of the .tol lines, which the key
+            // keeps; the order of the devices in the deck does not matter
+            for (auto& tolerance : mc_analysis.tolerance_vec)
+                setting_vec.push_back(QString("tol %1 %2 %3")
+                                          .arg(tolerance.device)
+                                          .arg(Exact(tolerance.tolerance))
+                                          .arg(tolerance.distribution));
+            break;
+        }
+        default: break;
+    }
+
+    for (auto& print_variable : print_variable_vec)
+        setting_vec.push_back(QString("print %1 %2 %3")
+                                  .arg(print_variable.print_i_v)
+                                  .arg(print_variable.analysis_variable_type)
+                                  .arg(print_variable.node));
+
+    for (auto& option : options)
+        if (!RESULT_KEY_IGNORED.contains(option.first))
+            setting_vec.push_back(QString("option %1=%2").arg(option.first, option.second));
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(setting_vec.join('\n').toUtf8());
+    hash.addData("\n");
+    hash.addData(CanonicalCircuit(*circuit));
+    return hash.result();
+}
+
+/**
+ * @brief The results of the last run, as cached
+ *
+ * @param seconds time the run took
+ * @return CachedResult
+ */
+CachedResult Analyzer::CacheEntry(const double seconds) {
+    CachedResult entry;
+    entry.analysis_type = analysis_type;
+    entry.seconds = seconds;
+
+    switch (analysis_type) {
+        case DC:
+        case TRAN: {
+            const WaveformStore& waveform =
+                analysis_type == DC ? dc_result.waveform : tran_result.waveform;
+            entry.node_vec = analysis_type == DC ? dc_result.node_vec : tran_result.node_vec;
+            waveform.ReadX(entry.x_vec);
+            entry.value_mat.set_size(entry.node_vec.size(), entry.x_vec.size());
+            std::vector<double> y_vec;
+            for (std::size_t i = 0; i < entry.node_vec.size(); i++) {
+                waveform.ReadSignal(i, y_vec);
+                for (std::size_t k = 0; k < y_vec.size(); k++)
+                    entry.value_mat(i, k) = y_vec[k];
+            }
+            break;
+        }
+        case AC:
+            entry.node_vec = ac_result.node_vec;
+            entry.x_vec = ac_result.freq_vec;
+            entry.cx_value_mat = ac_result.ac_result_mat.st();
+            break;
+        case MC:
+            entry.node_vec = mc_result.node_vec;
+            for (arma::uword k = 0; k < mc_result.sample_mat.n_rows; k++)
+                entry.x_vec.push_back(k + 1);
+            entry.value_mat = mc_result.sample_mat.t();
+            break;
+        default: break;
+    }
+    return entry;
+}
+
+/**
+ * @brief Restore the results of a cached run as if the analysis had run: the
+ * raw file is written and every point reported.
+ *
+ * @param cached
+ * @return true : Completed
+ * @return false : Stopped by the callback
+ */
+bool Analyzer::ServeCached(const CachedResult& cached) {
+    const std::vector<NodeName>& node_vec = cached.node_vec;
+    int point_num = cached.x_vec.size();
+    RawWriter raw_writer;
+
+    switch (analysis_type) {
+        case DC: OpenRawFile(raw_writer, "DC transfer characteristic", dc_analysis.Vsrc_name,
+                             "voltage", node_vec, false);
+            break;
+        case AC:
+            OpenRawFile(raw_writer, "AC Analysis", "frequency", "frequency", node_vec, true);
+            break;
+        case TRAN:
+            OpenRawFile(raw_writer, "Transient Analysis", "time", "time", node_vec, false);
+            break;
+        case MC:
+            OpenRawFile(raw_writer, "Monte Carlo", "sample", "notype", node_vec, false);
+            break;
+        default: break;
+    }
+
+    WaveformStore waveform = NewWaveformStore(node_vec);
+    int point_done = 0;
+    bool completed = true;
+    while (point_done < point_num) {
+        double x = cached.x_vec[point_done];
+        const double* value = nullptr;
+        if (analysis_type == AC) {
+            raw_writer.AppendPoint(x, arma::cx_vec(cached.cx_value_mat.col(point_done)));
+        } else {
+            value = cached.value_mat.colptr(point_done);
+            raw_writer.AppendPoint(x, arma::vec(cached.value_mat.col(point_done)));
+            if (analysis_type != MC)
+                waveform.Append(x, value);
+        }
+        point_done++;
+        if (!ReportStep(point_done, point_num, x, node_vec, value)) {
+            cout << "Stopped at point " << point_done << " of the cached results" << endl;
+            completed = false;
+            break;
+        }
+    }
+
+    switch (analysis_type) {
+        case DC: dc_result = DcResult{waveform, node_vec}; break;
+        case TRAN: tran_result = TranResult{waveform, node_vec}; break;
+        case AC: {
+            arma::cx_mat ac_result_mat = cached.cx_value_mat.head_cols(point_done).st();
+            std::vector<double> freq_vec(cached.x_vec.begin(),
+                                         cached.x_vec.begin() + point_done);
+            ac_result = AcResult{ac_result_mat, freq_vec, node_vec};
+            break;
+        }
+        case MC: {
+            arma::mat sample_mat = cached.value_mat.head_cols(point_done).t();
+            PrintMcSummary(sample_mat, node_vec);
+            mc_result = McResult{sample_mat, node_vec};
+            break;
+        }
+        default: break;
+    }
+    if (analysis_type == DC || analysis_type == TRAN)
+        PrintWaveformSummary(waveform);
+    return completed;
+}
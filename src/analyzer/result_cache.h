@@ -0,0 +1,76 @@
+/**
+ * @file result_cache.h
+ * @author Yaotian Liu
+ * @brief On-disk cache of analysis results, keyed by circuit and analysis
+ * @date 2026-10-19
+ */
+
+#if !defined(RESULT_CACHE_H)
+#define RESULT_CACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <armadillo>
+#include <vector>
+
+#include "../parser/parser.h"
+
+// Bump whenever the key or the entry layout changes.
+const quint32 RESULT_CACHE_VERSION = 1;
+
+// Size of the cache directory before the least recently used entries go,
+// see `.options resultcachemb=...`
+const double DEFAULT_RESULT_CACHE_MB = 256;
+
+// How long to wait for another process holding the cache lock
+const int RESULT_CACHE_LOCK_MS = 10000;
+
+// A completed analysis as stored in the cache: the saved signals at every
+// point, one column per point.
+struct CachedResult {
+    AnalysisType analysis_type = NONE;
+    double seconds = 0;  // What the analysis took when it ran
+    std::vector<NodeName> node_vec;
+    std::vector<double> x_vec;
+    arma::mat value_mat;        // DC, TRAN, MC
+    arma::cx_mat cx_value_mat;  // AC
+};
+
+// Counters of a cache directory, kept in <dir>/stats across runs
+struct ResultCacheStats {
+    qint64 hit_num = 0;
+    qint64 miss_num = 0;
+    qint64 store_num = 0;
+    qint64 evict_num = 0;
+    double saved_seconds = 0;  // Analysis time served from the cache
+};
+
+/**
+ * @brief Content addressed result cache: one file per key (<hex>.res) in a
+ * directory that may be shared by several processes, e.g. the jobs of a batch
+ * farm. Entries are written to a temporary file and renamed, so a reader never
+ * sees half an entry; the stats and the eviction run under a lock file. A hit
+ * touches the entry, and once the directory is larger than its limit the
+ * entries used least recently are removed.
+ */
+class ResultCache {
+  public:
+    ResultCache(const QString dir, const double max_mb);
+
+    bool Load(const QByteArray key, CachedResult& result);
+    bool Store(const QByteArray key, const CachedResult& result);
+    void PrintStats();
+
+  private:
+    QString dir;
+    qint64 max_bytes;
+    ResultCacheStats run_stats;  // This run only
+
+    QString EntryName(const QByteArray key);
+    void AddStats(const ResultCacheStats& delta);
+    int Evict();
+};
+
+QByteArray CanonicalCircuit(const Circuit& circuit);
+
+#endif  // RESULT_CACHE_H
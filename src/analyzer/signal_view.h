@@ -0,0 +1,32 @@
+/**
+ * @file signal_view.h
+ * @author Yaotian Liu
+ * @brief Read only view of the samples of one signal
+ * @date 2026-10-19
+ */
+
+#if !defined(SIGNAL_VIEW_H)
+#define SIGNAL_VIEW_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Contiguous samples of one signal (or of the x axis) owned by someone
+ * else, so the plots and writers read the results in place. Valid as long as
+ * the owner is alive and not modified.
+ */
+struct SignalView {
+    const double* data = nullptr;
+    std::size_t size = 0;
+
+    SignalView() {}
+    SignalView(const double* data, const std::size_t size) : data(data), size(size) {}
+    SignalView(const std::vector<double>& vec) : data(vec.data()), size(vec.size()) {}
+
+    const double* begin() const { return data; }
+    const double* end() const { return data + size; }
+    double operator[](const std::size_t i) const { return data[i]; }
+};
+
+#endif  // SIGNAL_VIEW_H
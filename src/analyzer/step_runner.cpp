@@ -0,0 +1,105 @@
+/**
+ * @file step_runner.cpp
+ * @author Yaotian Liu
+ * @brief .step sweeps: one analysis per value, run in parallel
+ * @date 2026-10-19
+ */
+
+#include "step_runner.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "../utils/work_stealing_pool.h"
+
+using std::cout;
+using std::endl;
+
+/**
+ * @brief Run every step
+ *
+ * @param progress
+ * @param thread_num 0 for one thread per core
+ * @param cancelled
+ * @return true : Every step completed
+ * @return false : Unknown name, or stopped by `progress` or `cancelled`
+ */
+bool StepRunner::Run(const StepProgress progress, const int thread_num,
+                     const StepCancel cancelled) {
+    int step_num = step_analysis.value_vec.size();
+    run_vec.assign(step_num, StepRun());
+
+    if (step_num == 0 || !base.CanStep(step_analysis)) {
+        cout << "No parameter or device " << step_analysis.name << " to step" << endl;
+        return false;
+    }
+
+    WorkStealingPool pool(thread_num);
+    int run_thread_num = std::min(pool.ThreadNum(), step_num);
+
+    std::atomic<bool> stop{false};
+    std::mutex progress_mutex;
+    int step_done = 0;
+
+    // A step only reports when it is done, a cancel must reach the running ones
+    auto keep_going = [&]() {
+        if (cancelled && cancelled())
+            stop = true;
+        return !stop;
+    };
+
+    std::vector<WorkStealingPool::Job> job_vec;
+    for (int k = 0; k < step_num; k++) {
+        job_vec.push_back([&, k]() {
+            StepRun& run = run_vec[k];
+            run.value = step_analysis.value_vec[k];
+            if (!keep_going())
+                return;
+
+            // Copies the settings only, the circuit is shared until the step
+            // sets its value. Steps running side by side keep the solver of
+            // each to one thread.
+            run.analyzer = base;
+            if (run_thread_num > 1)
+                run.analyzer.DefaultOption("solverthreads", "1");
+            run.analyzer.ApplyStep(step_analysis, k);
+            run.completed = run.analyzer.Run([&](const AnalysisStep&) {
+                run.point_num++;
+                return keep_going();
+            });
+
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            step_done++;
+            if (progress && !progress(step_done, step_num))
+                stop = true;
+        });
+    }
+
+    cout << "Running " << step_num << " steps of " << step_analysis.name << " on "
+         << run_thread_num << " threads" << endl;
+    pool.Run(job_vec);
+
+    bool completed = !stop;
+    for (auto& run : run_vec)
+        completed = completed && run.completed;
+    return completed;
+}
+
+/**
+ * @brief Plot the probes of every step together. Must be called on the GUI
+ * thread.
+ */
+void StepRunner::ShowPlots() {
+    std::vector<PlotLod> lod_vec;
+    std::vector<NodeName> name_vec;
+    for (auto& run : run_vec)
+        run.analyzer.CollectPlots(
+            QString(" @ %1=%2").arg(step_analysis.name).arg(run.value), lod_vec, name_vec);
+    if (lod_vec.empty())
+        return;
+
+    QString x_label;
+    bool x_log;
+    base.PlotAxes(x_label, x_log);
+    Plot(lod_vec, name_vec, x_label, QString("Value"), x_log, false);
+}
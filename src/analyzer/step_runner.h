@@ -0,0 +1,56 @@
+/**
+ * @file step_runner.h
+ * @author Yaotian Liu
+ * @brief .step sweeps: one analysis per value, run in parallel
+ * @date 2026-10-19
+ */
+
+#if !defined(STEP_RUNNER_H)
+#define STEP_RUNNER_H
+
+#include <functional>
+#include <vector>
+
+#include "analyzer.h"
+
+// Called as steps complete, from any thread but never concurrently; returning
+// false stops the steps not started yet and the running ones.
+typedef std::function<bool(int step_done, int step_num)> StepProgress;
+
+// Polled by every running step after each of its points, from any thread;
+// returning true stops all the steps, e.g. a Cancel from the GUI.
+typedef std::function<bool()> StepCancel;
+
+// One analysis of a .step sweep
+struct StepRun {
+    double value = 0;
+    bool completed = false;
+    long long point_num = 0;  // Sweep / time points solved
+    Analyzer analyzer;
+};
+
+/**
+ * @brief Runs the analysis of a deck once per .step value. Every step is a job
+ * of a WorkStealingPool: it copies the analyzer set up from the parsed deck,
+ * sharing its parsed circuit, applies its value to the copy and runs it.
+ * Results are indexed like the step values.
+ */
+class StepRunner {
+  public:
+    StepRunner() {}
+    StepRunner(const Analyzer& base, const StepAnalysis& step_analysis)
+        : base(base), step_analysis(step_analysis) {}
+
+    bool Run(const StepProgress progress = StepProgress(), const int thread_num = 0,
+             const StepCancel cancelled = StepCancel());
+    void ShowPlots();
+
+    std::vector<StepRun>& Runs() { return run_vec; }
+
+  private:
+    Analyzer base;
+    StepAnalysis step_analysis;
+    std::vector<StepRun> run_vec;
+};
+
+#endif  // STEP_RUNNER_H
@@ -13,98 +13,190 @@ using arma::vec;
 using std::cout;
 using std::endl;
 
-TranAnalysisMat BackEuler(const Circuit circuit, const double h);
-TranAnalysisMat TrapezoidalRule(const Circuit circuit, const double h);
+TranAnalysisMat BackEuler(const Circuit& circuit,
+                          const std::vector<Macromodel>& macromodel_vec, const double h);
+TranAnalysisMat TrapezoidalRule(const Circuit& circuit, const double h);
 
 double GetVsrcValue(const Vsrc vsrc, double t);
 double GetPulseValue(const Pulse pulse, double t);
 double GetSinValue(const Sin sin, double t);
 
 // TODO: only support RCL.
-void Analyzer::DoTranAnalysis(const TranAnalysis tran_analysis) {
+bool Analyzer::DoTranAnalysis(const TranAnalysis tran_analysis) {
     double t_start = tran_analysis.t_start;
     double t_stop = tran_analysis.t_stop;
     double t_step = tran_analysis.t_step;
     int scan_num = (t_stop - t_start) / t_step;
 
-    TranAnalysisMat tran_analysis_mat = BackEuler(circuit, t_step);
-
-    int total_node_num = tran_analysis_mat.node_vec.size();
+    bool linear = circuit->diode_vec.empty();
+    // The sparse solvers get a linear circuit assembled straight into CSC
+    bool sparse = linear && SparseAssembly();
 
     // Remove the ground node
-    mat MNA =
-        tran_analysis_mat.MNA(span(1, total_node_num - 1), span(1, total_node_num - 1));
+    TranAnalysisMat tran_analysis_mat;
+    SparseSystem system;
+    mat MNA;
+    mat RHS_gen;
+    std::vector<NodeName> MNA_node_vec;
+    if (sparse) {
+        system = SparseBackEuler(*circuit, macromodel_vec, t_step);
+        MNA_node_vec = system.node_vec;
+    } else {
+        tran_analysis_mat = AssembleTran(t_step);
+        int total_node_num = tran_analysis_mat.node_vec.size();
+        MNA = tran_analysis_mat.MNA(span(1, total_node_num - 1),
+                                    span(1, total_node_num - 1));
+        RHS_gen = tran_analysis_mat.RHS_gen(span(1, total_node_num - 1),
+                                            span(1, total_node_num - 1));
+        MNA_node_vec = tran_analysis_mat.node_vec;
+        MNA_node_vec.erase(MNA_node_vec.begin());
+    }
 
-    std::vector<NodeName> MNA_node_vec = tran_analysis_mat.node_vec;
-    std::vector<NodeName>::iterator h = MNA_node_vec.begin();
-    MNA_node_vec.erase(h);
+    // Only the sources are read from the circuit while stepping
+    std::vector<Vsrc> vsrc_vec = circuit->vsrc_vec;
+    std::vector<Isrc> isrc_vec = circuit->isrc_vec;
+    ReleaseCircuit();
+
+    // Their rows are looked up once, not at every step
+    QHash<NodeName, int> index_map;
+    for (std::size_t i = 0; i < MNA_node_vec.size(); i++)
+        index_map.insert(MNA_node_vec[i], i);
+    std::vector<int> vsrc_index_vec;
+    for (auto vsrc : vsrc_vec)
+        vsrc_index_vec.push_back(index_map.value("i_" + vsrc.name, -1));
+    std::vector<int> isrc_node_1_vec;
+    std::vector<int> isrc_node_2_vec;
+    for (auto isrc : isrc_vec) {
+        isrc_node_1_vec.push_back(index_map.value(isrc.node_1, -1));
+        isrc_node_2_vec.push_back(index_map.value(isrc.node_2, -1));
+    }
 
-    mat RHS_gen = tran_analysis_mat.RHS_gen(span(1, total_node_num - 1),
-                                            span(1, total_node_num - 1));
+    // Only the probed unknowns are kept for every time point; the full solution
+    // of the previous step is all that is needed to advance.
+    std::vector<NodeName> saved_node_vec;
+    arma::uvec saved_index = SavedIndex(MNA_node_vec, saved_node_vec);
+
+    vec last_result(MNA_node_vec.size(), arma::fill::zeros);
+    WaveformStore waveform = NewWaveformStore(saved_node_vec);
+
+    // Points go to the raw file as soon as they are solved.
+    RawWriter raw_writer;
+    OpenRawFile(raw_writer, "Transient Analysis", "time", "time", saved_node_vec, false);
+
+    vec saved_result(saved_index.n_elem, arma::fill::zeros);
+    waveform.Append(t_start, saved_result.memptr());
+    raw_writer.AppendPoint(t_start, saved_result);
+
+    // The matrix is the same for every time step, factor it once.
+    FactorCache local_factor;
+    FactorCache& factor = Incremental() ? session->factor : local_factor;
+    bool factored = sparse ? PrepareFactor(factor, system.matrix)
+                           : linear && PrepareFactor(factor, MNA);
+    if (sparse && !factored) {
+        cout << "Singular matrix, TRAN analysis skipped" << endl;
+        tran_result = TranResult{waveform, saved_node_vec};
+        return false;
+    }
 
-    mat tran_result_mat(total_node_num - 1, scan_num + 1, arma::fill::zeros);
-    std::vector<double> time_point_vec;
+    bool completed = true;
 
-    time_point_vec.push_back(t_start);
+    int newton_iterations = GetOptionValue(options, "newtoniter", NEWTON_MAX_ITERATIONS);
+    NewtonStats newton_stats;
 
     // cout << "MNA: " << endl << MNA << endl;
     // cout << "RHS_gen: " << endl << RHS_gen << endl;
 
     for (int i = 0; i < scan_num; i++) {
-        time_point_vec.push_back(t_start + (i + 1) * t_step);
-
-        mat RHS_t_h = RHS_gen * tran_result_mat.col(i);
+        vec RHS_t_h = sparse ? Multiply(system.rhs_gen, last_result)
+                             : vec(RHS_gen * last_result);
 
         // voltage source up
-        for (auto vsrc : circuit.vsrc_vec) {
-            int index = FindNode(MNA_node_vec, "i_" + vsrc.name);
-            double value = GetVsrcValue(vsrc, t_start + (i + 1) * t_step);
-            RHS_t_h(index, 0) = value;
+        for (std::size_t k = 0; k < vsrc_vec.size(); k++) {
+            double value = GetVsrcValue(vsrc_vec[k], t_start + (i + 1) * t_step);
+            RHS_t_h(vsrc_index_vec[k]) = value;
         }
 
         // Source source up
-        for (auto isrc : circuit.isrc_vec) {
-            int node_1_index = FindNode(MNA_node_vec, isrc.node_1);
-            int node_2_index = FindNode(MNA_node_vec, isrc.node_2);
-            if (node_1_index >= 0)
-                RHS_t_h(node_1_index, 0) += -1 * isrc.tran_const_value;
-            if (node_2_index >= 0)
-                RHS_t_h(node_2_index, 0) += 1 * isrc.tran_const_value;
+        for (std::size_t k = 0; k < isrc_vec.size(); k++) {
+            if (isrc_node_1_vec[k] >= 0)
+                RHS_t_h(isrc_node_1_vec[k]) += -1 * isrc_vec[k].tran_const_value;
+            if (isrc_node_2_vec[k] >= 0)
+                RHS_t_h(isrc_node_2_vec[k]) += 1 * isrc_vec[k].tran_const_value;
         }
 
         vec tran_result;
 
-        if (!circuit.diode_vec.empty()) {
-            // Nonlinear
-            vec result_n(total_node_num - 1, arma::fill::zeros);
-            vec result_n_plus_1(total_node_num - 1, arma::fill::zeros);
-
-            while (true) {
-                // Update the analysis matrix
-                mat mna = AddExpTerm(tran_analysis_mat.exp_analysis_vec, result_n, MNA);
-                // Update RHS
-                mat rhs = AddExpTerm(tran_analysis_mat.exp_rhs_vec, result_n, RHS_t_h);
-                // cout << "reduced_mat:" << endl << MNA << endl;
-                // cout << "scan_rhs" << endl << RHS_t_h << endl;
-
-                result_n_plus_1 = arma::solve(mna, rhs, arma::solve_opts::allow_ugly);
-                if (VecDifference(result_n, result_n_plus_1))
-                    break;
-                result_n = result_n_plus_1;
+        if (!linear) {
+            // Nonlinear, from the previous time step
+            tran_result = last_result;
+            if (!NewtonSolve(MNA, tran_analysis_mat.exp_analysis_vec, RHS_t_h,
+                             tran_analysis_mat.exp_rhs_vec, newton_iterations, tran_result,
+                             newton_stats)) {
+                // The step is kept, but the run is not complete
+                cout << "Newton did not converge at " << t_start + (i + 1) * t_step << endl;
+                completed = false;
             }
-            tran_result = result_n_plus_1;
         }
         // Linear
-        else {
+        else if (factored) {
+            // The previous time step starts the iterative solver
+            tran_result = factor.Solve(RHS_t_h.col(0), last_result);
+        } else {
             tran_result = arma::solve(MNA, RHS_t_h);
         }
 
-        tran_result_mat.col(i + 1) = tran_result;
+        last_result = tran_result;
+
+        saved_result = tran_result.elem(saved_index);
+        waveform.Append(t_start + (i + 1) * t_step, saved_result.memptr());
+        raw_writer.AppendPoint(t_start + (i + 1) * t_step, saved_result);
+
+        if (!ReportStep(i + 1, scan_num, t_start + (i + 1) * t_step, saved_node_vec,
+                        saved_result.memptr())) {
+            cout << "TRAN analysis stopped at " << t_start + (i + 1) * t_step << endl;
+            completed = false;
+            break;
+        }
     }
-    tran_result = TranResult{tran_result_mat, time_point_vec, MNA_node_vec};
+    if (factored)
+        PrintSolverSummary(factor);
+    PrintNewtonSummary(newton_stats);
+    PrintWaveformSummary(waveform);
+    tran_result = TranResult{waveform, saved_node_vec};
+    return completed;
 }
 
-TranAnalysisMat BackEuler(const Circuit circuit, const double h) {
+/**
+ * @brief The backward Euler matrices of the circuit, restamped from the last
+ * run's in incremental mode (see AssembleDc())
+ *
+ * @param h time step
+ * @return TranAnalysisMat
+ */
+TranAnalysisMat Analyzer::AssembleTran(const double h) {
+    if (!Incremental())
+        return BackEuler(*circuit, macromodel_vec, h);
+
+    std::vector<DeviceName> changed_vec;
+    Circuit old_circuit;
+    if (session->analysis_type == TRAN && session->t_step == h && macromodel_vec.empty() &&
+        Flatten(*session->circuit, old_circuit) &&
+        DiffCircuit(old_circuit, *circuit, changed_vec)) {
+        RestampTran(session->tran_matrix, old_circuit, *circuit, h);
+        cout << "Incremental: " << changed_vec.size() << " devices changed" << endl;
+    } else {
+        cout << "Incremental: circuit changed, matrices rebuilt" << endl;
+        session->Clear();
+        session->analysis_type = TRAN;
+        session->t_step = h;
+        session->tran_matrix = BackEuler(*circuit, macromodel_vec, h);
+    }
+    session->circuit = parsed;
+    return session->tran_matrix;
+}
+
+TranAnalysisMat BackEuler(const Circuit& circuit,
+                          const std::vector<Macromodel>& macromodel_vec, const double h) {
     // ----- Generate NA metrix -----
     int node_num = circuit.node_vec.size();
     mat NA(node_num, node_num, arma::fill::zeros);
@@ -136,6 +228,11 @@ TranAnalysisMat BackEuler(const Circuit circuit, const double h) {
     for (Vsrc vsrc : circuit.vsrc_vec)
         modified_node_vec.push_back("i_" + vsrc.name);
 
+    // Every macromodel state is one more unknown
+    for (auto& macromodel : macromodel_vec)
+        for (int k = 0; k < macromodel.state_num; k++)
+            modified_node_vec.push_back(macromodel.State(k));
+
     // Initialize MNA metrix
     int modified_node_num = modified_node_vec.size();
     mat MNA = NA;
@@ -187,25 +284,44 @@ TranAnalysisMat BackEuler(const Circuit circuit, const double h) {
         // RHS_gen(branch_index, node_2_index) += -1;
     }
 
+    // Add macromodel stamps, G + C / h
+    for (auto& macromodel : macromodel_vec) {
+        std::vector<int> index_vec;
+        for (auto& port : macromodel.port_vec)
+            index_vec.push_back(FindNode(modified_node_vec, port));
+        for (int k = 0; k < macromodel.state_num; k++)
+            index_vec.push_back(FindNode(modified_node_vec, macromodel.State(k)));
+        for (std::size_t i = 0; i < index_vec.size(); i++) {
+            for (std::size_t j = 0; j < index_vec.size(); j++) {
+                MNA(index_vec[i], index_vec[j]) +=
+                    macromodel.g(i, j) + macromodel.c(i, j) / h;
+                RHS_gen(index_vec[i], index_vec[j]) += macromodel.c(i, j) / h;
+            }
+        }
+    }
+
     // Add Diode stamps
     std::vector<ExpTerm> exp_analysis_vec;
     std::vector<ExpTerm> exp_rhs_vec;
     for (Diode diode : circuit.diode_vec) {
         int node_1_index = FindNode(circuit.node_vec, diode.node_1);
         int node_2_index = FindNode(circuit.node_vec, diode.node_2);
+        // i = i_sat (e^{40 x} - 1), g = di/dx = 40 i_sat e^{40 x}
+        double i_sat = DiodeSaturationCurrent(diode.model);
+        double g = 40 * i_sat;
         exp_analysis_vec.push_back(ExpTerm(node_1_index, node_1_index, node_1_index,
-                                           node_2_index, ExpCoeff(40, 40)));
+                                           node_2_index, ExpCoeff(g, 40)));
         exp_analysis_vec.push_back(ExpTerm(node_1_index, node_2_index, node_1_index,
-                                           node_2_index, ExpCoeff(-40, 40)));
+                                           node_2_index, ExpCoeff(-g, 40)));
         exp_analysis_vec.push_back(ExpTerm(node_2_index, node_1_index, node_1_index,
-                                           node_2_index, ExpCoeff(-40, 40)));
+                                           node_2_index, ExpCoeff(-g, 40)));
         exp_analysis_vec.push_back(ExpTerm(node_2_index, node_2_index, node_1_index,
-                                           node_2_index, ExpCoeff(40, 40)));
+                                           node_2_index, ExpCoeff(g, 40)));
 
         exp_rhs_vec.push_back(ExpTerm(node_1_index, node_1_index, node_2_index,
-                                      ExpCoeff(-1, 40, 1), ExpCoeff(40, 40)));
+                                      ExpCoeff(-i_sat, 40, i_sat), ExpCoeff(g, 40)));
         exp_rhs_vec.push_back(ExpTerm(node_2_index, node_1_index, node_2_index,
-                                      ExpCoeff(1, 40, -1), ExpCoeff(-40, 40)));
+                                      ExpCoeff(i_sat, 40, -i_sat), ExpCoeff(-g, 40)));
     }
 
     TranAnalysisMat tran_analysis_mat(MNA, exp_analysis_vec, modified_node_vec, RHS_gen,
@@ -214,6 +330,102 @@ TranAnalysisMat BackEuler(const Circuit circuit, const double h) {
     return tran_analysis_mat;
 }
 
+/**
+ * @brief The stamps of BackEuler() for a linear circuit, assembled into CSC
+ * with ground removed, for the sparse solvers
+ *
+ * @param circuit flat, without diodes
+ * @param macromodel_vec
+ * @param h time step
+ * @return SparseSystem
+ */
+SparseSystem SparseBackEuler(const Circuit& circuit,
+                             const std::vector<Macromodel>& macromodel_vec,
+                             const double h) {
+    SparseStamper stamper(circuit.node_vec);
+    for (Ind ind : circuit.ind_vec)
+        stamper.AddUnknown("i_" + ind.name);
+    for (Cap cap : circuit.cap_vec)
+        stamper.AddUnknown("i_" + cap.name);
+    for (Vsrc vsrc : circuit.vsrc_vec)
+        stamper.AddUnknown("i_" + vsrc.name);
+    for (auto& macromodel : macromodel_vec)
+        for (int k = 0; k < macromodel.state_num; k++)
+            stamper.AddUnknown(macromodel.State(k));
+
+    // RHS_gen has the same unknowns, its triplets are kept apart
+    std::vector<Triplet> rhs_gen_vec;
+    auto add_rhs_gen = [&](const int row, const int col, const double value) {
+        if (row >= 0 && col >= 0)
+            rhs_gen_vec.push_back(Triplet{row, col, value});
+    };
+    // The current of a branch unknown, from node_1 to node_2, into the KCL rows
+    auto add_branch = [&](const int branch_index, const int node_1_index,
+                          const int node_2_index) {
+        stamper.Add(node_1_index, branch_index, 1);
+        stamper.Add(node_2_index, branch_index, -1);
+    };
+
+    for (Res res : circuit.res_vec)
+        stamper.AddConductance(stamper.Index(res.node_1), stamper.Index(res.node_2),
+                               1 / res.value);
+
+    for (Ind ind : circuit.ind_vec) {
+        int node_1_index = stamper.Index(ind.node_1);
+        int node_2_index = stamper.Index(ind.node_2);
+        int branch_index = stamper.Index("i_" + ind.name);
+        stamper.Add(branch_index, node_1_index, 1);
+        stamper.Add(branch_index, node_2_index, -1);
+        stamper.Add(branch_index, branch_index, -1 * ind.value / h);
+        add_branch(branch_index, node_1_index, node_2_index);
+        add_rhs_gen(branch_index, branch_index, -1 * ind.value / h);
+    }
+
+    for (Cap cap : circuit.cap_vec) {
+        int node_1_index = stamper.Index(cap.node_1);
+        int node_2_index = stamper.Index(cap.node_2);
+        int branch_index = stamper.Index("i_" + cap.name);
+        stamper.Add(branch_index, node_1_index, cap.value / h);
+        stamper.Add(branch_index, node_2_index, -1 * cap.value / h);
+        stamper.Add(branch_index, branch_index, -1);
+        add_branch(branch_index, node_1_index, node_2_index);
+        add_rhs_gen(branch_index, node_1_index, cap.value / h);
+        add_rhs_gen(branch_index, node_2_index, -1 * cap.value / h);
+    }
+
+    for (Vsrc vsrc : circuit.vsrc_vec) {
+        int node_1_index = stamper.Index(vsrc.node_1);
+        int node_2_index = stamper.Index(vsrc.node_2);
+        int branch_index = stamper.Index("i_" + vsrc.name);
+        stamper.Add(branch_index, node_1_index, 1);
+        stamper.Add(branch_index, node_2_index, -1);
+        add_branch(branch_index, node_1_index, node_2_index);
+    }
+
+    // Macromodels, G + C / h
+    for (auto& macromodel : macromodel_vec) {
+        std::vector<int> index_vec;
+        for (auto& port : macromodel.port_vec)
+            index_vec.push_back(stamper.Index(port));
+        for (int k = 0; k < macromodel.state_num; k++)
+            index_vec.push_back(stamper.Index(macromodel.State(k)));
+        for (std::size_t i = 0; i < index_vec.size(); i++) {
+            for (std::size_t j = 0; j < index_vec.size(); j++) {
+                stamper.Add(index_vec[i], index_vec[j],
+                            macromodel.g(i, j) + macromodel.c(i, j) / h);
+                add_rhs_gen(index_vec[i], index_vec[j], macromodel.c(i, j) / h);
+            }
+        }
+    }
+
+    SparseSystem system;
+    system.matrix = stamper.Matrix();
+    int unknown_num = stamper.node_vec.size();
+    system.rhs_gen = FromTriplets(unknown_num, unknown_num, rhs_gen_vec);
+    system.node_vec = stamper.node_vec;
+    return system;
+}
+
 // TODO
 // TranAnalysisMat TrapezoidalRule(Circuit circuit, double h) {}
 
@@ -0,0 +1,314 @@
+/**
+ * @file waveform_store.cpp
+ * @author Yaotian Liu
+ * @brief Compressed, chunked storage of analysis waveforms
+ * @date 2026-10-19
+ */
+
+#include "waveform_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// First byte of an encoded signal
+const uint8_t ENCODING_XOR = 0;
+const uint8_t ENCODING_QUANTIZED = 1;
+
+// XOR header for a value equal to the previous one
+const uint8_t XOR_REPEAT = 0xff;
+
+// Quantized values must stay exact in a double
+const double MAX_QUANTIZED = 4503599627370496.0;  // 2^52
+
+uint64_t DoubleBits(const double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double BitsDouble(const uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief XOR every value with the one before it and keep only the bytes that
+ * changed. Neighbouring samples share sign, exponent and the high mantissa
+ * bytes, so most points take 3-6 bytes instead of 8.
+ * Per value: a header byte (leading zero bytes << 4 | trailing zero bytes),
+ * then the remaining bytes, low first.
+ */
+void EncodeXor(const double* value, const std::size_t stride, const std::size_t num,
+               std::vector<uint8_t>& data) {
+    data.push_back(ENCODING_XOR);
+
+    uint64_t last = 0;
+    for (std::size_t i = 0; i < num; i++) {
+        uint64_t bits = DoubleBits(value[i * stride]);
+        uint64_t diff = bits ^ last;
+        last = bits;
+
+        if (diff == 0) {
+            data.push_back(XOR_REPEAT);
+            continue;
+        }
+
+        int leading = 0, trailing = 0;
+        while (((diff >> (56 - 8 * leading)) & 0xff) == 0)
+            leading++;
+        while (((diff >> (8 * trailing)) & 0xff) == 0)
+            trailing++;
+
+        data.push_back(uint8_t(leading << 4 | trailing));
+        for (int b = trailing; b < 8 - leading; b++)
+            data.push_back(uint8_t(diff >> (8 * b)));
+    }
+}
+
+void DecodeXor(const uint8_t* data, const std::size_t num, double* value) {
+    uint64_t last = 0;
+    for (std::size_t i = 0; i < num; i++) {
+        uint8_t header = *data++;
+        if (header != XOR_REPEAT) {
+            int leading = header >> 4, trailing = header & 0x0f;
+            uint64_t diff = 0;
+            for (int b = trailing; b < 8 - leading; b++)
+                diff |= uint64_t(*data++) << (8 * b);
+            last ^= diff;
+        }
+        value[i] = BitsDouble(last);
+    }
+}
+
+void PutVarint(uint64_t value, std::vector<uint8_t>& data) {
+    while (value >= 0x80) {
+        data.push_back(uint8_t(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(uint8_t(value));
+}
+
+uint64_t GetVarint(const uint8_t*& data) {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *data++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+/**
+ * @brief Round every value to a multiple of 2 * tolerance (so the error is at
+ * most `tolerance`) and store the zigzag varint of the difference between
+ * neighbouring multiples; a settled node costs one byte per point.
+ *
+ * @return false : Values too large for the tolerance, nothing written
+ */
+bool EncodeQuantized(const double* value, const std::size_t stride, const std::size_t num,
+                     const double tolerance, std::vector<uint8_t>& data) {
+    double step = 2 * tolerance;
+    for (std::size_t i = 0; i < num; i++)
+        if (!(std::fabs(value[i * stride] / step) < MAX_QUANTIZED))
+            return false;
+
+    data.push_back(ENCODING_QUANTIZED);
+
+    int64_t last = 0;
+    for (std::size_t i = 0; i < num; i++) {
+        int64_t level = std::llround(value[i * stride] / step);
+        int64_t delta = level - last;
+        last = level;
+        PutVarint(uint64_t(delta) << 1 ^ uint64_t(delta >> 63), data);
+    }
+    return true;
+}
+
+void DecodeQuantized(const uint8_t* data, const std::size_t num, const double tolerance,
+                     double* value) {
+    double step = 2 * tolerance;
+    int64_t last = 0;
+    for (std::size_t i = 0; i < num; i++) {
+        uint64_t zigzag = GetVarint(data);
+        last += int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+        value[i] = last * step;
+    }
+}
+
+void EncodeSignal(const double* value, const std::size_t stride, const std::size_t num,
+                  const double tolerance, std::vector<uint8_t>& data) {
+    if (tolerance > 0 && EncodeQuantized(value, stride, num, tolerance, data))
+        return;
+    EncodeXor(value, stride, num, data);
+}
+
+void DecodeSignal(const std::vector<uint8_t>& data, const std::size_t num,
+                  const double tolerance, double* value) {
+    if (data[0] == ENCODING_QUANTIZED)
+        DecodeQuantized(data.data() + 1, num, tolerance, value);
+    else
+        DecodeXor(data.data() + 1, num, value);
+}
+
+/**
+ * @brief Construct a new, empty store
+ *
+ * @param tolerance_vec one absolute tolerance per signal, 0 keeps it lossless
+ */
+WaveformStore::WaveformStore(const std::vector<double>& tolerance_vec)
+    : tolerance_vec(tolerance_vec) {
+    open_x_vec.reserve(WAVEFORM_CHUNK_SIZE);
+    open_value_vec.reserve(WAVEFORM_CHUNK_SIZE * tolerance_vec.size());
+}
+
+/**
+ * @brief Append one point
+ *
+ * @param x sweep value or time, not smaller than the previous one
+ * @param value SignalNum() values
+ */
+void WaveformStore::Append(const double x, const double* value) {
+    open_x_vec.push_back(x);
+    open_value_vec.insert(open_value_vec.end(), value, value + SignalNum());
+
+    if (open_x_vec.size() == WAVEFORM_CHUNK_SIZE)
+        CloseChunk();
+}
+
+void WaveformStore::CloseChunk() {
+    WaveformChunk chunk;
+    chunk.first_point = PointNum() - open_x_vec.size();
+    chunk.point_num = open_x_vec.size();
+    chunk.x_first = open_x_vec.front();
+    chunk.x_last = open_x_vec.back();
+
+    EncodeXor(open_x_vec.data(), 1, chunk.point_num, chunk.x_data);
+
+    chunk.signal_data_vec.resize(SignalNum());
+    for (std::size_t s = 0; s < SignalNum(); s++)
+        EncodeSignal(open_value_vec.data() + s, SignalNum(), chunk.point_num,
+                     tolerance_vec[s], chunk.signal_data_vec[s]);
+
+    chunk_vec.push_back(std::move(chunk));
+    open_x_vec.clear();
+    open_value_vec.clear();
+}
+
+std::size_t WaveformStore::PointNum() const {
+    if (chunk_vec.empty())
+        return open_x_vec.size();
+    return chunk_vec.back().first_point + chunk_vec.back().point_num + open_x_vec.size();
+}
+
+/**
+ * @brief Memory held by the samples, encoded chunks plus the open chunk
+ */
+std::size_t WaveformStore::StoredBytes() const {
+    std::size_t bytes = (open_x_vec.size() + open_value_vec.size()) * sizeof(double);
+    for (auto& chunk : chunk_vec) {
+        bytes += chunk.x_data.size();
+        for (auto& data : chunk.signal_data_vec)
+            bytes += data.size();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Read one signal in [x_from, x_to]. Only the chunks overlapping the
+ * window are decoded.
+ *
+ * @param signal
+ * @param x_from
+ * @param x_to
+ * @param x_vec output
+ * @param y_vec output
+ */
+void WaveformStore::ReadWindow(const std::size_t signal, const double x_from,
+                               const double x_to, std::vector<double>& x_vec,
+                               std::vector<double>& y_vec) const {
+    x_vec.clear();
+    y_vec.clear();
+    if (signal >= SignalNum())
+        return;
+
+    auto first = std::lower_bound(
+        chunk_vec.begin(), chunk_vec.end(), x_from,
+        [](const WaveformChunk& chunk, const double x) { return chunk.x_last < x; });
+
+    std::vector<double> chunk_x(WAVEFORM_CHUNK_SIZE), chunk_y(WAVEFORM_CHUNK_SIZE);
+    for (auto it = first; it != chunk_vec.end() && it->x_first <= x_to; it++) {
+        DecodeXor(it->x_data.data() + 1, it->point_num, chunk_x.data());
+        DecodeSignal(it->signal_data_vec[signal], it->point_num, tolerance_vec[signal],
+                     chunk_y.data());
+
+        for (std::size_t i = 0; i < it->point_num; i++) {
+            if (chunk_x[i] < x_from || chunk_x[i] > x_to)
+                continue;
+            x_vec.push_back(chunk_x[i]);
+            y_vec.push_back(chunk_y[i]);
+        }
+    }
+
+    for (std::size_t i = 0; i < open_x_vec.size(); i++) {
+        if (open_x_vec[i] < x_from || open_x_vec[i] > x_to)
+            continue;
+        x_vec.push_back(open_x_vec[i]);
+        y_vec.push_back(open_value_vec[i * SignalNum() + signal]);
+    }
+}
+
+/**
+ * @brief Decode the whole x axis into one contiguous array
+ */
+void WaveformStore::ReadX(std::vector<double>& x_vec) const {
+    x_vec.resize(PointNum());
+    for (auto& chunk : chunk_vec)
+        DecodeXor(chunk.x_data.data() + 1, chunk.point_num, x_vec.data() + chunk.first_point);
+    std::copy(open_x_vec.begin(), open_x_vec.end(), x_vec.end() - open_x_vec.size());
+}
+
+/**
+ * @brief Decode one signal over the whole run into one contiguous array
+ */
+void WaveformStore::ReadSignal(const std::size_t signal, std::vector<double>& y_vec) const {
+    y_vec.clear();
+    if (signal >= SignalNum())
+        return;
+
+    y_vec.resize(PointNum());
+    for (auto& chunk : chunk_vec)
+        DecodeSignal(chunk.signal_data_vec[signal], chunk.point_num, tolerance_vec[signal],
+                     y_vec.data() + chunk.first_point);
+
+    double* tail = y_vec.data() + y_vec.size() - open_x_vec.size();
+    for (std::size_t i = 0; i < open_x_vec.size(); i++)
+        tail[i] = open_value_vec[i * SignalNum() + signal];
+}
+
+WaveformView::WaveformView(std::shared_ptr<const WaveformStore> waveform)
+    : waveform(waveform),
+      signal_decoded_vec(waveform->SignalNum(), false),
+      signal_vec(waveform->SignalNum()) {}
+
+SignalView WaveformView::X() {
+    if (!x_decoded) {
+        waveform->ReadX(x_vec);
+        x_decoded = true;
+    }
+    return SignalView(x_vec);
+}
+
+/**
+ * @brief Samples of one signal, empty for an unknown signal
+ */
+SignalView WaveformView::Signal(const std::size_t signal) {
+    if (signal >= signal_vec.size())
+        return SignalView();
+    if (!signal_decoded_vec[signal]) {
+        waveform->ReadSignal(signal, signal_vec[signal]);
+        signal_decoded_vec[signal] = true;
+    }
+    return SignalView(signal_vec[signal]);
+}
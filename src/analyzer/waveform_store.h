@@ -0,0 +1,90 @@
+/**
+ * @file waveform_store.h
+ * @author Yaotian Liu
+ * @brief Compressed, chunked storage of analysis waveforms
+ * @date 2026-10-19
+ */
+
+#if !defined(WAVEFORM_STORE_H)
+#define WAVEFORM_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "signal_view.h"
+
+// Points per chunk; the unit of random access.
+const std::size_t WAVEFORM_CHUNK_SIZE = 1024;
+
+/**
+ * @brief One block of points: the x axis and every signal, each encoded on its
+ * own so a reader only decodes the signal it asks for.
+ */
+struct WaveformChunk {
+    std::size_t first_point;
+    std::size_t point_num;
+    double x_first;
+    double x_last;
+    std::vector<uint8_t> x_data;
+    std::vector<std::vector<uint8_t>> signal_data_vec;
+};
+
+/**
+ * @brief Append-only waveform container written by the sweep and transient
+ * engines. Closed chunks are encoded either lossless (XOR with the previous
+ * value, only the changed bytes are kept) or, when the signal has a tolerance,
+ * quantized to that tolerance and delta encoded. The x axis is always
+ * lossless and must not decrease, which lets the chunk index answer a time
+ * window with a binary search.
+ */
+class WaveformStore {
+  public:
+    WaveformStore() {}
+    WaveformStore(const std::vector<double>& tolerance_vec);
+
+    void Append(const double x, const double* value);
+
+    std::size_t SignalNum() const { return tolerance_vec.size(); }
+    std::size_t PointNum() const;
+    std::size_t StoredBytes() const;
+
+    void ReadWindow(const std::size_t signal, const double x_from, const double x_to,
+                    std::vector<double>& x_vec, std::vector<double>& y_vec) const;
+    void ReadX(std::vector<double>& x_vec) const;
+    void ReadSignal(const std::size_t signal, std::vector<double>& y_vec) const;
+
+  private:
+    std::vector<double> tolerance_vec;  // Absolute, per signal; 0 for lossless
+    std::vector<WaveformChunk> chunk_vec;
+
+    // Points of the chunk being filled, kept raw until it is full
+    std::vector<double> open_x_vec;
+    std::vector<double> open_value_vec;  // Point major
+
+    void CloseChunk();
+};
+
+/**
+ * @brief Per signal, contiguous samples of a waveform store. The x axis and
+ * each signal are decoded once, on first use, and then shared by every
+ * consumer as a SignalView.
+ */
+class WaveformView {
+  public:
+    WaveformView(std::shared_ptr<const WaveformStore> waveform);
+
+    std::shared_ptr<const WaveformStore> Store() const { return waveform; }
+    SignalView X();
+    SignalView Signal(const std::size_t signal);
+
+  private:
+    std::shared_ptr<const WaveformStore> waveform;
+    bool x_decoded = false;
+    std::vector<double> x_vec;
+    std::vector<bool> signal_decoded_vec;
+    std::vector<std::vector<double>> signal_vec;
+};
+
+#endif  // WAVEFORM_STORE_H
@@ -0,0 +1,366 @@
+/**
+ * @file batch_farm.cpp
+ * @author Yaotian Liu
+ * @brief Headless batch runs: a farm of local worker processes
+ * @date 2026-10-19
+ */
+
+#include "batch_farm.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <iostream>
+
+#include "../parser/parser.h"
+#include "../utils/utils.h"
+
+using std::cout;
+using std::endl;
+
+/**
+ * @brief Read a `key: value kB` line of /proc/<pid>/status (Linux only)
+ *
+ * @param pid process id, or "self"
+ * @param key e.g. VmRSS, VmHWM
+ * @return qint64 0 if not available
+ */
+qint64 ReadProcessKb(const QString pid, const QString key) {
+    QFile file("/proc/" + pid + "/status");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return 0;
+
+    // Files of /proc report a size of 0, read until the end instead
+    while (!file.atEnd()) {
+        QString line = QString::fromLatin1(file.readLine());
+        if (line.startsWith(key + ":"))
+            return line.mid(key.size() + 1).simplified().split(' ').first().toLongLong();
+    }
+    return 0;
+}
+
+/**
+ * @brief Read the key=value lines a job writes to <prefix>.stats
+ */
+QMap<QString, QString> ReadStats(const QString prefix) {
+    QMap<QString, QString> stats;
+    QFile file(prefix + ".stats");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return stats;
+
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+        int equal = line.indexOf('=');
+        if (equal > 0)
+            stats[line.left(equal)] = line.mid(equal + 1);
+    }
+    return stats;
+}
+
+BatchFarm::BatchFarm(const BatchOptions& options) : options(options) {
+    if (this->options.job_num <= 0)
+        this->options.job_num = std::max(1, QThread::idealThreadCount());
+}
+
+/**
+ * @brief Read the manifest: one deck per line, relative to the manifest.
+ * Empty lines and lines starting with `#` are skipped.
+ *
+ * @return true : Loaded, output directory created
+ * @return false : Cannot read the manifest or create the output directory
+ */
+bool BatchFarm::LoadManifest() {
+    QFile file(options.manifest);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        cout << "Cannot open manifest " << options.manifest << endl;
+        return false;
+    }
+
+    if (options.out_dir.isEmpty())
+        options.out_dir = options.manifest + ".out";
+    if (!QDir().mkpath(options.out_dir)) {
+        cout << "Cannot create " << options.out_dir << endl;
+        return false;
+    }
+    // The jobs share their parsed includes through here, see SetIncludeCacheDir()
+    include_cache_dir = QDir(options.out_dir).absoluteFilePath("include_cache");
+    if (!QDir().mkpath(include_cache_dir))
+        include_cache_dir.clear();
+
+    QDir manifest_dir = QFileInfo(options.manifest).absoluteDir();
+    QDir out_dir(options.out_dir);
+
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        auto job = std::make_unique<BatchJob>();
+        job->deck = manifest_dir.absoluteFilePath(line);
+        job->prefix = out_dir.absoluteFilePath(QString("%1_%2")
+                                                   .arg(job_vec.size() + 1, 4, 10, QChar('0'))
+                                                   .arg(QFileInfo(line).completeBaseName()));
+        job_vec.push_back(std::move(job));
+    }
+
+    for (auto it = job_vec.rbegin(); it != job_vec.rend(); it++)
+        waiting_vec.push_back(it->get());
+
+    cout << "Manifest " << options.manifest << ": " << job_vec.size() << " decks" << endl;
+    return true;
+}
+
+/**
+ * @brief Run every job of the manifest
+ *
+ * @return int 0 if every job succeeded, 1 otherwise
+ */
+int BatchFarm::Run() {
+    QElapsedTimer wall_timer;
+    wall_timer.start();
+
+    cout << "Running on up to " << options.job_num << " worker processes";
+    if (options.mem_budget_mb > 0)
+        cout << " within " << options.mem_budget_mb << " MB";
+    cout << endl;
+
+    while (!waiting_vec.empty() || running_num > 0) {
+        while (!waiting_vec.empty() && CanStart()) {
+            BatchJob* job = waiting_vec.back();
+            waiting_vec.pop_back();
+            Start(*job);
+        }
+
+        QCoreApplication::processEvents(QEventLoop::AllEvents, BATCH_POLL_MS);
+        QThread::msleep(BATCH_POLL_MS);
+
+        for (auto& job : job_vec)
+            if (job->process)
+                Poll(*job);
+    }
+
+    PrintSummary(wall_timer.elapsed() / 1000.0);
+
+    for (auto& job : job_vec)
+        if (job->status != "ok")
+            return 1;
+    return 0;
+}
+
+/**
+ * @brief Whether another job fits: below the process count, and the memory of
+ * the running jobs plus the largest job so far within the budget. One job
+ * always runs, whatever its size.
+ */
+bool BatchFarm::CanStart() {
+    if (running_num == 0)
+        return true;
+    if (running_num >= options.job_num)
+        return false;
+    if (options.mem_budget_mb <= 0)
+        return true;
+
+    qint64 used_kb = 0;
+    for (auto& job : job_vec)
+        if (job->process)
+            used_kb += std::max(job->rss_kb, largest_job_kb);
+    return used_kb + largest_job_kb <= options.mem_budget_mb * 1024;
+}
+
+void BatchFarm::Start(BatchJob& job) {
+    job.attempt++;
+    job.killed = false;
+    job.rss_kb = 0;
+    job.peak_rss_kb = 0;
+    QFile::remove(job.prefix + ".stats");
+
+    job.process = std::make_unique<QProcess>();
+    job.process->setProcessChannelMode(QProcess::MergedChannels);
+    job.process->setStandardOutputFile(job.prefix + ".log");
+    job.timer.start();
+    QStringList arguments{"--job", job.deck, job.prefix};
+    if (!include_cache_dir.isEmpty())
+        arguments << "--include-cache" << include_cache_dir;
+    job.process->start(QCoreApplication::applicationFilePath(), arguments);
+    running_num++;
+}
+
+/**
+ * @brief Check a running job: finished, over its time, over the budget
+ */
+void BatchFarm::Poll(BatchJob& job) {
+    if (job.process->state() == QProcess::NotRunning) {
+        Finish(job);
+        return;
+    }
+    if (job.killed)
+        return;
+
+    job.rss_kb = ReadProcessKb(QString::number(job.process->processId()), "VmRSS");
+    job.peak_rss_kb = std::max(job.peak_rss_kb, job.rss_kb);
+
+    if (options.timeout_s > 0 && job.timer.elapsed() > options.timeout_s * 1000LL) {
+        job.status = "timeout";
+        job.killed = true;
+        job.process->kill();
+    } else if (options.mem_budget_mb > 0 && job.rss_kb > options.mem_budget_mb * 1024) {
+        job.status = "out of memory";
+        job.killed = true;
+        job.process->kill();
+    }
+}
+
+/**
+ * @brief Collect a job that has exited. Crashes are retried up to
+ * `retries` times; deck errors, timeouts and memory kills are not, they
+ * would only happen again.
+ */
+void BatchFarm::Finish(BatchJob& job) {
+    running_num--;
+    job.seconds = job.timer.elapsed() / 1000.0;
+
+    QProcess& process = *job.process;
+    bool crashed = process.exitStatus() == QProcess::CrashExit ||
+                   (process.exitCode() != JOB_OK && process.exitCode() != JOB_DECK_ERROR);
+
+    if (process.error() == QProcess::FailedToStart) {
+        job.status = "failed to start";
+    } else if (job.killed) {
+        // Status set when killed
+    } else if (crashed) {
+        if (job.attempt <= options.retries) {
+            cout << "Retrying " << job.deck << " after a crash (attempt "
+                 << job.attempt + 1 << ")" << endl;
+            retry_num++;
+            job.process.reset();
+            waiting_vec.push_back(&job);
+            return;
+        }
+        job.status = "crashed";
+    } else if (process.exitCode() == JOB_DECK_ERROR) {
+        job.status = "deck error";
+    } else {
+        job.status = "ok";
+    }
+    job.process.reset();
+
+    QMap<QString, QString> stats = ReadStats(job.prefix);
+    job.point_num = stats.value("points").toLongLong();
+    job.step_num = stats.value("steps").toLongLong();
+    job.peak_rss_kb = std::max(job.peak_rss_kb, stats.value("peak_rss_kb").toLongLong());
+    largest_job_kb = std::max(largest_job_kb, job.peak_rss_kb);
+    job.done = true;
+
+    int done_num = 0;
+    for (auto& j : job_vec)
+        done_num += j->done;
+    cout << "[" << done_num << "/" << job_vec.size() << "] " << job.status << "  "
+         << job.deck << "  " << job.seconds << " s" << endl;
+}
+
+/**
+ * @brief Print the totals and write one line per job to <out>/batch.csv
+ */
+void BatchFarm::PrintSummary(const double wall_seconds) {
+    int ok_num = 0;
+    qint64 point_num = 0;
+    double job_seconds = 0;
+    qint64 peak_rss_kb = 0;
+
+    QFile file(QDir(options.out_dir).filePath("batch.csv"));
+    bool csv = file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    QTextStream stream(&file);
+    if (csv)
+        stream << "deck,status,attempts,seconds,peak_rss_kb,points,steps\n";
+
+    for (auto& job : job_vec) {
+        ok_num += job->status == "ok";
+        point_num += job->point_num;
+        job_seconds += job->seconds;
+        peak_rss_kb = std::max(peak_rss_kb, job->peak_rss_kb);
+        if (csv)
+            stream << "\"" << job->deck << "\"," << job->status << "," << job->attempt << ","
+                   << job->seconds << "," << job->peak_rss_kb << ","
+                   << job->point_num << "," << job->step_num << "\n";
+    }
+
+    double wall = std::max(wall_seconds, 1e-3);
+    cout << "------ Batch ------" << endl;
+    cout << "Jobs: " << job_vec.size() << "  ok: " << ok_num
+         << "  failed: " << job_vec.size() - ok_num << "  retries: " << retry_num << endl;
+    cout << "Wall time: " << wall_seconds << " s  Job time: " << job_seconds << " s ("
+         << job_seconds / wall << "x)" << endl;
+    cout << "Throughput: " << job_vec.size() / wall << " decks/s  " << point_num / wall
+         << " points/s" << endl;
+    cout << "Largest job: " << peak_rss_kb / 1024 << " MB" << endl;
+    cout << "Per job results in " << options.out_dir << endl;
+}
+
+void PrintBatchUsage() {
+    cout << "Usage: simpleEDA --batch <manifest> [--out <dir>] [--jobs <n>] "
+            "[--mem <MB>] [--retries <n>] [--timeout <s>]"
+         << endl;
+}
+
+/**
+ * @brief Entry of the modes without a window:
+ *   --batch manifest [options]  run the decks of a manifest on a farm
+ *   --job deck prefix [--include-cache dir]
+ *                               run one deck, started by the farm
+ *
+ * @param arguments command line, program name first
+ * @return int exit code
+ */
+int RunBatchCommand(const QStringList arguments) {
+    int job_index = arguments.indexOf("--job");
+    if (job_index >= 0) {
+        if (job_index + 2 >= arguments.size()) {
+            cout << "Usage: simpleEDA --job <deck> <output prefix>" << endl;
+            return JOB_DECK_ERROR;
+        }
+        int cache_index = arguments.indexOf("--include-cache");
+        if (cache_index >= 0 && cache_index + 1 < arguments.size())
+            SetIncludeCacheDir(arguments[cache_index + 1]);
+        return RunJob(arguments[job_index + 1], arguments[job_index + 2]);
+    }
+
+    BatchOptions options;
+    for (int i = 1; i < arguments.size(); i++) {
+        QString arg = arguments[i];
+        bool has_value = i + 1 < arguments.size();
+        if (arg == "--batch" && has_value)
+            options.manifest = arguments[++i];
+        else if (arg == "--out" && has_value)
+            options.out_dir = arguments[++i];
+        else if (arg == "--jobs" && has_value)
+            options.job_num = arguments[++i].toInt();
+        else if (arg == "--mem" && has_value)
+            options.mem_budget_mb = arguments[++i].toLongLong();
+        else if (arg == "--retries" && has_value)
+            options.retries = arguments[++i].toInt();
+        else if (arg == "--timeout" && has_value)
+            options.timeout_s = arguments[++i].toInt();
+        else {
+            cout << "Unknown argument " << arg << endl;
+            PrintBatchUsage();
+            return 2;
+        }
+    }
+
+    if (options.manifest.isEmpty()) {
+        PrintBatchUsage();
+        return 2;
+    }
+
+    BatchFarm farm(options);
+    if (!farm.LoadManifest())
+        return 2;
+    return farm.Run();
+}
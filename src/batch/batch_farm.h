@@ -0,0 +1,90 @@
+/**
+ * @file batch_farm.h
+ * @author Yaotian Liu
+ * @brief Headless batch runs: a farm of local worker processes
+ * @date 2026-10-19
+ */
+
+#if !defined(BATCH_FARM_H)
+#define BATCH_FARM_H
+
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+// Exit codes of a job process; anything else (or a crash) is retried
+const int JOB_OK = 0;
+const int JOB_DECK_ERROR = 1;  // Could not read or check the deck, not retried
+
+// How often running jobs are checked (exit, memory, timeout)
+const int BATCH_POLL_MS = 100;
+
+// Memory assumed for a job before any job has finished
+const qint64 BATCH_DEFAULT_JOB_KB = 64 * 1024;
+
+struct BatchOptions {
+    QString manifest;
+    QString out_dir;
+    int job_num = 0;         // Worker processes, 0 for one per core
+    qint64 mem_budget_mb = 0;  // 0 for no budget
+    int retries = 2;
+    int timeout_s = 0;       // 0 for no timeout
+};
+
+struct BatchJob {
+    QString deck;
+    QString prefix;  // Output files: <prefix>.log, .raw, .stats
+
+    int attempt = 0;
+    std::unique_ptr<QProcess> process;
+    QElapsedTimer timer;
+    qint64 rss_kb = 0;  // Last sampled
+    qint64 peak_rss_kb = 0;
+    bool killed = false;
+
+    bool done = false;
+    QString status;
+    double seconds = 0;
+    qint64 point_num = 0;  // Sweep / time points, over all the .step values
+    qint64 step_num = 0;
+};
+
+/**
+ * @brief Runs the decks of a manifest, each in its own process (this program
+ * with `--job`), so a deck that crashes, stalls or runs out of memory only
+ * takes its own process down. New jobs start while fewer than `job_num` run
+ * and the memory of the running ones plus the largest job seen so far fits
+ * the budget.
+ */
+class BatchFarm {
+  public:
+    BatchFarm(const BatchOptions& options);
+
+    bool LoadManifest();
+    int Run();
+
+  private:
+    BatchOptions options;
+    QString include_cache_dir;  // Under out_dir, empty if it cannot be created
+    std::vector<std::unique_ptr<BatchJob>> job_vec;
+    std::vector<BatchJob*> waiting_vec;  // Next job at the back
+
+    int running_num = 0;
+    int retry_num = 0;
+    qint64 largest_job_kb = BATCH_DEFAULT_JOB_KB;
+
+    bool CanStart();
+    void Start(BatchJob& job);
+    void Poll(BatchJob& job);
+    void Finish(BatchJob& job);
+    void PrintSummary(const double wall_seconds);
+};
+
+int RunBatchCommand(const QStringList arguments);
+int RunJob(const QString deck, const QString prefix);
+qint64 ReadProcessKb(const QString pid, const QString key);
+
+#endif  // BATCH_FARM_H
@@ -0,0 +1,83 @@
+/**
+ * @file batch_job.cpp
+ * @author Yaotian Liu
+ * @brief One deck of a batch, run in its own process
+ * @date 2026-10-19
+ */
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include "../analyzer/analyzer.h"
+#include "../analyzer/step_runner.h"
+#include "../parser/parser.h"
+#include "batch_farm.h"
+
+void WriteStats(const QString prefix, const QString deck, const QString status,
+                const qint64 parse_ms, const qint64 analysis_ms, const qint64 point_num,
+                const qint64 step_num) {
+    QFile file(prefix + ".stats");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return;
+
+    QTextStream stream(&file);
+    stream << "deck=" << deck << "\n";
+    stream << "status=" << status << "\n";
+    stream << "parse_ms=" << parse_ms << "\n";
+    stream << "analysis_ms=" << analysis_ms << "\n";
+    stream << "points=" << point_num << "\n";
+    stream << "steps=" << step_num << "\n";
+    stream << "peak_rss_kb=" << ReadProcessKb("self", "VmHWM") << "\n";
+}
+
+/**
+ * @brief Parse and analyse one deck. Points go to <prefix>.raw as they are
+ * solved, the timings and memory to <prefix>.stats; the log is whatever the
+ * farm captured from stdout.
+ *
+ * @param deck
+ * @param prefix
+ * @return int JOB_OK or JOB_DECK_ERROR
+ */
+int RunJob(const QString deck, const QString prefix) {
+    QElapsedTimer timer;
+    timer.start();
+
+    Parser parser;
+    bool parsed = parser.ParseFile(deck);
+    bool checked = parsed && parser.ParserFinalCheck();
+    qint64 parse_ms = timer.restart();
+    if (!checked) {
+        WriteStats(prefix, deck, parsed ? "check failed" : "cannot read", parse_ms, 0, 0,
+                   0);
+        return JOB_DECK_ERROR;
+    }
+
+    parser.SetOption("rawfile", prefix + ".raw");
+
+    // Sweep / time points solved over all the steps, and the steps run
+    qint64 point_num = 0;
+    qint64 step_num = 1;
+    bool completed;
+    StepAnalysis step_analysis = parser.GetStepAnalysis();
+    if (!step_analysis.value_vec.empty()) {
+        // The farm already runs one job per core, so steps run one by one.
+        StepRunner step_runner(Analyzer(parser), step_analysis);
+        completed = step_runner.Run(StepProgress(), 1);
+        step_num = step_analysis.value_vec.size();
+        for (auto& run : step_runner.Runs())
+            point_num += run.point_num;
+    } else {
+        Analyzer analyzer(parser);
+        completed = analyzer.Run([&](const AnalysisStep&) {
+            point_num++;
+            return true;
+        });
+    }
+
+    // A failed analysis fails again on a retry, report it like a deck error
+    WriteStats(prefix, deck, completed ? "ok" : "analysis failed", parse_ms, timer.elapsed(),
+               point_num, step_num);
+    return completed ? JOB_OK : JOB_DECK_ERROR;
+}
@@ -1,9 +1,19 @@
 #include <QApplication>
+#include <QCoreApplication>
 #include <QLabel>
 
+#include "batch/batch_farm.h"
 #include "mainwindow/mainwindow.h"
 
 int main(int argc, char* argv[]) {
+    // Batch farm and its jobs run without a window
+    for (int i = 1; i < argc; i++) {
+        if (QString(argv[i]) == "--batch" || QString(argv[i]) == "--job") {
+            QCoreApplication app(argc, argv);
+            return RunBatchCommand(app.arguments());
+        }
+    }
+
     QApplication app(argc, argv);
 
     MainWindow* mainwindow = new MainWindow;
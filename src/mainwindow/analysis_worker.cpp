@@ -0,0 +1,181 @@
+/**
+ * @file analysis_worker.cpp
+ * @author Yaotian Liu
+ * @brief Runs the parser and the analyzer off the GUI thread
+ * @date 2026-10-19
+ */
+
+#include "analysis_worker.h"
+
+#include <iostream>
+
+#include "../utils/utils.h"
+
+using std::cout;
+using std::endl;
+
+AnalysisWorker::AnalysisWorker(QTextEdit* output) : output(output) {}
+
+/**
+ * @brief Parse a deck, going through the compiled netlist cache if enabled
+ *
+ * @param file_name
+ * @param use_cache load / save `<file>.snl`
+ */
+void AnalysisWorker::Parse(const QString file_name, const bool use_cache) {
+    parser = Parser(output);
+
+    // Skip the text parser entirely if the compiled netlist is up to date.
+    QString cache_name = file_name + ".snl";
+    quint64 source_hash = 0;
+    if (use_cache) {
+        source_hash = HashFile(file_name);
+        if (parser.LoadCompiled(cache_name, source_hash)) {
+            QMetaObject::invokeMethod(output, "append",
+                                      Q_ARG(QString, tr("Loaded compiled netlist: ") +
+                                                         cache_name));
+            PrintParserSummary();
+            emit ParseFinished(true, parser.ParserFinalCheck());
+            return;
+        }
+    }
+
+    if (!parser.ParseFile(file_name)) {
+        emit ParseFinished(false, false);
+        return;
+    }
+
+    bool checked = parser.ParserFinalCheck();
+    if (use_cache && checked)
+        parser.SaveCompiled(cache_name, source_hash);
+
+    PrintParserSummary();
+    emit ParseFinished(true, checked);
+}
+
+/**
+ * @brief Parse the lines of the editor set in SourceLines(), reusing the lines
+ * unchanged since the last run
+ *
+ * @param file_name where the deck is saved, if it is
+ */
+void AnalysisWorker::ParseEditor(const QString file_name) {
+    parser = Parser(output);
+    parser.ParseLines(source_line_vec, source_text, file_name);
+
+    PrintParserSummary();
+    emit ParseFinished(true, parser.ParserFinalCheck());
+}
+
+void AnalysisWorker::PrintParserSummary() {
+    Circuit circuit = parser.GetCircuit();
+
+    cout << "------ Summary ------" << endl;
+    cout << "Device: "
+         << circuit.res_vec.size() + circuit.ind_vec.size() + circuit.cap_vec.size()
+         << endl;
+    cout << "R: " << circuit.res_vec.size() << "  "
+         << "L: " << circuit.ind_vec.size() << "  "
+         << "C: " << circuit.cap_vec.size() << endl;
+    cout << "Vsrc: " << circuit.vsrc_vec.size() << endl;
+    cout << "Subckt: " << circuit.subckt_vec.size() << "  "
+         << "Instance: " << circuit.instance_vec.size() << endl;
+    cout << "Node: " << circuit.node_vec.size() << endl;
+
+    if (!parser.ParserFinalCheck())
+        cout << "Parser check failed" << endl;
+}
+
+/**
+ * @brief Run the analysis of the last parsed deck
+ *
+ * @param live feed the live plot through LiveQueue()
+ */
+void AnalysisWorker::Analyze(const bool live) {
+    cancel = false;
+    live_queue.Clear();
+    live_record.clear();
+    live_dropped = 0;
+
+    StepAnalysis step_analysis = parser.GetStepAnalysis();
+    stepped = !step_analysis.value_vec.empty();
+    if (stepped) {
+        AnalyzeSteps(step_analysis);
+        return;
+    }
+
+    analyzer = Analyzer(parser);
+    analyzer.SetSession(&session);
+
+    QString x_label;
+    switch (parser.GetAnalysisType()) {
+        case DC: x_label = "Vsrc"; break;
+        case AC: x_label = "Frequency"; break;
+        case TRAN: x_label = "Time"; break;
+        case MC: x_label = "Sample"; break;
+        default: break;
+    }
+
+    progress_timer.start();
+    bool completed = analyzer.Run([&](const AnalysisStep& step) {
+        if (live && live_record.empty() && step.value != nullptr) {
+            live_record.resize(step.node_vec->size() + 1);
+
+            QStringList name_list;
+            for (auto node : *step.node_vec)
+                name_list.append(node);
+            emit LiveStarted(name_list, x_label);
+        }
+        return OnStep(step);
+    });
+
+    if (live_dropped > 0)
+        cout << "Live plot skipped " << live_dropped << " points" << endl;
+    emit AnalysisFinished(completed);
+}
+
+/**
+ * @brief Run a .step sweep on a pool of threads (`.options stepthreads=...`,
+ * all cores by default). Steps report only their completion, there is no
+ * live plot.
+ */
+void AnalysisWorker::AnalyzeSteps(const StepAnalysis& step_analysis) {
+    step_runner = StepRunner(Analyzer(parser), step_analysis);
+    int thread_num = GetOptionValue(parser.GetOptions(), "stepthreads", 0);
+
+    bool completed = step_runner.Run(
+        [this](int step_done, int step_num) {
+            emit Progress(step_done, step_num);
+            return !cancel;
+        },
+        thread_num, [this]() { return bool(cancel); });
+    emit AnalysisFinished(completed);
+}
+
+void AnalysisWorker::ShowPlots() {
+    if (stepped)
+        step_runner.ShowPlots();
+    else
+        analyzer.ShowPlots();
+}
+
+/**
+ * @brief Called by the engine after every step, on this thread
+ */
+bool AnalysisWorker::OnStep(const AnalysisStep& step) {
+    if (!live_record.empty()) {
+        live_record[0] = step.x;
+        std::copy(step.value, step.value + live_record.size() - 1, live_record.begin() + 1);
+        if (!live_queue.Push(live_record.data(), live_record.size()))
+            live_dropped++;
+    }
+
+    // One queued signal per interval, not per step, so a fast solver does not
+    // flood the GUI event loop.
+    if (progress_timer.elapsed() >= PROGRESS_INTERVAL_MS || step.step == step.step_num) {
+        emit Progress(step.step, step.step_num);
+        progress_timer.start();
+    }
+
+    return !cancel;
+}
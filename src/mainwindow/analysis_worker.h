@@ -0,0 +1,89 @@
+/**
+ * @file analysis_worker.h
+ * @author Yaotian Liu
+ * @brief Runs the parser and the analyzer off the GUI thread
+ * @date 2026-10-19
+ */
+
+#ifndef ANALYSIS_WORKER_H
+#define ANALYSIS_WORKER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QTextEdit>
+#include <atomic>
+
+#include "../analyzer/analyzer.h"
+#include "../analyzer/step_runner.h"
+#include "../parser/parser.h"
+#include "../utils/spsc_queue.h"
+
+// Progress is sent to the GUI at most this often
+const int PROGRESS_INTERVAL_MS = 50;
+// Values buffered for the live plot; points are dropped from the live plot (not
+// from the results) while it is full, the solver never waits for the GUI.
+const std::size_t LIVE_QUEUE_SIZE = 1 << 20;
+
+/**
+ * @brief Lives on a worker thread and owns the parser and the analyzer; the
+ * slots are invoked with queued calls from MainWindow and report back with
+ * signals. The GUI reads the parser / analyzer only after a *Finished signal,
+ * while the worker is idle.
+ */
+class AnalysisWorker : public QObject {
+    Q_OBJECT
+
+  public:
+    AnalysisWorker(QTextEdit* output);
+
+    // Thread safe; the analysis stops at the next step
+    void Cancel() { cancel = true; }
+
+    Analyzer& GetAnalyzer() { return analyzer; }
+
+    // Plot the last analysis or .step sweep; GUI thread, while idle
+    void ShowPlots();
+
+    // Lines of the editor for ParseEditor(); holds the fragments afterwards
+    std::vector<SourceLine>& SourceLines() { return source_line_vec; }
+    QString& SourceText() { return source_text; }
+
+    // Records of (x, value of every live signal), consumed by the GUI thread
+    SpscQueue<double>& LiveQueue() { return live_queue; }
+
+  public slots:
+    void Parse(const QString file_name, const bool use_cache);
+    void ParseEditor(const QString file_name);
+    void Analyze(const bool live);
+
+  signals:
+    void ParseFinished(bool parsed, bool checked);
+    void Progress(int step, int step_num);
+    void LiveStarted(QStringList name_list, QString x_label);
+    void AnalysisFinished(bool completed);
+
+  private:
+    QTextEdit* output;
+    Parser parser;
+    Analyzer analyzer;
+    IncrementalSession session;  // Outlives the analyzer of each run
+    StepRunner step_runner;
+    bool stepped = false;  // The last analysis was a .step sweep
+    std::atomic<bool> cancel{false};
+
+    std::vector<SourceLine> source_line_vec;
+    QString source_text;  // The lines point into it
+
+    QElapsedTimer progress_timer;
+
+    SpscQueue<double> live_queue{LIVE_QUEUE_SIZE};
+    std::vector<double> live_record;
+    std::size_t live_dropped;
+
+    bool OnStep(const AnalysisStep& step);
+    void AnalyzeSteps(const StepAnalysis& step_analysis);
+    void PrintParserSummary();
+};
+
+#endif
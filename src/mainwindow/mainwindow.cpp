@@ -11,6 +11,8 @@
 #include <QDir>
 #include <QLabel>
 #include <QtWidgets>
+#include <algorithm>
+#include <climits>
 #include <iostream>
 
 #include "../utils/utils.h"
@@ -18,6 +20,19 @@
 using std::cout;
 using std::endl;
 
+/**
+ * @brief What a line of the editor parsed into, kept on its text block. Valid
+ * while the block's revision is unchanged.
+ */
+class ParsedLineData : public QTextBlockUserData {
+  public:
+    ParsedLineData(const int revision, std::shared_ptr<const Circuit> fragment)
+        : revision(revision), fragment(fragment) {}
+
+    int revision;
+    std::shared_ptr<const Circuit> fragment;
+};
+
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     setWindowTitle(tr("Simple EDA"));
 
@@ -25,11 +40,16 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     CreateMenus();
     CreateLayout();
     CreateToolBars();
+    CreateWorker();
 
     resize(900, 600);
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow() {
+    worker->Cancel();
+    worker_thread.quit();
+    worker_thread.wait();
+}
 
 void MainWindow::CreateActions() {
     /// @brief New File
@@ -50,6 +70,23 @@ void MainWindow::CreateActions() {
     action_save_file->setStatusTip(tr("Save file"));
     connect(action_save_file, SIGNAL(triggered()), this, SLOT(SlotSaveFile()));
 
+    /// @brief Go to Line
+    action_goto_line = new QAction(tr("Go to Line"), this);
+    action_goto_line->setShortcut(Qt::CTRL + Qt::Key_G);
+    action_goto_line->setStatusTip(tr("Go to a line of the netlist"));
+    connect(action_goto_line, SIGNAL(triggered()), this, SLOT(SlotGotoLine()));
+
+    /// @brief Find
+    action_find = new QAction(tr("Find"), this);
+    action_find->setShortcut(QKeySequence::Find);
+    action_find->setStatusTip(tr("Find text in the netlist"));
+    connect(action_find, SIGNAL(triggered()), this, SLOT(SlotFind()));
+
+    action_find_next = new QAction(tr("Find Next"), this);
+    action_find_next->setShortcut(QKeySequence::FindNext);
+    action_find_next->setStatusTip(tr("Find the next occurrence"));
+    connect(action_find_next, SIGNAL(triggered()), this, SLOT(SlotFindNext()));
+
     /// @brief SPICE Parser
     action_parser = new QAction(tr("Parser"), this);
     action_parser->setStatusTip(tr("SPICE Parser"));
@@ -58,6 +95,24 @@ void MainWindow::CreateActions() {
     action_analyzer = new QAction(tr("Analyzer"), this);
     action_analyzer->setStatusTip(tr("SPICE Analyzer"));
     connect(action_analyzer, SIGNAL(triggered()), this, SLOT(SlotAnalyzer()));
+
+    /// @brief Stop the running analysis at the next step
+    action_cancel = new QAction(tr("Cancel"), this);
+    action_cancel->setStatusTip(tr("Stop the running analysis"));
+    action_cancel->setEnabled(false);
+    connect(action_cancel, SIGNAL(triggered()), this, SLOT(SlotCancel()));
+
+    /// @brief Plot DC / TRAN results while they are solved
+    action_live_plot = new QAction(tr("Live Plot"), this);
+    action_live_plot->setStatusTip(tr("Show the waveforms while the analysis runs"));
+    action_live_plot->setCheckable(true);
+    action_live_plot->setChecked(true);
+
+    /// @brief Reuse the compiled netlist (<file>.snl) when the file is unchanged
+    action_netlist_cache = new QAction(tr("Netlist Cache"), this);
+    action_netlist_cache->setStatusTip(tr("Load and save the compiled netlist cache"));
+    action_netlist_cache->setCheckable(true);
+    action_netlist_cache->setChecked(true);
 }
 
 void MainWindow::CreateMenus() {
@@ -66,6 +121,11 @@ void MainWindow::CreateMenus() {
     file_menu->addSeparator();  /// Add separator between 2 actions.
     file_menu->addAction(action_open_file);
     file_menu->addAction(action_save_file);
+
+    edit_menu = menuBar()->addMenu(tr("Edit"));
+    edit_menu->addAction(action_goto_line);
+    edit_menu->addAction(action_find);
+    edit_menu->addAction(action_find_next);
 }
 
 void MainWindow::CreateToolBars() {
@@ -79,11 +139,52 @@ void MainWindow::CreateToolBars() {
 
     analysis_tool->addAction(action_parser);
     analysis_tool->addAction(action_analyzer);
+    analysis_tool->addAction(action_cancel);
+    analysis_tool->addAction(action_live_plot);
+    analysis_tool->addAction(action_netlist_cache);
+
+    progress_bar = new QProgressBar(this);
+    progress_bar->setMaximumWidth(200);
+    progress_bar->setVisible(false);
+    statusBar()->addPermanentWidget(progress_bar);
+}
+
+void MainWindow::CreateWorker() {
+    worker = new AnalysisWorker(output);
+    worker->moveToThread(&worker_thread);
+    connect(&worker_thread, &QThread::finished, worker, &QObject::deleteLater);
+
+    connect(worker, &AnalysisWorker::ParseFinished, this, &MainWindow::SlotParseFinished);
+    connect(worker, &AnalysisWorker::Progress, this, &MainWindow::SlotProgress);
+    connect(worker, &AnalysisWorker::LiveStarted, this, &MainWindow::SlotLiveStarted);
+    connect(worker, &AnalysisWorker::AnalysisFinished, this,
+            &MainWindow::SlotAnalysisFinished);
+
+    worker_thread.start();
+
+    // Drain the live queue once per frame of the display.
+    live_timer = new QTimer(this);
+    qreal refresh_rate = QGuiApplication::primaryScreen()->refreshRate();
+    live_timer->setInterval(int(1000 / (refresh_rate > 0 ? refresh_rate : 60)));
+    connect(live_timer, &QTimer::timeout, this, &MainWindow::SlotLiveRefresh);
+}
+
+/**
+ * @brief Only one job runs on the worker at a time
+ */
+void MainWindow::SetBusy(const bool busy) {
+    action_parser->setEnabled(!busy);
+    action_analyzer->setEnabled(!busy);
+    action_cancel->setEnabled(busy);
+    progress_bar->setVisible(busy);
+    progress_bar->setRange(0, 0);  // Busy indicator until the first step
 }
 
 void MainWindow::CreateLayout() {
     main_widget = new QWidget(this);
     text = new QTextEdit(main_widget);
+    viewer = new NetlistViewer(main_widget);
+    viewer->setHidden(true);
     output = new QTextEdit(main_widget);
     output->setReadOnly(true);
     output->append(tr("╔═══════════════╗"));
@@ -93,8 +194,10 @@ void MainWindow::CreateLayout() {
 
     main_layout = new QHBoxLayout();
     main_layout->addWidget(text);
+    main_layout->addWidget(viewer);
     main_layout->addWidget(output);
     main_layout->setStretchFactor(text, 2);
+    main_layout->setStretchFactor(viewer, 2);
     main_layout->setStretchFactor(output, 3);
 
     main_widget->setLayout(main_layout);
@@ -108,6 +211,9 @@ void MainWindow::CreateLayout() {
  * @date 2022/08/04
  */
 void MainWindow::SlotNewFile() {
+    viewer->Close();
+    viewer->setHidden(true);
+    file_name = "";
     text->clear();           /// Clear the text
     text->setHidden(false);  /// Display the text.
 }
@@ -123,7 +229,19 @@ void MainWindow::SlotOpenFile() {
     /// If the dialog is directly closed, the filename will be null.
     if (file_name == "") {
         return;
+    } else if (QFileInfo(file_name).size() > LARGE_FILE_SIZE) {
+        /// Large netlists are mapped, not loaded into the editor.
+        if (!viewer->Open(file_name)) {
+            QMessageBox::warning(this, tr("Error"), tr("Failed to open file!"));
+            return;
+        }
+        text->clear();
+        text->setHidden(true);
+        viewer->show();
+        statusBar()->showMessage(tr("Opened read only: %1 lines").arg(viewer->LineCount()));
     } else {
+        viewer->Close();
+        viewer->setHidden(true);
         QFile file(file_name);
         if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
             QMessageBox::warning(this, tr("Error"), tr("Failed to open file!"));
@@ -136,6 +254,7 @@ void MainWindow::SlotOpenFile() {
                 while (!textStream.atEnd()) {
                     text->setPlainText(textStream.readAll());
                 }
+                text->document()->setModified(false);  // Same as on disk
                 text->show();
                 file.close();
             }
@@ -150,6 +269,13 @@ void MainWindow::SlotOpenFile() {
  * @date 2022/08/04
  */
 void MainWindow::SlotSaveFile() {
+    /// The viewer is read only and the editor holds nothing to save.
+    if (!viewer->isHidden()) {
+        QMessageBox::warning(this, tr("Warning"), tr("Large files are opened read only."),
+                             QMessageBox::Ok);
+        return;
+    }
+
     statusBar()->showMessage(tr("Saving file..."));
 
     if (file_name == "")  /// File has not been saved.
@@ -175,6 +301,7 @@ void MainWindow::SlotSaveFile() {
                 QTextStream textStream(&file);
                 QString str = text->toPlainText();
                 textStream << str;
+                text->document()->setModified(false);
             }
             file.close();
         }
@@ -187,11 +314,62 @@ void MainWindow::SlotSaveFile() {
             QTextStream textStream(&file);
             QString str = text->toPlainText();
             textStream << str;
+            text->document()->setModified(false);
             file.close();
         }
     }
 }
 
+/// @brief Go to a line in the viewer or the editor
+void MainWindow::SlotGotoLine() {
+    bool ok = false;
+    int max_line = viewer->isHidden() ? text->document()->blockCount()
+                                      : std::min<qint64>(viewer->LineCount(), INT_MAX);
+    int line = QInputDialog::getInt(this, tr("Go to Line"), tr("Line:"), 1, 1,
+                                    std::max(1, max_line), 1, &ok);
+    if (!ok)
+        return;
+
+    if (!viewer->isHidden()) {
+        viewer->GotoLine(line - 1);
+    } else {
+        QTextCursor cursor(text->document()->findBlockByNumber(line - 1));
+        text->setTextCursor(cursor);
+        text->setFocus();
+    }
+}
+
+void MainWindow::SlotFind() {
+    bool ok = false;
+    QString input = QInputDialog::getText(this, tr("Find"), tr("Text:"),
+                                          QLineEdit::Normal, find_text, &ok);
+    if (!ok || input.isEmpty())
+        return;
+    find_text = input;
+    SlotFindNext();
+}
+
+void MainWindow::SlotFindNext() {
+    if (find_text.isEmpty()) {
+        SlotFind();
+        return;
+    }
+
+    bool found;
+    if (!viewer->isHidden()) {
+        found = viewer->Find(find_text);
+    } else {
+        found = text->find(find_text, QTextDocument::FindCaseSensitively);
+        if (!found) {  // Wrap around
+            text->moveCursor(QTextCursor::Start);
+            found = text->find(find_text, QTextDocument::FindCaseSensitively);
+        }
+    }
+
+    if (!found)
+        statusBar()->showMessage(tr("Not found: ") + find_text, 3000);
+}
+
 /// @brief SPICE parser implementation
 void MainWindow::SlotParser() {
     cout << "==============================" << endl;
@@ -201,60 +379,229 @@ void MainWindow::SlotParser() {
     cout << "file_name: " << file_name << endl;
     output->append(tr("file_name: ") + file_name);
 
-    parser = Parser(output);
+    SetBusy(true);
 
-    QFile file(file_name);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    // Unsaved edits are parsed from the editor, without a round trip to disk.
+    if (!text->isHidden() && text->document()->isModified()) {
+        SnapshotEditor();
+        QMetaObject::invokeMethod(worker, "ParseEditor", Qt::QueuedConnection,
+                                  Q_ARG(QString, file_name));
+        return;
+    }
+
+    source_revision_vec.clear();
+    QMetaObject::invokeMethod(worker, "Parse", Qt::QueuedConnection,
+                              Q_ARG(QString, file_name),
+                              Q_ARG(bool, action_netlist_cache->isChecked()));
+}
+
+/**
+ * @brief Hand the lines of the editor to the worker: the text of the document
+ * in one piece, and every block as its range in there, taken from the
+ * positions the document keeps anyway. Unchanged lines also pass what they
+ * parsed into last time.
+ */
+void MainWindow::SnapshotEditor() {
+    QTextDocument* document = text->document();
+    std::vector<SourceLine> line_vec;
+    line_vec.reserve(document->blockCount());
+    source_revision_vec.clear();
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        // length() counts the separator after the block
+        SourceLine line{block.position(), block.length() - 1, nullptr};
+        auto data = static_cast<ParsedLineData*>(block.userData());
+        if (block.blockNumber() > 0 && data != nullptr &&
+            data->revision == block.revision())
+            line.fragment = data->fragment;
+        line_vec.push_back(line);
+        source_revision_vec.push_back(block.revision());
+    }
+
+    // The worker is idle, the queued call below publishes the lines to it.
+    worker->SourceLines() = std::move(line_vec);
+    worker->SourceText() = document->toPlainText();
+}
+
+/**
+ * @brief Keep the fragments of the lines just parsed on their blocks, unless
+ * the line was edited while the parser ran.
+ */
+void MainWindow::StoreParsedLines() {
+    std::vector<SourceLine>& line_vec = worker->SourceLines();
+    QTextDocument* document = text->document();
+    if (line_vec.size() != source_revision_vec.size() ||
+        document->blockCount() != int(line_vec.size()))
+        return;
+
+    QTextBlock block = document->begin();
+    for (std::size_t i = 0; i < line_vec.size(); i++, block = block.next()) {
+        if (!line_vec[i].fragment || block.revision() != source_revision_vec[i])
+            continue;
+        auto data = static_cast<ParsedLineData*>(block.userData());
+        if (data == nullptr || data->fragment != line_vec[i].fragment)
+            block.setUserData(new ParsedLineData(block.revision(), line_vec[i].fragment));
+    }
+}
+
+void MainWindow::SlotParseFinished(bool parsed, bool checked) {
+    SetBusy(false);
+
+    if (!source_revision_vec.empty())
+        StoreParsedLines();
+
+    if (!parsed) {
         QMessageBox::warning(this, tr("Error"),
                              tr("Load the content in SPICE file failed."),
                              QMessageBox::Ok);
         return;
     }
-    QTextStream textStream(&file);
-
-    QString title;
-
-    int lineCount = 0;
-    while (!textStream.atEnd()) {
-        QString line = textStream.readLine();
-        lineCount++;
-        if (lineCount == 1) {
-            title = line;
-            cout << "Parsed Title: " << title << endl;
-            output->append(tr("Parsed Title: ") + title);
-        } else if (line.size() > 0) {
-            if (line.startsWith("*")) {
-                cout << "Parsed Annotation: " << line << endl;
-                output->append(tr("Parsed Annotation: ") + line);
-            } else {
-                line = line.toLower();  // SPICE is case-insensistive
-                if (line.startsWith("."))
-                    parser.CommandParser(line, lineCount);
-                else
-                    parser.DeviceParser(line, lineCount);
-            }
-        }
+    if (!checked)
+        QMessageBox::warning(this, tr("Error"), tr("Parser check failed."),
+                             QMessageBox::Ok);
+}
+
+// @brief SPICE Analyzer
+void MainWindow::SlotAnalyzer() {
+    SetBusy(true);
+    statusBar()->showMessage(tr("Running analysis..."));
+    QMetaObject::invokeMethod(worker, "Analyze", Qt::QueuedConnection,
+                              Q_ARG(bool, action_live_plot->isChecked()));
+}
+
+void MainWindow::SlotCancel() {
+    worker->Cancel();
+    statusBar()->showMessage(tr("Stopping analysis..."));
+}
+
+void MainWindow::SlotProgress(int step, int step_num) {
+    progress_bar->setRange(0, step_num);
+    progress_bar->setValue(step);
+}
+
+/**
+ * @brief Open a plot showing the results as they are solved
+ */
+void MainWindow::SlotLiveStarted(QStringList name_list, QString x_label) {
+    if (live_plot != nullptr)
+        live_plot->close();
+
+    QCustomPlot* plot = new QCustomPlot();
+    plot->setAttribute(Qt::WA_DeleteOnClose);
+    connect(plot, &QObject::destroyed, this, [this, plot]() {
+        if (live_plot == plot)
+            live_plot = nullptr;
+    });
+    live_plot = plot;
+
+    std::vector<QPen> pens = {QPen(Qt::blue), QPen(Qt::red), QPen(Qt::darkYellow)};
+    for (int i = 0; i < name_list.size(); i++) {
+        live_plot->addGraph(live_plot->xAxis, live_plot->yAxis);
+        live_plot->graph(i)->setPen(pens[i % pens.size()]);
+        live_plot->graph(i)->setName(name_list[i]);
     }
 
-    Circuit circuit = parser.GetCircuit();
+    live_plot->legend->setVisible(true);
+    live_plot->xAxis->setLabel(x_label);
+    live_plot->yAxis->setLabel(tr("Value"));
+    live_plot->setWindowTitle(tr("Running: ") + x_label);
+    live_plot->setMinimumSize(450, 300);
+    live_plot->show();
+
+    live_buffer.resize(LIVE_QUEUE_SIZE - LIVE_QUEUE_SIZE % (name_list.size() + 1));
+    live_bucket_size = 1;
+    live_pending_x.clear();
+    live_pending_y_vec.assign(name_list.size(), std::vector<double>());
+    live_timer->start();
+}
 
-    cout << "------ Summary ------" << endl;
-    cout << "Device: "
-         << circuit.res_vec.size() + circuit.ind_vec.size() + circuit.cap_vec.size()
-         << endl;
-    cout << "R: " << circuit.res_vec.size() << "  "
-         << "L: " << circuit.ind_vec.size() << "  "
-         << "C: " << circuit.cap_vec.size() << endl;
-    cout << "Vsrc: " << circuit.vsrc_vec.size() << endl;
-    cout << "Node: " << circuit.node_vec.size() << endl;
+/**
+ * @brief Append the points queued by the worker since the last frame. Only
+ * the min and the max of every `live_bucket_size` points are drawn, so a
+ * frame costs the same however long the run is; the axes grow with the new
+ * points instead of being rescaled over the whole plot.
+ */
+void MainWindow::SlotLiveRefresh() {
+    if (live_plot == nullptr)
+        return;
 
-    if (!parser.ParserFinalCheck()) {
-        cout << "Parser check failed" << endl;
-        QMessageBox::warning(this, tr("Error"), tr("Parser check failed."),
-                             QMessageBox::Ok);
+    std::size_t signal_num = live_plot->graphCount();
+    std::size_t record_size = signal_num + 1;
+    std::size_t num = worker->LiveQueue().Pop(live_buffer.data(), live_buffer.size());
+    if (num == 0)
+        return;
+
+    std::size_t point_num = num / record_size;
+    for (std::size_t p = 0; p < point_num; p++) {
+        live_pending_x.push_back(live_buffer[p * record_size]);
+        for (std::size_t i = 0; i < signal_num; i++)
+            live_pending_y_vec[i].push_back(live_buffer[p * record_size + i + 1]);
+    }
+
+    // Draw the full buckets, the rest waits for the next frame
+    std::size_t full = live_pending_x.size() - live_pending_x.size() % live_bucket_size;
+    if (full == 0)
         return;
+
+    QCPRange y_range = live_plot->yAxis->range();
+    bool first = live_plot->graph(0)->dataCount() == 0;
+    for (std::size_t i = 0; i < signal_num; i++) {
+        std::vector<double> x_vec, y_vec;
+        Decimate(SignalView(live_pending_x.data(), full),
+                 SignalView(live_pending_y_vec[i].data(), full), x_vec, y_vec,
+                 live_bucket_size);
+        live_plot->graph(i)->addData(QVector<double>(x_vec.begin(), x_vec.end()),
+                                     QVector<double>(y_vec.begin(), y_vec.end()), true);
+
+        auto range = std::minmax_element(y_vec.begin(), y_vec.end());
+        if (first && i == 0)
+            y_range = QCPRange(*range.first, *range.second);
+        else
+            y_range.expand(QCPRange(*range.first, *range.second));
+        live_pending_y_vec[i].erase(live_pending_y_vec[i].begin(),
+                                    live_pending_y_vec[i].begin() + full);
     }
+    live_pending_x.erase(live_pending_x.begin(), live_pending_x.begin() + full);
+
+    if (live_plot->graph(0)->dataCount() > LIVE_PLOT_MAX_POINTS)
+        DecimateLivePlot();
+
+    // x only ever grows, from the first point to the last one drawn
+    live_plot->xAxis->setRange(live_plot->graph(0)->data()->constBegin()->key,
+                               (live_plot->graph(0)->data()->constEnd() - 1)->key);
+    live_plot->yAxis->setRange(y_range);
+    live_plot->replot(QCustomPlot::rpQueuedReplot);
 }
 
-// @brief SPICE Analyzer
-void MainWindow::SlotAnalyzer() { analyzer = Analyzer(parser); }
+/**
+ * @brief Merge the min/max pairs already drawn into LOD_GROUP_SIZE / 2 times
+ * fewer, and make the buckets that much larger from now on
+ */
+void MainWindow::DecimateLivePlot() {
+    for (int i = 0; i < live_plot->graphCount(); i++) {
+        std::vector<double> x_vec, y_vec;
+        for (auto it = live_plot->graph(i)->data()->constBegin();
+             it != live_plot->graph(i)->data()->constEnd(); ++it) {
+            x_vec.push_back(it->key);
+            y_vec.push_back(it->value);
+        }
+
+        std::vector<double> level_x, level_y;
+        Decimate(x_vec, y_vec, level_x, level_y);
+        live_plot->graph(i)->setData(QVector<double>(level_x.begin(), level_x.end()),
+                                     QVector<double>(level_y.begin(), level_y.end()), true);
+    }
+    live_bucket_size *= LOD_GROUP_SIZE / 2;
+}
+
+void MainWindow::SlotAnalysisFinished(bool completed) {
+    SetBusy(false);
+    statusBar()->showMessage(completed ? tr("Analysis done") : tr("Analysis stopped"),
+                             3000);
+
+    // The full results replace the live plot.
+    live_timer->stop();
+    if (live_plot != nullptr)
+        live_plot->close();
+    worker->ShowPlots();
+}
@@ -10,9 +10,12 @@
 #include <QBoxLayout>
 #include <QMainWindow>
 #include <QString>
+#include <QThread>
 
 #include "../analyzer/analyzer.h"
 #include "../parser/parser.h"
+#include "analysis_worker.h"
+#include "netlist_viewer.h"
 
 class QAction;
 class QMenu;
@@ -20,6 +23,12 @@ class QToolBar;
 class QTextEdit;
 class QWidget;
 class QTextStream;
+class QProgressBar;
+class QTimer;
+
+// Points kept per graph of the live plot; past that, the plot is decimated to
+// min/max pairs over ever larger buckets of points, see SlotLiveRefresh()
+const int LIVE_PLOT_MAX_POINTS = 8192;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -36,9 +45,19 @@ class MainWindow : public QMainWindow {
     void SlotNewFile();
     void SlotOpenFile();
     void SlotSaveFile();
+    void SlotGotoLine();
+    void SlotFind();
+    void SlotFindNext();
 
     void SlotParser();
     void SlotAnalyzer();
+    void SlotCancel();
+
+    void SlotParseFinished(bool parsed, bool checked);
+    void SlotProgress(int step, int step_num);
+    void SlotLiveStarted(QStringList name_list, QString x_label);
+    void SlotLiveRefresh();
+    void SlotAnalysisFinished(bool completed);
 
   private:
     /// @brief file
@@ -50,22 +69,53 @@ class MainWindow : public QMainWindow {
     QAction* action_open_file;
     QAction* action_save_file;
 
+    /// @brief edit
+    QMenu* edit_menu;
+
+    QAction* action_goto_line;
+    QAction* action_find;
+    QAction* action_find_next;
+    QString find_text;
+
     /// @brief parser
     QToolBar* analysis_tool;
 
     QAction* action_parser;
     QAction* action_analyzer;
+    QAction* action_cancel;
+    QAction* action_live_plot;
+    QAction* action_netlist_cache;
+
+    QProgressBar* progress_bar;
 
     QWidget* main_widget;
     QHBoxLayout* main_layout;
 
     QTextEdit* text;
     QTextEdit* output;
+    NetlistViewer* viewer;  // Shown instead of `text` for large files
 
     QString file_name = "./";
 
-    Parser parser;
-    Analyzer analyzer;
+    /// @brief Parser and analyzer run here, see AnalysisWorker
+    QThread worker_thread;
+    AnalysisWorker* worker;
+    void CreateWorker();
+    void SetBusy(const bool busy);
+
+    /// @brief Incremental parsing of the editor, see SnapshotEditor()
+    std::vector<int> source_revision_vec;  // Block revisions handed to the parser
+    void SnapshotEditor();
+    void StoreParsedLines();
+
+    /// @brief Results so far, while the analysis runs
+    QCustomPlot* live_plot = nullptr;
+    QTimer* live_timer;
+    std::vector<double> live_buffer;
+    std::size_t live_bucket_size = 1;  // Points per min/max pair drawn
+    std::vector<double> live_pending_x;  // Points of the bucket being filled
+    std::vector<std::vector<double>> live_pending_y_vec;
+    void DecimateLivePlot();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,222 @@
+/**
+ * @file netlist_viewer.cpp
+ * @author Yaotian Liu
+ * @brief Read only viewer for netlists too large for the editor
+ * @date 2026-10-19
+ */
+
+#include "netlist_viewer.h"
+
+#include <QFontDatabase>
+#include <QPainter>
+#include <QScrollBar>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+
+// Longer lines are cut when painted
+const int MAX_PAINTED_LINE = 4096;
+
+// The scroll bar counts lines in an int; lines past INT_MAX are not reachable
+// by scrolling
+static int ScrollValue(const qint64 line) {
+    return std::max<qint64>(0, std::min<qint64>(line, INT_MAX));
+}
+
+NetlistViewer::NetlistViewer(QWidget* parent) : QAbstractScrollArea(parent) {
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    viewport()->setBackgroundRole(QPalette::Base);
+}
+
+NetlistViewer::~NetlistViewer() { Close(); }
+
+/**
+ * @brief Map a file and index its lines. Nothing is decoded until painted.
+ *
+ * @param file_name
+ * @return true : Opened
+ * @return false : Could not open or map the file
+ */
+bool NetlistViewer::Open(const QString file_name) {
+    Close();
+
+    file.setFileName(file_name);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    size = file.size();
+    if (size > 0) {
+        data = reinterpret_cast<const char*>(file.map(0, size));
+        if (data == nullptr) {
+            file.close();
+            size = 0;
+            return false;
+        }
+    }
+
+    // Sparse line index, one scan with memchr
+    line_index_vec.push_back(0);
+    const char* p = data;
+    const char* end = data + size;
+    while (p != nullptr && p < end) {
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (p == nullptr)
+            break;
+        p++;
+        line_count++;
+        if (line_count % LINE_INDEX_STRIDE == 0)
+            line_index_vec.push_back(p - data);
+    }
+    if (size > 0 && data[size - 1] != '\n')
+        line_count++;
+
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    UpdateScrollBars();
+    viewport()->update();
+    return true;
+}
+
+void NetlistViewer::Close() {
+    if (data != nullptr)
+        file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+    file.close();
+
+    data = nullptr;
+    size = 0;
+    line_count = 0;
+    line_index_vec.clear();
+    current_line = -1;
+    search_offset = 0;
+    max_line_width = 0;
+}
+
+/**
+ * @brief Byte offset of the start of a line (0 based)
+ */
+qint64 NetlistViewer::LineOffset(const qint64 line) const {
+    qint64 offset = line_index_vec[line / LINE_INDEX_STRIDE];
+    for (qint64 i = 0; i < line % LINE_INDEX_STRIDE && offset < size; i++) {
+        const char* p =
+            static_cast<const char*>(std::memchr(data + offset, '\n', size - offset));
+        offset = p == nullptr ? size : p - data + 1;
+    }
+    return offset;
+}
+
+/**
+ * @brief Line (0 based) holding a byte offset
+ */
+qint64 NetlistViewer::LineOfOffset(const qint64 offset) const {
+    auto it = std::upper_bound(line_index_vec.begin(), line_index_vec.end(), offset) - 1;
+    qint64 line = (it - line_index_vec.begin()) * LINE_INDEX_STRIDE;
+    return line + std::count(data + *it, data + offset, '\n');
+}
+
+QString NetlistViewer::LineText(const qint64 line) const {
+    qint64 start = LineOffset(line);
+    const char* p = static_cast<const char*>(std::memchr(data + start, '\n', size - start));
+    qint64 end = p == nullptr ? size : p - data;
+    if (end > start && data[end - 1] == '\r')
+        end--;
+    return QString::fromUtf8(data + start, std::min<qint64>(end - start, MAX_PAINTED_LINE));
+}
+
+int NetlistViewer::LinesPerPage() const {
+    return std::max(1, viewport()->height() / fontMetrics().height());
+}
+
+void NetlistViewer::UpdateScrollBars() {
+    verticalScrollBar()->setRange(0, ScrollValue(line_count - LinesPerPage()));
+    verticalScrollBar()->setPageStep(LinesPerPage());
+    horizontalScrollBar()->setRange(0, std::max(0, max_line_width - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+void NetlistViewer::resizeEvent(QResizeEvent* event) {
+    QAbstractScrollArea::resizeEvent(event);
+    UpdateScrollBars();
+}
+
+/**
+ * @brief Paint the visible lines only, with line numbers in a gutter
+ */
+void NetlistViewer::paintEvent(QPaintEvent*) {
+    QPainter painter(viewport());
+    QFontMetrics metrics = fontMetrics();
+    int line_height = metrics.height();
+
+    int gutter = metrics.horizontalAdvance(QString::number(line_count)) + 12;
+    int x = gutter - horizontalScrollBar()->value();
+
+    qint64 first = verticalScrollBar()->value();
+    qint64 last = std::min(line_count, first + LinesPerPage() + 1);
+
+    int widest = max_line_width;
+    for (qint64 line = first; line < last; line++) {
+        int y = (line - first) * line_height;
+
+        if (line == current_line)
+            painter.fillRect(0, y, viewport()->width(), line_height,
+                             palette().color(QPalette::Highlight).lighter(160));
+
+        QString text = LineText(line);
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(x, y + metrics.ascent(), text);
+        widest = std::max(widest, gutter + metrics.horizontalAdvance(text));
+
+        painter.fillRect(0, y, gutter - 6, line_height, palette().color(QPalette::Window));
+        painter.setPen(palette().color(QPalette::Dark));
+        painter.drawText(0, y, gutter - 8, line_height, Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(line + 1));
+    }
+
+    if (widest != max_line_width) {
+        max_line_width = widest;
+        UpdateScrollBars();
+    }
+}
+
+/**
+ * @brief Scroll a line (0 based) to the middle of the view and highlight it;
+ * the next Find() starts there.
+ */
+void NetlistViewer::GotoLine(const qint64 line) {
+    if (line_count == 0)
+        return;
+
+    current_line = std::max<qint64>(0, std::min(line, line_count - 1));
+    search_offset = LineOffset(current_line);
+    verticalScrollBar()->setValue(ScrollValue(current_line - LinesPerPage() / 2));
+    viewport()->update();
+}
+
+/**
+ * @brief Find the next occurrence of `text` (case sensitive) after the last
+ * match, wrapping around at the end of the file.
+ *
+ * @param text
+ * @return true : Found, the line is shown
+ * @return false : Not in the file
+ */
+bool NetlistViewer::Find(const QString text) {
+    QByteArray needle = text.toUtf8();
+    if (needle.isEmpty() || size == 0)
+        return false;
+
+    std::boyer_moore_horspool_searcher<const char*> searcher(needle.constData(),
+                                                            needle.constData() +
+                                                                needle.size());
+    const char* end = data + size;
+    const char* found = std::search(data + search_offset, end, searcher);
+    if (found == end)
+        found = std::search(data, end, searcher);
+    if (found == end)
+        return false;
+
+    qint64 offset = found - data;
+    GotoLine(LineOfOffset(offset));
+    search_offset = offset + 1;
+    return true;
+}
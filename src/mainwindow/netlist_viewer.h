@@ -0,0 +1,62 @@
+/**
+ * @file netlist_viewer.h
+ * @author Yaotian Liu
+ * @brief Read only viewer for netlists too large for the editor
+ * @date 2026-10-19
+ */
+
+#if !defined(NETLIST_VIEWER_H)
+#define NETLIST_VIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+// Files larger than this open in the viewer instead of the editor
+const qint64 LARGE_FILE_SIZE = 8 * 1024 * 1024;
+
+// One entry of the line index per this many lines
+const qint64 LINE_INDEX_STRIDE = 64;
+
+/**
+ * @brief Virtualized view of a memory mapped file: only the visible lines are
+ * decoded and painted. A sparse index of line offsets (every
+ * LINE_INDEX_STRIDE lines) keeps goto-line and search fast without holding the
+ * text in memory.
+ */
+class NetlistViewer : public QAbstractScrollArea {
+  public:
+    NetlistViewer(QWidget* parent = nullptr);
+    ~NetlistViewer();
+
+    bool Open(const QString file_name);
+    void Close();
+
+    qint64 LineCount() const { return line_count; }
+    void GotoLine(const qint64 line);
+    bool Find(const QString text);
+
+  protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+  private:
+    QFile file;
+    const char* data = nullptr;
+    qint64 size = 0;
+    qint64 line_count = 0;
+    std::vector<qint64> line_index_vec;  // Offset of line k * LINE_INDEX_STRIDE
+
+    qint64 current_line = -1;      // Highlighted line
+    qint64 search_offset = 0;      // Where the next search starts
+    int max_line_width = 0;        // Widest line painted so far, in pixels
+
+    qint64 LineOffset(const qint64 line) const;
+    qint64 LineOfOffset(const qint64 offset) const;
+    QString LineText(const qint64 line) const;
+    int LinesPerPage() const;
+    void UpdateScrollBars();
+};
+
+#endif  // NETLIST_VIEWER_H
@@ -0,0 +1,522 @@
+/**
+ * @file expression.cpp
+ * @author Yaotian Liu
+ * @brief Compiler and evaluator for .param / {expr} values
+ * @date 2026-10-19
+ */
+
+#include "expression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+// The evaluator runs on a fixed stack, deeper expressions are rejected.
+const int MAX_STACK_DEPTH = 64;
+
+struct FunctionInfo {
+    const char* name;
+    ExprFunction id;
+    int arity;
+};
+
+const FunctionInfo function_lut[] = {
+    {"sqrt", FN_SQRT, 1}, {"exp", FN_EXP, 1},   {"log", FN_LOG, 1},   {"ln", FN_LOG, 1},
+    {"log10", FN_LOG10, 1}, {"abs", FN_ABS, 1}, {"sin", FN_SIN, 1},   {"cos", FN_COS, 1},
+    {"tan", FN_TAN, 1},   {"atan", FN_ATAN, 1}, {"min", FN_MIN, 2},   {"max", FN_MAX, 2},
+    {"pow", FN_POW, 2},   {"pwr", FN_POW, 2}};
+
+double CallFunction(const int32_t id, const double a, const double b) {
+    switch (id) {
+        case FN_SQRT: return std::sqrt(a);
+        case FN_EXP: return std::exp(a);
+        case FN_LOG: return std::log(a);
+        case FN_LOG10: return std::log10(a);
+        case FN_ABS: return std::fabs(a);
+        case FN_SIN: return std::sin(a);
+        case FN_COS: return std::cos(a);
+        case FN_TAN: return std::tan(a);
+        case FN_ATAN: return std::atan(a);
+        case FN_MIN: return std::fmin(a, b);
+        case FN_MAX: return std::fmax(a, b);
+        case FN_POW: return std::pow(a, b);
+        default: return 0;
+    }
+}
+
+int FunctionArity(const int32_t id) {
+    for (auto& f : function_lut)
+        if (f.id == id)
+            return f.arity;
+    return 1;
+}
+
+double ApplyBinary(const ExprOpCode code, const double a, const double b) {
+    switch (code) {
+        case OP_ADD: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return a / b;
+        case OP_POW: return std::pow(a, b);
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Read a SPICE number with an optional scale suffix, e.g. `2.2k`,
+ * `10meg`, `1e-12`, `5pf` (trailing unit letters are ignored).
+ *
+ * @param text
+ * @param pos in: first character, out: first character after the number
+ * @param ok
+ * @return double
+ */
+double ParseSpiceNumber(const std::string& text, std::size_t& pos, bool& ok) {
+    std::size_t begin = pos;
+    std::size_t i = pos;
+    while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])))
+        i++;
+    if (i < text.size() && text[i] == '.') {
+        i++;
+        while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])))
+            i++;
+    }
+    if (i == begin || (i == begin + 1 && text[begin] == '.')) {
+        ok = false;
+        return 0;
+    }
+    // Exponent, only if digits follow
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        std::size_t j = i + 1;
+        if (j < text.size() && (text[j] == '+' || text[j] == '-'))
+            j++;
+        if (j < text.size() && std::isdigit(static_cast<unsigned char>(text[j]))) {
+            while (j < text.size() && std::isdigit(static_cast<unsigned char>(text[j])))
+                j++;
+            i = j;
+        }
+    }
+
+    double value = std::stod(text.substr(begin, i - begin));
+
+    if (text.compare(i, 3, "meg") == 0) {
+        value *= 1e6;
+        i += 3;
+    } else if (i < text.size()) {
+        switch (std::tolower(static_cast<unsigned char>(text[i]))) {
+            case 'f': value *= 1e-15; i++; break;
+            case 'p': value *= 1e-12; i++; break;
+            case 'n': value *= 1e-9; i++; break;
+            case 'u': value *= 1e-6; i++; break;
+            case 'm': value *= 1e-3; i++; break;
+            case 'k': value *= 1e3; i++; break;
+            case 'g': value *= 1e9; i++; break;
+            case 't': value *= 1e12; i++; break;
+            default: break;
+        }
+    }
+    // Units such as `ohm`, `f`, `h`, `v`
+    while (i < text.size() && std::isalpha(static_cast<unsigned char>(text[i])))
+        i++;
+
+    pos = i;
+    ok = true;
+    return value;
+}
+
+/**
+ * @brief Recursive descent compiler emitting postfix byte code.
+ *
+ * expr    := term (('+' | '-') term)*
+ * term    := unary (('*' | '/') unary)*
+ * unary   := ('-' | '+') unary | power
+ * power   := primary (('**' | '^') unary)?
+ * primary := number | name | name '(' expr (',' expr)* ')' | '(' expr ')'
+ */
+class ExprCompiler {
+  public:
+    ExprCompiler(const std::string& text, const ParamTable& param_table, Expression& expr)
+        : text(text), param_table(param_table), expr(expr) {}
+
+    bool Compile(std::string& error_msg) {
+        expr.code.clear();
+        expr.constants.clear();
+        bool ok = ParseExpr();
+        SkipSpace();
+        if (ok && pos != text.size())
+            Fail("unexpected '" + text.substr(pos, 1) + "'");
+        if (ok && expr.code.empty())
+            Fail("empty expression");
+        error_msg = error;
+        return error.empty();
+    }
+
+  private:
+    const std::string& text;
+    const ParamTable& param_table;
+    Expression& expr;
+    std::size_t pos = 0;
+    int depth = 0;
+    int max_depth = 0;
+    std::string error;
+
+    bool Fail(const std::string msg) {
+        if (error.empty())
+            error = msg;
+        return false;
+    }
+
+    void SkipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+            pos++;
+    }
+
+    bool Accept(const char* token) {
+        SkipSpace();
+        std::size_t len = std::char_traits<char>::length(token);
+        if (text.compare(pos, len, token) == 0) {
+            pos += len;
+            return true;
+        }
+        return false;
+    }
+
+    void Push(const int n) {
+        depth += n;
+        if (depth > max_depth)
+            max_depth = depth;
+        if (max_depth > MAX_STACK_DEPTH)
+            Fail("expression too deep");
+    }
+
+    bool LastIsConst(const int back) const {
+        int n = expr.code.size();
+        return n >= back && expr.code[n - back].code == OP_CONST;
+    }
+
+    double PopConst() {
+        ExprOp op = expr.code.back();
+        expr.code.pop_back();
+        double value = expr.constants[op.arg];
+        if (op.arg == static_cast<int32_t>(expr.constants.size()) - 1)
+            expr.constants.pop_back();
+        return value;
+    }
+
+    void EmitConst(const double value) {
+        expr.constants.push_back(value);
+        expr.code.push_back({OP_CONST, static_cast<int32_t>(expr.constants.size() - 1)});
+        Push(1);
+    }
+
+    void EmitUnary(const ExprOpCode code, const int32_t arg) {
+        if (LastIsConst(1)) {
+            double a = PopConst();
+            depth--;
+            EmitConst(code == OP_NEG ? -a : CallFunction(arg, a, 0));
+            return;
+        }
+        expr.code.push_back({code, arg});
+    }
+
+    void EmitBinary(const ExprOpCode code, const int32_t arg) {
+        if (LastIsConst(1) && LastIsConst(2)) {
+            double b = PopConst();
+            double a = PopConst();
+            depth -= 2;
+            EmitConst(code == OP_CALL ? CallFunction(arg, a, b) : ApplyBinary(code, a, b));
+            return;
+        }
+        expr.code.push_back({code, arg});
+        depth--;
+    }
+
+    bool ParseExpr() {
+        if (!ParseTerm())
+            return false;
+        while (true) {
+            if (Accept("+")) {
+                if (!ParseTerm())
+                    return false;
+                EmitBinary(OP_ADD, 0);
+            } else if (Accept("-")) {
+                if (!ParseTerm())
+                    return false;
+                EmitBinary(OP_SUB, 0);
+            } else
+                return true;
+        }
+    }
+
+    bool ParseTerm() {
+        if (!ParseUnary())
+            return false;
+        while (true) {
+            SkipSpace();
+            if (text.compare(pos, 2, "**") == 0)
+                return true;  // Handled by ParsePower
+            if (Accept("*")) {
+                if (!ParseUnary())
+                    return false;
+                EmitBinary(OP_MUL, 0);
+            } else if (Accept("/")) {
+                if (!ParseUnary())
+                    return false;
+                EmitBinary(OP_DIV, 0);
+            } else
+                return true;
+        }
+    }
+
+    bool ParseUnary() {
+        if (Accept("-")) {
+            if (!ParseUnary())
+                return false;
+            EmitUnary(OP_NEG, 0);
+            return true;
+        }
+        if (Accept("+"))
+            return ParseUnary();
+        return ParsePower();
+    }
+
+    bool ParsePower() {
+        if (!ParsePrimary())
+            return false;
+        if (Accept("**") || Accept("^")) {
+            if (!ParseUnary())
+                return false;
+            EmitBinary(OP_POW, 0);
+        }
+        return true;
+    }
+
+    bool ParsePrimary() {
+        SkipSpace();
+        if (pos >= text.size())
+            return Fail("unexpected end of expression");
+
+        char c = text[pos];
+
+        if (c == '(') {
+            pos++;
+            if (!ParseExpr())
+                return false;
+            if (!Accept(")"))
+                return Fail("missing ')'");
+            return true;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            bool ok;
+            double value = ParseSpiceNumber(text, pos, ok);
+            if (!ok)
+                return Fail("bad number");
+            EmitConst(value);
+            return true;
+        }
+
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            std::size_t begin = pos;
+            while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) ||
+                                         text[pos] == '_'))
+                pos++;
+            std::string name = text.substr(begin, pos - begin);
+
+            if (Accept("("))
+                return ParseCall(name);
+
+            int slot = param_table.Slot(name);
+            if (slot >= 0) {
+                expr.code.push_back({OP_PARAM, slot});
+                Push(1);
+                return true;
+            }
+            if (name == "pi") {
+                EmitConst(M_PI);
+                return true;
+            }
+            return Fail("unknown parameter '" + name + "'");
+        }
+
+        return Fail("unexpected '" + std::string(1, c) + "'");
+    }
+
+    bool ParseCall(const std::string& name) {
+        const FunctionInfo* function = nullptr;
+        for (auto& f : function_lut)
+            if (name == f.name)
+                function = &f;
+        if (function == nullptr)
+            return Fail("unknown function '" + name + "'");
+
+        for (int i = 0; i < function->arity; i++) {
+            if (i > 0 && !Accept(","))
+                return Fail("'" + name + "' needs " + std::to_string(function->arity) +
+                            " arguments");
+            if (!ParseExpr())
+                return false;
+        }
+        if (!Accept(")"))
+            return Fail("missing ')'");
+
+        if (function->arity == 1)
+            EmitUnary(OP_CALL, function->id);
+        else
+            EmitBinary(OP_CALL, function->id);
+        return true;
+    }
+};
+
+/**
+ * @brief Compile an expression against the parameters defined so far
+ *
+ * @param text expression without the surrounding braces or quotes
+ * @param param_table
+ * @param expr output
+ * @param error set when the compile fails
+ * @return true : Compiled
+ * @return false : Syntax error or unknown name
+ */
+bool CompileExpression(const std::string& text, const ParamTable& param_table,
+                       Expression& expr, std::string& error) {
+    ExprCompiler compiler(text, param_table, expr);
+    return compiler.Compile(error);
+}
+
+/**
+ * @brief Check byte code that did not come from the compiler (e.g. read back
+ * from a compiled netlist) before it is run: known opcodes and functions,
+ * constant and parameter indices in range, and a stack that never runs dry,
+ * stays within MAX_STACK_DEPTH and ends with one value.
+ *
+ * @param param_num parameter slots of the table it is evaluated against
+ * @return true : Safe to Evaluate()
+ * @return false : Corrupted
+ */
+bool Expression::Valid(const int param_num) const {
+    int depth = 0;
+    for (const ExprOp& op : code) {
+        int pop_num = 0;
+        switch (op.code) {
+            case OP_CONST:
+                if (op.arg < 0 || op.arg >= int(constants.size()))
+                    return false;
+                break;
+            case OP_PARAM:
+                if (op.arg < 0 || op.arg >= param_num)
+                    return false;
+                break;
+            case OP_NEG: pop_num = 1; break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV:
+            case OP_POW: pop_num = 2; break;
+            case OP_CALL: {
+                bool known = false;
+                for (auto& f : function_lut)
+                    known = known || f.id == op.arg;
+                if (!known)
+                    return false;
+                pop_num = FunctionArity(op.arg);
+                break;
+            }
+            default: return false;
+        }
+        if (depth < pop_num)
+            return false;
+        depth += pop_num == 0 ? 1 : 1 - pop_num;
+        if (depth > MAX_STACK_DEPTH)
+            return false;
+    }
+    return depth == 1;
+}
+
+/**
+ * @brief Run the byte code
+ *
+ * @param param_value_vec current values of the parameters
+ * @return double
+ */
+double Expression::Evaluate(const std::vector<double>& param_value_vec) const {
+    if (IsConstant())
+        return constants[0];
+
+    double stack[MAX_STACK_DEPTH];
+    int top = -1;
+
+    for (const ExprOp& op : code) {
+        switch (op.code) {
+            case OP_CONST: stack[++top] = constants[op.arg]; break;
+            case OP_PARAM: stack[++top] = param_value_vec[op.arg]; break;
+            case OP_NEG: stack[top] = -stack[top]; break;
+            case OP_CALL: {
+                if (FunctionArity(op.arg) == 2) {
+                    top--;
+                    stack[top] = CallFunction(op.arg, stack[top], stack[top + 1]);
+                } else
+                    stack[top] = CallFunction(op.arg, stack[top], 0);
+                break;
+            }
+            default: {
+                top--;
+                stack[top] = ApplyBinary(op.code, stack[top], stack[top + 1]);
+                break;
+            }
+        }
+    }
+    return stack[top];
+}
+
+int ParamTable::Slot(const std::string& name) const {
+    auto it = slot_map.find(name);
+    return it == slot_map.end() ? -1 : it->second;
+}
+
+/**
+ * @brief Define (or redefine) a parameter and evaluate it right away
+ *
+ * @param name
+ * @param expr
+ * @return int the slot of the parameter
+ */
+int ParamTable::Define(const std::string& name, const Expression& expr) {
+    int slot = Slot(name);
+    if (slot < 0) {
+        slot = name_vec.size();
+        name_vec.push_back(name);
+        expr_vec.push_back(expr);
+        value_vec.push_back(0);
+        slot_map[name] = slot;
+    } else
+        expr_vec[slot] = expr;
+    definition_vec.push_back({slot, expr});
+
+    value_vec[slot] = expr.Evaluate(value_vec);
+    return slot;
+}
+
+/**
+ * @brief Re-evaluate every parameter from its definitions, replayed in order
+ * from zero, e.g. once per sweep point or Monte Carlo sample. The values of
+ * the last evaluation are never read, so repeated calls give the same result.
+ *
+ * @param override_vec (slot, value) pairs that replace the expressions of the
+ * parameter, so parameters depending on it follow.
+ */
+void ParamTable::Evaluate(const std::vector<std::pair<int, double>>& override_vec) {
+    std::fill(value_vec.begin(), value_vec.end(), 0);
+    for (auto& definition : definition_vec) {
+        int slot = definition.first;
+        bool overridden = false;
+        for (auto& o : override_vec) {
+            if (o.first == slot) {
+                value_vec[slot] = o.second;
+                overridden = true;
+            }
+        }
+        if (!overridden)
+            value_vec[slot] = definition.second.Evaluate(value_vec);
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * @file expression.h
+ * @author Yaotian Liu
+ * @brief Compiler and evaluator for .param / {expr} values
+ * @date 2026-10-19
+ */
+
+#if !defined(EXPRESSION_H)
+#define EXPRESSION_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum ExprOpCode : uint8_t {
+    OP_CONST,  // push constants[arg]
+    OP_PARAM,  // push param value[arg]
+    OP_NEG,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_CALL  // call function arg on the top of stack
+};
+
+enum ExprFunction : int32_t {
+    FN_SQRT,
+    FN_EXP,
+    FN_LOG,
+    FN_LOG10,
+    FN_ABS,
+    FN_SIN,
+    FN_COS,
+    FN_TAN,
+    FN_ATAN,
+    FN_MIN,
+    FN_MAX,
+    FN_POW
+};
+
+struct ExprOp {
+    ExprOpCode code;
+    int32_t arg;
+};
+
+/**
+ * @brief A compiled expression: postfix byte code over a constant pool.
+ * Sub-expressions with only literals are folded while compiling, so an
+ * expression without parameters is a single OP_CONST.
+ */
+struct Expression {
+    std::vector<ExprOp> code;
+    std::vector<double> constants;
+
+    bool IsConstant() const { return code.size() == 1 && code[0].code == OP_CONST; }
+    bool Valid(const int param_num) const;
+    double Evaluate(const std::vector<double>& param_value_vec) const;
+};
+
+/**
+ * @brief Parameters from .param, in definition order. A parameter may only
+ * refer to parameters defined before it, so evaluating in order is enough.
+ */
+struct ParamTable {
+    std::vector<std::string> name_vec;
+    std::vector<Expression> expr_vec;
+    std::vector<double> value_vec;
+    std::unordered_map<std::string, int> slot_map;
+    // (slot, expression) of every definition in order, redefinitions included,
+    // so that `.param a={a+1}` sees the value before it on every evaluation
+    std::vector<std::pair<int, Expression>> definition_vec;
+
+    int Slot(const std::string& name) const;
+    int Define(const std::string& name, const Expression& expr);
+    void Evaluate(const std::vector<std::pair<int, double>>& override_vec = {});
+};
+
+bool CompileExpression(const std::string& text, const ParamTable& param_table,
+                       Expression& expr, std::string& error);
+
+double ParseSpiceNumber(const std::string& text, std::size_t& pos, bool& ok);
+
+#endif  // EXPRESSION_H
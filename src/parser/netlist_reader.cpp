@@ -0,0 +1,69 @@
+/**
+ * @file netlist_reader.cpp
+ * @author Yaotian Liu
+ * @brief Line reader over a memory mapped netlist
+ * @date 2026-10-19
+ */
+
+#include "netlist_reader.h"
+
+#include <cstring>
+
+NetlistReader::~NetlistReader() {
+    if (data != nullptr)
+        file.unmap(data);
+}
+
+/**
+ * @brief Map the file into memory
+ *
+ * @param file_name
+ * @return true : Opened
+ * @return false : Not readable
+ */
+bool NetlistReader::Open(const QString file_name) {
+    file.setFileName(file_name);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = file.size();
+    if (size > 0)
+        data = file.map(0, size);
+
+    if (data != nullptr) {
+        cursor = reinterpret_cast<const char*>(data);
+    } else {
+        buffer = file.readAll();
+        cursor = buffer.constData();
+        size = buffer.size();
+    }
+    end = cursor + size;
+    line_num = 0;
+    return true;
+}
+
+/**
+ * @brief Read the next line without the line break
+ *
+ * @param line
+ * @return true : A line is read
+ * @return false : End of file
+ */
+bool NetlistReader::ReadLine(QString& line) {
+    if (cursor == nullptr || cursor >= end)
+        return false;
+
+    const char* line_end =
+        static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+    if (line_end == nullptr)
+        line_end = end;
+
+    const char* content_end = line_end;
+    if (content_end > cursor && content_end[-1] == '\r')
+        content_end--;
+
+    line = QString::fromUtf8(cursor, content_end - cursor);
+    cursor = line_end < end ? line_end + 1 : end;
+    line_num++;
+    return true;
+}
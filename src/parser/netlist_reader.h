@@ -0,0 +1,39 @@
+/**
+ * @file netlist_reader.h
+ * @author Yaotian Liu
+ * @brief Line reader over a memory mapped netlist
+ * @date 2026-10-19
+ */
+
+#if !defined(NETLIST_READER_H)
+#define NETLIST_READER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+/**
+ * @brief Reads a netlist line by line straight out of a file mapping, so the
+ * deck and every included file go through the same path without a QTextStream
+ * copy of the whole file.
+ */
+class NetlistReader {
+  public:
+    NetlistReader() {}
+    ~NetlistReader();
+
+    bool Open(const QString file_name);
+    bool ReadLine(QString& line);
+    int LineNumber() { return line_num; }
+
+  private:
+    QFile file;
+    uchar* data = nullptr;
+    QByteArray buffer;  // Fallback when the file cannot be mapped
+
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    int line_num = 0;
+};
+
+#endif  // NETLIST_READER_H
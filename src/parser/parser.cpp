@@ -7,38 +7,140 @@
 
 #include "parser.h"
 
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
 #include "../utils/utils.h"
+#include "netlist_reader.h"
 
 using std::cout;
 using std::endl;
 
-const int MAGIC = 407000002;
-
 Parser::Parser() {
+    output = nullptr;
     command_op = false;
     command_end = false;
     analysis_type = NONE;
+    print_type = NONE;
+    current_subckt = -1;
+    include_depth = 0;
+    in_lib_section = false;
+    skip_lib_section = false;
 }
 
 Parser::Parser(QTextEdit* output) {
     command_op = false;
     command_end = false;
     analysis_type = NONE;
+    print_type = NONE;
+    current_subckt = -1;
+    include_depth = 0;
+    in_lib_section = false;
+    skip_lib_section = false;
     this->output = output;
 }
 
 Parser::~Parser() {}
 
+/**
+ * @brief Append a message to the output window. Safe to call from a worker
+ * thread (the append is queued to the GUI thread) and without a window.
+ *
+ * @param text
+ */
+void Parser::Output(const QString text) {
+    if (output != nullptr)
+        QMetaObject::invokeMethod(output, "append", Q_ARG(QString, text));
+}
+
+/**
+ * @brief Parse a netlist file. Included files go through here as well.
+ *
+ * @param file_name
+ * @param has_title the first line of a deck is its title
+ * @return true : File read
+ * @return false : Failed to open
+ */
+bool Parser::ParseFile(const QString file_name, const bool has_title) {
+    NetlistReader reader;
+    if (!reader.Open(file_name))
+        return false;
+
+    deck_dir = QFileInfo(file_name).absolutePath();
+
+    QString line;
+    while (reader.ReadLine(line)) {
+        int lineCount = reader.LineNumber();
+        if (has_title && lineCount == 1) {
+            title = line;
+            cout << "Parsed Title: " << line << endl;
+            Output(QString("Parsed Title: ") + line);
+        } else
+            ParseLine(line, lineCount);
+    }
+    return true;
+}
+
+/**
+ * @brief Dispatch one line of the netlist
+ *
+ * @param line the line as written in the file
+ * @param lineNum
+ */
+void Parser::ParseLine(const QString line, const int lineNum) {
+    if (line.size() == 0)
+        return;
+
+    if (line.startsWith("*")) {
+        cout << "Parsed Annotation: " << line << endl;
+        Output(QString("Parsed Annotation: ") + line);
+        return;
+    }
+
+    QString lower_line = line.toLower();  // SPICE is case-insensistive
+    QStringList elements = lower_line.simplified().split(" ");
+    QString command = elements[0];
+
+    // `.lib name` ... `.endl` marks a section of a library file
+    if (command == ".lib" && elements.length() == 2) {
+        in_lib_section = true;
+        skip_lib_section = elements[1] != lib_section;
+        return;
+    }
+    if (command == ".endl") {
+        in_lib_section = false;
+        skip_lib_section = false;
+        return;
+    }
+    if (SkippingLines())
+        return;
+
+    if (command == ".include" || command == ".inc" || command == ".lib")
+        IncludeParser(line, lineNum);  // File names keep their case
+    else if (command == ".options" || command == ".option")
+        OptionParser(line, lineNum);
+    else if (lower_line.startsWith("."))
+        CommandParser(lower_line, lineNum);
+    else
+        DeviceParser(lower_line, lineNum);
+}
+
 void Parser::DeviceParser(const QString line, const int lineNum) {
-    QStringList elements = line.split(" ");
+    QStringList elements = SplitLine(line);
     int num_elements = elements.length();
 
     DeviceName device_name = elements[0];
 
+    // Devices inside .subckt/.ends belong to the definition, not the top level.
+    Circuit& target = CurrentCircuit();
+
     // Process Voltage Source
     // TODO: Update Vsrc grammer
     if (line.startsWith("v")) {
-        if (CheckNameRepetition<Vsrc>(circuit.vsrc_vec, device_name)) {
+        if (CheckNameRepetition<Vsrc>(target.vsrc_vec, device_name)) {
             ParseError("which already exits.", device_name, lineNum);
             return;
         }
@@ -46,14 +148,15 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         switch (num_elements) {
                 // Vx 1 0 10
             case 4: {
-                double value = ParseValue(elements[3]);
+                double value = ParseDeviceValue(target, VSRC_KIND, target.vsrc_vec.size(),
+                                                elements[3]);
                 NodeName node_1 = ReadNodeName(elements[1]);
                 NodeName node_2 = ReadNodeName(elements[2]);
 
-                circuit.vsrc_vec.push_back(
+                target.vsrc_vec.push_back(
                     Vsrc(device_name, analysis_type, value, node_1, node_2));
 
-                output->append(QString("Parsed Device Type: Voltage Source (Name: ") +
+                Output(QString("Parsed Device Type: Voltage Source (Name: ") +
                                device_name +
                                QString("; Value: " + QString::number(value, 'f', 3)) +
                                QString("; Node1: ") + node_1 + QString("; Node2: ") +
@@ -70,7 +173,8 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
                 // Vx 1 0 dc 10
                 // TODO: Wrong need to be fixed
             case 5: {
-                double value = ParseValue(elements[4]);
+                double value = ParseDeviceValue(target, VSRC_KIND, target.vsrc_vec.size(),
+                                                elements[4]);
                 NodeName node_1 = ReadNodeName(elements[1]);
                 NodeName node_2 = ReadNodeName(elements[2]);
                 if (elements[3] == "dc")
@@ -81,10 +185,10 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
                 } else
                     ParseError("", device_name, lineNum);
 
-                circuit.vsrc_vec.push_back(
+                target.vsrc_vec.push_back(
                     Vsrc(device_name, analysis_type, value, node_1, node_2));
 
-                output->append(QString("Parsed Device Type: Voltage Source (Name: ") +
+                Output(QString("Parsed Device Type: Voltage Source (Name: ") +
                                device_name +
                                QString("; Value: " + QString::number(value, 'f', 3)) +
                                QString("; Node1: ") + node_1 + QString("; Node2: ") +
@@ -115,9 +219,9 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
                     pulse.pw = ParseValue(elements[9]);
                     pulse.per = ParseValue(elements[10]);
 
-                    circuit.vsrc_vec.push_back(Vsrc(device_name, node_1, node_2, pulse));
+                    target.vsrc_vec.push_back(Vsrc(device_name, node_1, node_2, pulse));
 
-                    // output->append(QString("Parsed Device Type: Voltage Source (Name:
+                    // Output(QString("Parsed Device Type: Voltage Source (Name:
                     // ") +
                     //                device_name +
                     //                QString("; Node1: ") + node_1 + QString("; Node2: ")
@@ -148,7 +252,7 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
                     sin.freq = ParseValue(elements[7]);
                     sin.td = ParseValue(elements[8]);
                     sin.theta = ParseValue(elements[9]);
-                    circuit.vsrc_vec.push_back(Vsrc(device_name, node_1, node_2, sin));
+                    target.vsrc_vec.push_back(Vsrc(device_name, node_1, node_2, sin));
 
                     cout << "Parsed Device Type: Voltage Source ("
                          << "Name: " << device_name << "; "
@@ -170,7 +274,7 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
     // Process Current source
     // TODO: Update Isrc grammer
     else if (line.startsWith("i")) {
-        if (CheckNameRepetition(circuit.isrc_vec, device_name)) {
+        if (CheckNameRepetition(target.isrc_vec, device_name)) {
             ParseError("which already exits.", device_name, lineNum);
             return;
         }
@@ -187,7 +291,8 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
 
         // If the third is a number, it's dc_value.
         if (ParseValue(elements[3]) != MAGIC) {
-            dc_value = ParseValue(elements[3]);
+            dc_value = ParseDeviceValue(target, ISRC_KIND, target.isrc_vec.size(),
+                                        elements[3]);
             // More elements
             if (num_elements >= 5) {
                 // const(1)
@@ -214,7 +319,7 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
             }
         }
 
-        circuit.isrc_vec.push_back(
+        target.isrc_vec.push_back(
             Isrc(device_name, dc_value, node_1, node_2, ac_value, tran_const_value));
 
         cout << "Parsed Device Type: Current Source ("
@@ -231,17 +336,18 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         if (num_elements != 4) {
             ParseError("", device_name, lineNum);
         } else {
-            if (CheckNameRepetition<Res>(circuit.res_vec, device_name)) {
+            if (CheckNameRepetition<Res>(target.res_vec, device_name)) {
                 ParseError("which already exits.", device_name, lineNum);
                 return;
             }
 
-            double value = ParseValue(elements[3]);
+            double value =
+                ParseDeviceValue(target, RES_KIND, target.res_vec.size(), elements[3]);
             NodeName node_1 = ReadNodeName(elements[1]);
             NodeName node_2 = ReadNodeName(elements[2]);
-            circuit.res_vec.push_back(Res(device_name, value, node_1, node_2));
+            target.res_vec.push_back(Res(device_name, value, node_1, node_2));
 
-            output->append(QString("Parsed Device Type: Register (Name: ") + device_name +
+            Output(QString("Parsed Device Type: Register (Name: ") + device_name +
                            QString("; Value: " + QString::number(value, 'f', 3)) +
                            QString("; Node1: ") + node_1 + QString("; Node2: ") + node_2 +
                            QString(")"));
@@ -259,17 +365,18 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         if (num_elements != 4) {
             ParseError("", device_name, lineNum);
         } else {
-            if (CheckNameRepetition<Cap>(circuit.cap_vec, device_name)) {
+            if (CheckNameRepetition<Cap>(target.cap_vec, device_name)) {
                 ParseError("which already exits.", device_name, lineNum);
                 return;
             }
 
-            double value = ParseValue(elements[3]);
+            double value =
+                ParseDeviceValue(target, CAP_KIND, target.cap_vec.size(), elements[3]);
             NodeName node_1 = ReadNodeName(elements[1]);
             NodeName node_2 = ReadNodeName(elements[2]);
-            circuit.cap_vec.push_back(Cap(device_name, value, node_1, node_2));
+            target.cap_vec.push_back(Cap(device_name, value, node_1, node_2));
 
-            output->append(QString("Parsed Device Type: Capacitor (Name: ") +
+            Output(QString("Parsed Device Type: Capacitor (Name: ") +
                            device_name +
                            QString("; Value: " + QString::number(value, 'f', 3)) +
                            QString("; Node1: ") + node_1 + QString("; Node2: ") + node_2 +
@@ -288,17 +395,18 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         if (num_elements != 4) {
             ParseError("", device_name, lineNum);
         } else {
-            if (CheckNameRepetition<Ind>(circuit.ind_vec, device_name)) {
+            if (CheckNameRepetition<Ind>(target.ind_vec, device_name)) {
                 ParseError("which already exits.", device_name, lineNum);
                 return;
             }
 
-            double value = ParseValue(elements[3]);
+            double value =
+                ParseDeviceValue(target, IND_KIND, target.ind_vec.size(), elements[3]);
             NodeName node_1 = ReadNodeName(elements[1]);
             NodeName node_2 = ReadNodeName(elements[2]);
-            circuit.ind_vec.push_back(Ind(device_name, value, node_1, node_2));
+            target.ind_vec.push_back(Ind(device_name, value, node_1, node_2));
 
-            output->append(QString("Parsed Device Type: Inductor (Name: ") + device_name +
+            Output(QString("Parsed Device Type: Inductor (Name: ") + device_name +
                            QString("; Value: " + QString::number(value, 'f', 3)) +
                            QString("; Node1: ") + node_1 + QString("; Node2: ") + node_2 +
                            QString(")"));
@@ -316,20 +424,21 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         if (num_elements != 6) {
             ParseError("", device_name, lineNum);
         } else {
-            if (CheckNameRepetition<VCCS>(circuit.vccs_vec, device_name)) {
+            if (CheckNameRepetition<VCCS>(target.vccs_vec, device_name)) {
                 ParseError("which already exits.", device_name, lineNum);
                 return;
             }
 
-            double value = ParseValue(elements[5]);
+            double value =
+                ParseDeviceValue(target, VCCS_KIND, target.vccs_vec.size(), elements[5]);
             NodeName node_1 = ReadNodeName(elements[1]);
             NodeName node_2 = ReadNodeName(elements[2]);
             NodeName ctrl_node_1 = ReadNodeName(elements[3]);
             NodeName ctrl_node_2 = ReadNodeName(elements[4]);
-            circuit.vccs_vec.push_back(
+            target.vccs_vec.push_back(
                 VCCS(device_name, value, node_1, node_2, ctrl_node_1, ctrl_node_2));
 
-            output->append(QString("Parsed Device Type: VCCS (Name: ") + device_name +
+            Output(QString("Parsed Device Type: VCCS (Name: ") + device_name +
                            QString("; Value: " + QString::number(value, 'f', 3)) +
                            QString("; Node1: ") + node_1 + QString("; Node2: ") + node_2 +
                            QString("; CtrlNode1: ") + ctrl_node_1 +
@@ -350,20 +459,21 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         if (num_elements != 6) {
             ParseError("", device_name, lineNum);
         } else {
-            if (CheckNameRepetition<VCVS>(circuit.vcvs_vec, device_name)) {
+            if (CheckNameRepetition<VCVS>(target.vcvs_vec, device_name)) {
                 ParseError("which already exits.", device_name, lineNum);
                 return;
             }
 
-            double value = ParseValue(elements[5]);
+            double value =
+                ParseDeviceValue(target, VCVS_KIND, target.vcvs_vec.size(), elements[5]);
             NodeName node_1 = ReadNodeName(elements[1]);
             NodeName node_2 = ReadNodeName(elements[2]);
             NodeName ctrl_node_1 = ReadNodeName(elements[3]);
             NodeName ctrl_node_2 = ReadNodeName(elements[4]);
-            circuit.vcvs_vec.push_back(
+            target.vcvs_vec.push_back(
                 VCVS(device_name, value, node_1, node_2, ctrl_node_1, ctrl_node_2));
 
-            output->append(QString("Parsed Device Type: VCVS (Name: ") + device_name +
+            Output(QString("Parsed Device Type: VCVS (Name: ") + device_name +
                            QString("; Value: " + QString::number(value, 'f', 3)) +
                            QString("; Node1: ") + node_1 + QString("; Node2: ") + node_2 +
                            QString("; CtrlNode1: ") + ctrl_node_1 +
@@ -384,7 +494,7 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
         if (num_elements != 4)
             ParseError("parameter error", device_name, lineNum);
         else {
-            if (CheckNameRepetition(circuit.diode_vec, device_name)) {
+            if (CheckNameRepetition(target.diode_vec, device_name)) {
                 ParseError("already exits", device_name, lineNum);
                 return;
             }
@@ -406,9 +516,9 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
                 return;
             }
 
-            circuit.diode_vec.push_back(Diode(device_name, node_1, node_2, model));
+            target.diode_vec.push_back(Diode(device_name, node_1, node_2, model));
 
-            output->append(QString("Parsed Device Type: Diode (Name: ") + device_name +
+            Output(QString("Parsed Device Type: Diode (Name: ") + device_name +
                            QString("; Node1: ") + node_1 + QString("; Node2: ") + node_2 +
                            QString("; Model: ") + model + QString(")"));
 
@@ -417,6 +527,38 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
                  << ')' << endl;
         }
     }
+
+    // Subcircuit instance
+    // X1 n1 n2 ... subckt_name
+    else if (line.startsWith("x")) {
+        if (num_elements < 3)
+            ParseError("parameter error", device_name, lineNum);
+        else {
+            if (CheckNameRepetition(target.instance_vec, device_name)) {
+                ParseError("already exits", device_name, lineNum);
+                return;
+            }
+
+            SubcktInstance instance;
+            instance.name = device_name;
+            instance.subckt = elements[num_elements - 1];
+            for (int i = 1; i < num_elements - 1; i++)
+                instance.node_vec.push_back(ReadNodeName(elements[i]));
+
+            target.instance_vec.push_back(instance);
+
+            Output(QString("Parsed Subckt Instance (Name: ") + device_name +
+                           QString("; Subckt: ") + instance.subckt +
+                           QString("; Nodes: ") + QString::number(num_elements - 2) +
+                           QString(")"));
+
+            cout << "Parsed Subckt Instance (Name: " << device_name
+                 << "; Subckt: " << instance.subckt << "; Nodes:";
+            for (auto node : instance.node_vec)
+                cout << " " << node;
+            cout << ')' << endl;
+        }
+    }
 }
 
 /**
@@ -426,7 +568,7 @@ void Parser::DeviceParser(const QString line, const int lineNum) {
  * @param lineNum
  */
 void Parser::CommandParser(const QString line, const int lineNum) {
-    QStringList elements = line.split(" ");
+    QStringList elements = SplitLine(line);
     int num_elements = elements.length();
 
     QString command = elements[0];
@@ -441,10 +583,49 @@ void Parser::CommandParser(const QString line, const int lineNum) {
             cout << "Parsed Analysis Command .OP Token" << endl;
         }
     }
+    // .SUBCKT name port_1 port_2 ...
+    else if (command == ".subckt") {
+        if (num_elements < 2)
+            ParseError("need a name", ".subckt", lineNum);
+        else if (current_subckt >= 0)
+            ParseError("nested definition is not supported", elements[1], lineNum);
+        else if (CheckNameRepetition(circuit.subckt_vec, elements[1]))
+            ParseError("which already exits.", elements[1], lineNum);
+        else {
+            SubcktDef subckt;
+            subckt.name = elements[1];
+            for (int i = 2; i < num_elements; i++)
+                subckt.port_vec.push_back(ReadNodeName(elements[i]));
+
+            circuit.subckt_vec.push_back(subckt);
+            current_subckt = circuit.subckt_vec.size() - 1;
+
+            cout << "Parsed Subckt Definition (Name: " << subckt.name
+                 << "; Ports: " << subckt.port_vec.size() << ")" << endl;
+        }
+    }
+    // .ENDS [name]
+    else if (command == ".ends") {
+        if (current_subckt < 0)
+            ParseError("no matching .subckt", ".ends", lineNum);
+        else if (num_elements > 1 && elements[1] != circuit.subckt_vec[current_subckt].name)
+            ParseError("name does not match .subckt", elements[1], lineNum);
+        else {
+            cout << "Parsed .ENDS Token ("
+                 << circuit.subckt_vec[current_subckt].name << ")" << endl;
+            current_subckt = -1;
+        }
+    }
+    // .PARAM name=value ...
+    else if (command == ".param") {
+        ParamParser(line, lineNum);
+    }
     // .END
     else if (command == ".end") {
         if (num_elements != 1)
             ParseError("", ".end", lineNum);
+        else if (current_subckt >= 0)
+            ParseError("missing .ends", ".end", lineNum);
         else {
             command_end = true;
             cout << "Parsed .END Token" << endl;
@@ -472,6 +653,8 @@ void Parser::CommandParser(const QString line, const int lineNum) {
                 print_type = AC;
             else if (elements[1] == "tran" && analysis_type == TRAN)
                 print_type = TRAN;
+            else if (elements[1] == "mc" && analysis_type == MC)
+                print_type = MC;
             else {
                 ParseError("invalid analysis type.", ".print", lineNum);
                 return;
@@ -564,6 +747,209 @@ void Parser::CommandParser(const QString line, const int lineNum) {
              << "(Tstep: " << tran_analysis.t_step << "; tstop: " << tran_analysis.t_stop
              << "; tstart: " << tran_analysis.t_start << " )" << endl;
     }
+
+    // .mc sample_num [seed]
+    else if (command == ".mc") {
+        if (num_elements != 2 && num_elements != 3) {
+            ParseError("", ".mc", lineNum);
+            return;
+        }
+        double sample_num = ParseValue(elements[1]);
+        double seed = num_elements == 3 ? ParseValue(elements[2]) : 1;
+        if (sample_num == MAGIC || sample_num < 1 || seed == MAGIC || seed < 0) {
+            ParseError("invalid sample count or seed", ".mc", lineNum);
+            return;
+        }
+
+        analysis_type = MC;
+        mc_analysis.sample_num = sample_num;
+        mc_analysis.seed = seed;
+        cout << "Parsed Analysis Command MC "
+             << "(Samples: " << mc_analysis.sample_num << "; "
+             << "Seed: " << mc_analysis.seed << ")" << endl;
+    }
+
+    // .step ...
+    else if (command == ".step") {
+        StepParser(elements, lineNum);
+    }
+
+    // .tol device tolerance [gauss|unif]
+    else if (command == ".tol") {
+        if (num_elements != 3 && num_elements != 4) {
+            ParseError("", ".tol", lineNum);
+            return;
+        }
+
+        McTolerance tolerance;
+        tolerance.device = elements[1];
+
+        QString value = elements[2];
+        bool percent = value.endsWith("%");
+        if (percent)
+            value.chop(1);
+        tolerance.tolerance = ParseValue(value);
+        if (tolerance.tolerance == MAGIC || tolerance.tolerance < 0) {
+            ParseError("invalid tolerance", elements[1], lineNum);
+            return;
+        }
+        if (percent)
+            tolerance.tolerance /= 100;
+
+        tolerance.distribution = GAUSS;
+        if (num_elements == 4) {
+            if (elements[3] == qstr(McDistribution_lookup[UNIFORM]))
+                tolerance.distribution = UNIFORM;
+            else if (elements[3] != qstr(McDistribution_lookup[GAUSS])) {
+                ParseError("unknown distribution", elements[3], lineNum);
+                return;
+            }
+        }
+
+        mc_analysis.tolerance_vec.push_back(tolerance);
+        cout << "Parsed Tolerance (Device: " << tolerance.device << "; "
+             << "Tolerance: " << tolerance.tolerance << "; "
+             << "Distribution: " << McDistribution_lookup[tolerance.distribution] << ")"
+             << endl;
+    }
+}
+
+/**
+ * @brief .step [lin|dec|oct] [param] name start stop step|points
+ *        .step [param] name list value ...
+ * The values are expanded here; the name is looked up in the flattened circuit
+ * when the analysis runs.
+ *
+ * @param elements
+ * @param lineNum
+ */
+void Parser::StepParser(const QStringList elements, const int lineNum) {
+    int i = 1;
+    AcVariationType variation_type = LIN;
+    for (uint k = 0; k < AcVariationType_lookup.size() && i < elements.length(); k++) {
+        if (elements[i] == qstr(AcVariationType_lookup[k])) {
+            variation_type = static_cast<AcVariationType>(k);
+            i++;
+            break;
+        }
+    }
+
+    StepAnalysis step;
+    if (i < elements.length() && elements[i] == "param") {
+        step.param = true;
+        i++;
+    }
+    if (i >= elements.length()) {
+        ParseError("need a parameter or device", ".step", lineNum);
+        return;
+    }
+    step.name = elements[i++];
+
+    std::vector<double> number_vec;
+    bool list = i < elements.length() && elements[i] == "list";
+    for (i += list ? 1 : 0; i < elements.length(); i++) {
+        double value = ParseValue(elements[i]);
+        if (value == MAGIC) {
+            ParseError("invalid value", elements[i], lineNum);
+            return;
+        }
+        number_vec.push_back(value);
+    }
+
+    if (list) {
+        step.value_vec = number_vec;
+    } else if (number_vec.size() != 3) {
+        ParseError("need start, stop and step", ".step", lineNum);
+        return;
+    } else {
+        double start = number_vec[0];
+        double stop = number_vec[1];
+        double step_size = number_vec[2];
+        double tolerance = 1e-9 * std::max(std::fabs(start), std::fabs(stop));
+
+        if (variation_type == LIN) {
+            if (step_size <= 0) {
+                ParseError("step must be positive", ".step", lineNum);
+                return;
+            }
+            for (int k = 0; start + k * step_size <= stop + tolerance &&
+                            step.value_vec.size() <= MAX_STEP_NUM;
+                 k++)
+                step.value_vec.push_back(start + k * step_size);
+        } else {
+            // Points per decade / octave
+            if (start <= 0 || step_size < 1) {
+                ParseError("need a positive start and points", ".step", lineNum);
+                return;
+            }
+            double ratio = pow(variation_type == DEC ? 10 : 2, 1 / step_size);
+            for (int k = 0; start * pow(ratio, k) <= stop + tolerance &&
+                            step.value_vec.size() <= MAX_STEP_NUM;
+                 k++)
+                step.value_vec.push_back(start * pow(ratio, k));
+        }
+    }
+
+    if (step.value_vec.empty() || step.value_vec.size() > MAX_STEP_NUM) {
+        ParseError("no values or too many values", ".step", lineNum);
+        return;
+    }
+
+    step_analysis = step;
+    cout << "Parsed Step (" << (step.param ? "Param: " : "Device: ") << step.name << "; "
+         << "Values: " << step.value_vec.size() << ")" << endl;
+}
+
+/**
+ * @brief Parser for .options
+ * .options rawfile=out.raw key=value flag
+ * Keys are case-insensitive, values keep their case (file names).
+ *
+ * @param line the line with its original case
+ * @param lineNum
+ */
+void Parser::OptionParser(const QString line, const int lineNum) {
+    QString assignments = line.simplified();
+    assignments.replace(QRegularExpression("\\s*=\\s*"), "=");
+    QStringList items = assignments.split(" ");
+    items.removeFirst();
+
+    if (items.isEmpty()) {
+        ParseError("need options", ".options", lineNum);
+        return;
+    }
+
+    for (QString item : items) {
+        int equal = item.indexOf('=');
+        QString key = (equal < 0 ? item : item.left(equal)).toLower();
+        QString value = equal < 0 ? QString("1") : item.mid(equal + 1);
+
+        // Output files are relative to the deck
+        if (key == "rawfile")
+            value = QDir(deck_dir).absoluteFilePath(value);
+
+        options[key] = value;
+        cout << "Parsed Option (" << key << ": " << value << ")" << endl;
+    }
+}
+
+QString GetOption(const SimulationOptions& options, const QString key,
+                  const QString default_value) {
+    auto it = options.find(key);
+    return it == options.end() ? default_value : it->second;
+}
+
+double GetOptionValue(const SimulationOptions& options, const QString key,
+                      const double default_value) {
+    auto it = options.find(key);
+    if (it == options.end())
+        return default_value;
+
+    std::string text = str(it->second.toLower());
+    std::size_t pos = 0;
+    bool ok;
+    double value = ParseSpiceNumber(text, pos, ok);
+    return ok ? value : default_value;
 }
 
 // TODO: This method is far from complete.
@@ -613,6 +999,40 @@ void Parser::PrintCommandParser(const QStringList elements) {
     }
 }
 
+/**
+ * @brief Split a line on white space, keeping `{...}` and `'...'` expressions
+ * in one element even if they contain spaces.
+ *
+ * @param line
+ * @return QStringList
+ */
+QStringList Parser::SplitLine(const QString line) {
+    QStringList elements;
+    QString element;
+    int brace_depth = 0;
+    bool in_quote = false;
+
+    for (QChar c : line) {
+        if (c == '{')
+            brace_depth++;
+        else if (c == '}')
+            brace_depth--;
+        else if (c == '\'')
+            in_quote = !in_quote;
+
+        if (c.isSpace() && brace_depth <= 0 && !in_quote) {
+            if (!element.isEmpty())
+                elements.append(element);
+            element.clear();
+        } else
+            element.append(c);
+    }
+    if (!element.isEmpty() || elements.isEmpty())
+        elements.append(element);
+
+    return elements;
+}
+
 /**
  * @brief To parse the value correctly
  *
@@ -622,6 +1042,14 @@ void Parser::PrintCommandParser(const QStringList elements) {
 double Parser::ParseValue(const QString value_in_str) {
     double value = MAGIC;  // If the return is MAGIC, means the value parse failed.
 
+    // {expr} or 'expr', evaluated with the parameters defined so far
+    if (IsExpression(value_in_str)) {
+        Expression expr;
+        if (CompileValue(value_in_str, expr))
+            value = expr.Evaluate(circuit.param_table.value_vec);
+        return value;
+    }
+
     QRegExp number_with_e("\\d+(\\.\\d+)?e-?\\d+");
     if (number_with_e.exactMatch(value_in_str)) {
         value = value_in_str.toDouble();
@@ -684,7 +1112,16 @@ NodeName Parser::ReadNodeName(const QString qstr_name) {
 /**
  * @brief Update and sort node_vec
  */
-void Parser::UpdateNodeVec() {
+void Parser::UpdateNodeVec() { circuit.node_vec = CollectNodeVec(circuit); }
+
+/**
+ * @brief Collect the sorted, unique nodes referenced by the devices and the
+ * subckt instances of a circuit (definitions are not visited).
+ *
+ * @param circuit
+ * @return std::vector<NodeName>
+ */
+std::vector<NodeName> CollectNodeVec(const Circuit& circuit) {
     std::vector<NodeName> temp_node_vec;
 
     for (auto Vsrc : circuit.vsrc_vec) {
@@ -731,10 +1168,15 @@ void Parser::UpdateNodeVec() {
         temp_node_vec.push_back(Diode.node_2);
     }
 
+    for (auto instance : circuit.instance_vec)
+        for (auto node : instance.node_vec)
+            temp_node_vec.push_back(node);
+
     std::set<NodeName> node_set(temp_node_vec.begin(), temp_node_vec.end());
 
-    circuit.node_vec = std::vector<NodeName>(node_set.begin(), node_set.end());
-    std::sort(circuit.node_vec.begin(), circuit.node_vec.end());
+    std::vector<NodeName> node_vec(node_set.begin(), node_set.end());
+    std::sort(node_vec.begin(), node_vec.end());
+    return node_vec;
 }
 
 /**
@@ -755,6 +1197,91 @@ bool Parser::CheckNameRepetition(std::vector<T> struct_vec, DeviceName name) {
     return false;
 }
 
+/**
+ * @brief Lines outside of the requested .lib section are ignored
+ */
+bool Parser::SkippingLines() {
+    return skip_lib_section || (!lib_section.isEmpty() && !in_lib_section);
+}
+
+Circuit& Parser::CurrentCircuit() {
+    if (fragment_target != nullptr)
+        return *fragment_target;
+    if (current_subckt >= 0)
+        return circuit.subckt_vec[current_subckt].body;
+    return circuit;
+}
+
+/**
+ * @brief Depth first search of the instances below a subckt definition
+ *
+ * @param circuit the top level circuit holding the definitions
+ * @param subckt
+ * @param state_map 1 while the definition is on the search path, 2 once done
+ * @param recursive output, a definition that instantiates itself
+ * @return true : A cycle was found below `subckt`
+ * @return false : No cycle
+ */
+static bool FindSubcktCycle(const Circuit& circuit, const SubcktDef* subckt,
+                            std::map<const SubcktDef*, int>& state_map,
+                            const SubcktDef*& recursive) {
+    if (state_map[subckt] == 1) {
+        recursive = subckt;
+        return true;
+    }
+    if (state_map[subckt] == 2)
+        return false;
+
+    state_map[subckt] = 1;
+    for (auto& instance : subckt->body.instance_vec) {
+        const SubcktDef* child = FindSubckt(circuit, instance.subckt);
+        if (child != nullptr && FindSubcktCycle(circuit, child, state_map, recursive))
+            return true;
+    }
+    state_map[subckt] = 2;
+    return false;
+}
+
+/**
+ * @brief Every instance must refer to a defined subckt with the same number of
+ * ports, and no subckt may instantiate itself.
+ *
+ * @return true : Check pass \
+ * @return false : Not OK
+ */
+bool Parser::CheckSubckt() {
+    std::vector<const Circuit*> circuit_vec = {&circuit};
+    for (auto& subckt : circuit.subckt_vec)
+        circuit_vec.push_back(&subckt.body);
+
+    for (auto c : circuit_vec) {
+        for (auto instance : c->instance_vec) {
+            const SubcktDef* subckt = FindSubckt(circuit, instance.subckt);
+            if (subckt == nullptr) {
+                cout << "Error: " << instance.name << " refers to unknown subckt "
+                     << instance.subckt << endl;
+                return false;
+            }
+            if (subckt->port_vec.size() != instance.node_vec.size()) {
+                cout << "Error: " << instance.name << " connects "
+                     << instance.node_vec.size() << " nodes, but " << subckt->name
+                     << " has " << subckt->port_vec.size() << " ports" << endl;
+                return false;
+            }
+        }
+    }
+
+    std::map<const SubcktDef*, int> state_map;
+    const SubcktDef* recursive = nullptr;
+    for (auto& subckt : circuit.subckt_vec) {
+        if (FindSubcktCycle(circuit, &subckt, state_map, recursive)) {
+            cout << "Error: subckt " << recursive->name << " instantiates itself" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 bool Parser::CheckGndNode() {
     for (auto node : circuit.node_vec) {
         if (node == "0")
@@ -772,7 +1299,7 @@ bool Parser::CheckGndNode() {
  */
 bool Parser::ParserFinalCheck() {
     if (command_end)
-        return CheckGndNode();
+        return CheckGndNode() && CheckSubckt();
     else
         return false;
 }
\ No newline at end of file
@@ -18,11 +18,17 @@
 
 #include "parser_type.h"
 
+const int MAGIC = 407000002;  // ParseValue returns MAGIC if the value is invalid
+
 class Parser {
   public:
     Parser();
     Parser(QTextEdit* output);
     ~Parser();
+    bool ParseFile(const QString file_name, const bool has_title = true);
+    void ParseLines(std::vector<SourceLine>& line_vec, const QString& deck_text,
+                    const QString file_name);
+    void ParseLine(const QString line, const int lineNum);
     void DeviceParser(const QString line, const int lineNum);
     void CommandParser(const QString line, const int lineNum);
 
@@ -35,14 +41,45 @@ class Parser {
     auto GetDcAnalysis() { return dc_analysis; }
     auto GetAcAnalysis() { return ac_analysis; }
     auto GetTranAnalysis() { return tran_analysis; }
+    auto GetMcAnalysis() { return mc_analysis; }
+    auto GetStepAnalysis() { return step_analysis; }
     auto GetPrintVariables() { return print_variable_vec; }
+    auto GetOptions() { return options; }
+    // Overrides a .options entry of the deck, e.g. the rawfile of a batch job
+    void SetOption(const QString key, const QString value) { options[key] = value; }
+    auto GetTitle() { return title; }
 
     bool ParserFinalCheck();
 
+    // Compiled netlist cache, see parser_cache.cpp
+    bool SaveCompiled(const QString cache_name, const quint64 source_hash);
+    bool LoadCompiled(const QString cache_name, const quint64 source_hash);
+
   private:
     QTextEdit* output;
+    void Output(const QString text);
 
     Circuit circuit;
+    int current_subckt;  // index in circuit.subckt_vec while inside .subckt
+    Circuit* fragment_target = nullptr;  // Device lines on their own, see ParseLines()
+    Circuit& CurrentCircuit();
+
+    // .include / .lib, see parser_include.cpp
+    QString deck_dir;
+    int include_depth;
+    QString lib_section;    // Only read this section when parsing a .lib file
+    bool in_lib_section;    // Between `.lib name` and `.endl`
+    bool skip_lib_section;  // The current section is not the one requested
+    std::vector<IncludeFile> include_file_vec;
+
+    void IncludeParser(const QString line, const int lineNum);
+    void MergeCircuit(const Circuit& fragment, const std::size_t inherited_definition_num,
+                      const int lineNum);
+    bool SkippingLines();
+
+    // Reusing parsed editor lines, see parser_document.cpp
+    bool IsReusableLine(const QString line);
+    void AppendLineFragment(const Circuit& fragment, const int lineNum);
 
     NodeName ReadNodeName(const QString qstrName);
 
@@ -54,11 +91,25 @@ class Parser {
     DcAnalysis dc_analysis;
     AcAnalysis ac_analysis;
     TranAnalysis tran_analysis;
+    McAnalysis mc_analysis;
+    StepAnalysis step_analysis;
+    void StepParser(const QStringList elements, const int lineNum);
 
     std::vector<PrintVariable> print_variable_vec;
     PrintType print_type;
 
+    QString title;
+    SimulationOptions options;
+    void OptionParser(const QString line, const int lineNum);
+
+    QStringList SplitLine(const QString line);
     double ParseValue(const QString value_in_str);
+
+    // .param and {expr} values, see parser_param.cpp
+    void ParamParser(const QString line, const int lineNum);
+    bool CompileValue(const QString value_in_str, Expression& expr);
+    double ParseDeviceValue(Circuit& target, const DeviceKind kind, const int index,
+                            const QString value_in_str);
     void ParseError(const QString error_msg, const QString name, const int lineNum);
 
     void PrintCommandParser(const QStringList elements);
@@ -69,6 +120,35 @@ class Parser {
     bool CheckNameRepetition(std::vector<T> struct_vec, DeviceName name);
 
     bool CheckGndNode();
+    bool CheckSubckt();
 };
 
+std::vector<NodeName> CollectNodeVec(const Circuit& circuit);
+
+QString GetOption(const SimulationOptions& options, const QString key,
+                  const QString default_value = QString());
+double GetOptionValue(const SimulationOptions& options, const QString key,
+                      const double default_value);
+
+// Parameters, see parser_param.cpp
+bool IsExpression(const QString value_in_str);
+double& DeviceValue(Circuit& circuit, const DeviceKind kind, const int index);
+void AppendBindings(const Circuit& source, Circuit& target);
+void EvaluateParams(Circuit& circuit,
+                    const std::vector<std::pair<int, double>>& override_vec = {});
+
+// Parsed includes kept on disk for other processes, see parser_include.cpp
+void SetIncludeCacheDir(const QString dir);
+bool SaveIncludeFragment(const QString cache_name, const quint64 key_hash,
+                         const Circuit& circuit,
+                         const std::vector<IncludeFile>& include_file_vec,
+                         const std::size_t inherited_definition_num);
+bool LoadIncludeFragment(const QString cache_name, const quint64 key_hash,
+                         Circuit& circuit, std::vector<IncludeFile>& include_file_vec,
+                         std::size_t& inherited_definition_num);
+
+// Subckt elaboration, see subckt.cpp
+const SubcktDef* FindSubckt(const Circuit& circuit, const ModelName name);
+bool FlattenCircuit(const Circuit& circuit, Circuit& flat);
+
 #endif  // PARSER_H
@@ -0,0 +1,819 @@
+/**
+ * @file parser_cache.cpp
+ * @author Yaotian Liu
+ * @brief Compiled netlist cache: dump the parsed circuit into a versioned binary
+ * file and map it back on the next run, skipping the text parser.
+ * @date 2026-10-19
+ */
+
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <cstring>
+#include <type_traits>
+
+#include "../utils/utils.h"
+#include "parser.h"
+
+using std::cout;
+using std::endl;
+
+// Bump whenever the layout of Circuit or any analysis command changes.
+const quint32 COMPILED_VERSION = 9;
+const char COMPILED_MAGIC[8] = {'S', 'E', 'D', 'A', 'N', 'E', 'T', '\0'};
+const quint32 COMPILED_ENDIAN_TAG = 0x01020304;
+
+struct CompiledHeader {
+    char magic[8];
+    quint32 version;
+    quint32 endian_tag;
+    quint64 source_hash;
+    quint32 string_num;
+    quint32 string_size;
+    quint32 body_size;
+};
+
+// Bytes of the header on disk, written field by field without padding
+const qint64 COMPILED_HEADER_SIZE = 8 + 4 + 4 + 8 + 4 + 4 + 4;
+
+/**
+ * @brief Appends scalar values to a byte buffer, one field at a time so no
+ * struct padding reaches the file. Names are interned into a string table,
+ * devices only store the index.
+ */
+class CompiledWriter {
+  public:
+    template <typename T>
+    void Put(const T value) {
+        static_assert(std::is_arithmetic<T>::value, "write structs field by field");
+        body.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void PutName(const QString name) {
+        auto it = string_index.find(name);
+        if (it == string_index.end()) {
+            it = string_index.insert(name, string_vec.size());
+            string_vec.push_back(name);
+        }
+        Put<quint32>(it.value());
+    }
+
+    void PutExpression(const Expression& expr) {
+        Put<quint32>(expr.code.size());
+        for (auto op : expr.code) {
+            Put<quint8>(op.code);
+            Put<qint32>(op.arg);
+        }
+        Put<quint32>(expr.constants.size());
+        for (auto constant : expr.constants)
+            Put<double>(constant);
+    }
+
+    void PutDevice(const BaseDevice device) {
+        PutName(device.name);
+        Put<double>(device.value);
+        PutName(device.node_1);
+        PutName(device.node_2);
+    }
+
+    QByteArray body;
+    QHash<QString, quint32> string_index;
+    std::vector<QString> string_vec;
+};
+
+/**
+ * @brief Reads values back from the mapped file. Any read past the end marks
+ * the reader as failed instead of touching memory outside the mapping.
+ */
+class CompiledReader {
+  public:
+    CompiledReader(const uchar* begin, const uchar* end) : cursor(begin), end(end) {}
+
+    template <typename T>
+    T Get() {
+        static_assert(std::is_arithmetic<T>::value, "read structs field by field");
+        T value{};
+        if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(T))) {
+            failed = true;
+            return value;
+        }
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    /**
+     * @brief Read a record count. A count that cannot fit in the bytes left,
+     * `min_record_size` at least per record, marks the reader as failed and
+     * reads as 0, so a corrupted count never drives a huge allocation.
+     *
+     * @param min_record_size
+     * @return quint32
+     */
+    quint32 GetCount(const std::size_t min_record_size) {
+        quint32 num = Get<quint32>();
+        if (failed || num > static_cast<std::size_t>(end - cursor) / min_record_size) {
+            failed = true;
+            return 0;
+        }
+        return num;
+    }
+
+    bool ReadStringTable(const quint32 string_num) {
+        if (string_num > static_cast<std::size_t>(end - cursor) / sizeof(quint32)) {
+            failed = true;
+            return false;
+        }
+        string_vec.reserve(string_num);
+        for (quint32 i = 0; i < string_num && !failed; i++) {
+            quint32 length = Get<quint32>();
+            if (end - cursor < static_cast<std::ptrdiff_t>(length)) {
+                failed = true;
+                break;
+            }
+            string_vec.push_back(
+                QString::fromUtf8(reinterpret_cast<const char*>(cursor), length));
+            cursor += length;
+        }
+        return !failed;
+    }
+
+    /**
+     * @brief Skip the header checked by MapCompiledFile() and read the string
+     * table, which must end exactly where the body begins
+     */
+    bool ReadHeader() {
+        const uchar* body_end = end;
+        cursor += sizeof(COMPILED_MAGIC) + 2 * sizeof(quint32) + sizeof(quint64);
+        quint32 string_num = Get<quint32>();
+        quint32 string_size = Get<quint32>();
+        cursor += sizeof(quint32);
+        end = cursor + string_size;
+        ReadStringTable(string_num);
+        failed = failed || cursor != end;
+        end = body_end;
+        return !failed;
+    }
+
+    QString GetName() {
+        quint32 index = Get<quint32>();
+        if (index >= string_vec.size()) {
+            failed = true;
+            return QString();
+        }
+        return string_vec[index];
+    }
+
+    Expression GetExpression() {
+        Expression expr;
+        quint32 num = GetCount(sizeof(quint8) + sizeof(qint32));
+        for (quint32 i = 0; i < num && !failed; i++) {
+            ExprOp op;
+            op.code = static_cast<ExprOpCode>(Get<quint8>());
+            op.arg = Get<qint32>();
+            expr.code.push_back(op);
+        }
+        num = GetCount(sizeof(double));
+        for (quint32 i = 0; i < num && !failed; i++)
+            expr.constants.push_back(Get<double>());
+        return expr;
+    }
+
+    template <typename T>
+    void GetDevice(T& device) {
+        device.name = GetName();
+        device.value = Get<double>();
+        device.node_1 = GetName();
+        device.node_2 = GetName();
+    }
+
+    const uchar* cursor;
+    const uchar* end;
+    bool failed = false;
+    std::vector<QString> string_vec;
+};
+
+/**
+ * @brief Write the header, the string table and the body of `writer` to
+ * `cache_name`. The file is replaced in one step, so processes reading it
+ * while it is written see either the old or the new one.
+ *
+ * @return true : Saved
+ * @return false : Failed to write
+ */
+static bool WriteCompiledFile(const QString cache_name, const CompiledWriter& writer,
+                              const quint64 source_hash) {
+    QByteArray strings;
+    for (auto s : writer.string_vec) {
+        QByteArray utf8 = s.toUtf8();
+        quint32 length = utf8.size();
+        strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        strings.append(utf8);
+    }
+
+    CompiledWriter header;
+    header.body.append(COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+    header.Put<quint32>(COMPILED_VERSION);
+    header.Put<quint32>(COMPILED_ENDIAN_TAG);
+    header.Put<quint64>(source_hash);
+    header.Put<quint32>(writer.string_vec.size());
+    header.Put<quint32>(strings.size());
+    header.Put<quint32>(writer.body.size());
+
+    QSaveFile file(cache_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(header.body);
+    file.write(strings);
+    file.write(writer.body);
+    return file.commit();
+}
+
+/**
+ * @brief Map a file written by WriteCompiledFile() if its header matches this
+ * build and `source_hash`, and its sizes add up
+ *
+ * @param file
+ * @param source_hash
+ * @return uchar* : The mapping, to be unmapped by the caller
+ * @return nullptr : Missing, stale or truncated
+ */
+static uchar* MapCompiledFile(QFile& file, const quint64 source_hash) {
+    if (!file.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    qint64 size = file.size();
+    if (size < COMPILED_HEADER_SIZE)
+        return nullptr;
+
+    uchar* data = file.map(0, size);
+    if (data == nullptr)
+        return nullptr;
+
+    CompiledReader reader(data, data + size);
+    CompiledHeader header;
+    std::memcpy(header.magic, data, sizeof(header.magic));
+    reader.cursor += sizeof(header.magic);
+    header.version = reader.Get<quint32>();
+    header.endian_tag = reader.Get<quint32>();
+    header.source_hash = reader.Get<quint64>();
+    header.string_num = reader.Get<quint32>();
+    header.string_size = reader.Get<quint32>();
+    header.body_size = reader.Get<quint32>();
+    if (std::memcmp(header.magic, COMPILED_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != COMPILED_VERSION || header.endian_tag != COMPILED_ENDIAN_TAG ||
+        header.source_hash != source_hash) {
+        file.unmap(data);
+        return nullptr;
+    }
+    if (COMPILED_HEADER_SIZE + header.string_size + header.body_size != size) {
+        file.unmap(data);
+        cout << "Compiled file " << file.fileName() << " is truncated, ignored" << endl;
+        return nullptr;
+    }
+    return data;
+}
+
+/**
+ * @brief Write the devices of a circuit, recursing into the subckt definitions
+ */
+void WriteCircuit(CompiledWriter& writer, const Circuit& circuit) {
+    writer.Put<quint32>(circuit.vsrc_vec.size());
+    for (auto vsrc : circuit.vsrc_vec) {
+        writer.PutDevice(vsrc);
+        writer.Put<qint32>(vsrc.analysis_type);
+        const Pulse& pulse = vsrc.pulse;
+        writer.Put<quint8>(pulse.chosen);
+        for (double value : {pulse.v1, pulse.v2, pulse.td, pulse.tr, pulse.tf, pulse.pw,
+                             pulse.per})
+            writer.Put<double>(value);
+        const Sin& sin = vsrc.sin;
+        writer.Put<quint8>(sin.chosen);
+        for (double value : {sin.v0, sin.va, sin.freq, sin.td, sin.theta})
+            writer.Put<double>(value);
+    }
+
+    writer.Put<quint32>(circuit.isrc_vec.size());
+    for (auto isrc : circuit.isrc_vec) {
+        writer.PutDevice(isrc);
+        writer.Put<double>(isrc.ac_value);
+        writer.Put<double>(isrc.tran_const_value);
+    }
+
+    writer.Put<quint32>(circuit.vccs_vec.size());
+    for (auto vccs : circuit.vccs_vec) {
+        writer.PutDevice(vccs);
+        writer.PutName(vccs.ctrl_node_1);
+        writer.PutName(vccs.ctrl_node_2);
+    }
+
+    writer.Put<quint32>(circuit.vcvs_vec.size());
+    for (auto vcvs : circuit.vcvs_vec) {
+        writer.PutDevice(vcvs);
+        writer.PutName(vcvs.ctrl_node_1);
+        writer.PutName(vcvs.ctrl_node_2);
+    }
+
+    writer.Put<quint32>(circuit.res_vec.size());
+    for (auto res : circuit.res_vec)
+        writer.PutDevice(res);
+
+    writer.Put<quint32>(circuit.cap_vec.size());
+    for (auto cap : circuit.cap_vec)
+        writer.PutDevice(cap);
+
+    writer.Put<quint32>(circuit.ind_vec.size());
+    for (auto ind : circuit.ind_vec)
+        writer.PutDevice(ind);
+
+    writer.Put<quint32>(circuit.diode_vec.size());
+    for (auto diode : circuit.diode_vec) {
+        writer.PutName(diode.name);
+        writer.PutName(diode.node_1);
+        writer.PutName(diode.node_2);
+        writer.PutName(diode.model);
+    }
+
+    writer.Put<quint32>(circuit.node_vec.size());
+    for (auto node : circuit.node_vec)
+        writer.PutName(node);
+
+    writer.Put<quint32>(circuit.instance_vec.size());
+    for (auto instance : circuit.instance_vec) {
+        writer.PutName(instance.name);
+        writer.PutName(instance.subckt);
+        writer.Put<quint32>(instance.node_vec.size());
+        for (auto node : instance.node_vec)
+            writer.PutName(node);
+    }
+
+    writer.Put<quint32>(circuit.subckt_vec.size());
+    for (auto& subckt : circuit.subckt_vec) {
+        writer.PutName(subckt.name);
+        writer.Put<quint32>(subckt.port_vec.size());
+        for (auto port : subckt.port_vec)
+            writer.PutName(port);
+        WriteCircuit(writer, subckt.body);
+    }
+
+    writer.Put<quint32>(circuit.param_binding_vec.size());
+    for (auto& binding : circuit.param_binding_vec) {
+        writer.Put<qint32>(binding.kind);
+        writer.Put<qint32>(binding.index);
+        writer.PutExpression(binding.expr);
+    }
+
+    const ParamTable& param_table = circuit.param_table;
+    writer.Put<quint32>(param_table.definition_vec.size());
+    for (auto& definition : param_table.definition_vec) {
+        writer.PutName(qstr(param_table.name_vec[definition.first]));
+        writer.PutExpression(definition.second);
+    }
+}
+
+/**
+ * @brief Read back what WriteCircuit wrote
+ */
+void ReadCircuit(CompiledReader& reader, Circuit& circuit) {
+    quint32 num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        Vsrc vsrc;
+        reader.GetDevice(vsrc);
+        vsrc.analysis_type = static_cast<AnalysisType>(reader.Get<qint32>());
+        Pulse& pulse = vsrc.pulse;
+        pulse.chosen = reader.Get<quint8>();
+        for (double* value : {&pulse.v1, &pulse.v2, &pulse.td, &pulse.tr, &pulse.tf,
+                              &pulse.pw, &pulse.per})
+            *value = reader.Get<double>();
+        Sin& sin = vsrc.sin;
+        sin.chosen = reader.Get<quint8>();
+        for (double* value : {&sin.v0, &sin.va, &sin.freq, &sin.td, &sin.theta})
+            *value = reader.Get<double>();
+        circuit.vsrc_vec.push_back(vsrc);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        Isrc isrc;
+        reader.GetDevice(isrc);
+        isrc.ac_value = reader.Get<double>();
+        isrc.tran_const_value = reader.Get<double>();
+        circuit.isrc_vec.push_back(isrc);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        VCCS vccs;
+        reader.GetDevice(vccs);
+        vccs.ctrl_node_1 = reader.GetName();
+        vccs.ctrl_node_2 = reader.GetName();
+        circuit.vccs_vec.push_back(vccs);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        VCVS vcvs;
+        reader.GetDevice(vcvs);
+        vcvs.ctrl_node_1 = reader.GetName();
+        vcvs.ctrl_node_2 = reader.GetName();
+        circuit.vcvs_vec.push_back(vcvs);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        Res res;
+        reader.GetDevice(res);
+        circuit.res_vec.push_back(res);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        Cap cap;
+        reader.GetDevice(cap);
+        circuit.cap_vec.push_back(cap);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        Ind ind;
+        reader.GetDevice(ind);
+        circuit.ind_vec.push_back(ind);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        Diode diode;
+        diode.name = reader.GetName();
+        diode.node_1 = reader.GetName();
+        diode.node_2 = reader.GetName();
+        diode.model = reader.GetName();
+        circuit.diode_vec.push_back(diode);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++)
+        circuit.node_vec.push_back(reader.GetName());
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        SubcktInstance instance;
+        instance.name = reader.GetName();
+        instance.subckt = reader.GetName();
+        quint32 node_num = reader.GetCount(sizeof(quint32));
+        for (quint32 j = 0; j < node_num && !reader.failed; j++)
+            instance.node_vec.push_back(reader.GetName());
+        circuit.instance_vec.push_back(instance);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        SubcktDef subckt;
+        subckt.name = reader.GetName();
+        quint32 port_num = reader.GetCount(sizeof(quint32));
+        for (quint32 j = 0; j < port_num && !reader.failed; j++)
+            subckt.port_vec.push_back(reader.GetName());
+        ReadCircuit(reader, subckt.body);
+        circuit.subckt_vec.push_back(subckt);
+    }
+
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        ParamBinding binding;
+        binding.kind = static_cast<DeviceKind>(reader.Get<qint32>());
+        binding.index = reader.Get<qint32>();
+        binding.expr = reader.GetExpression();
+        circuit.param_binding_vec.push_back(binding);
+    }
+
+    // Values are not stored, replaying the definitions in order evaluates them.
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        std::string name = str(reader.GetName());
+        Expression expr = reader.GetExpression();
+        // A definition sees the slots before it and its own
+        int slot_num = circuit.param_table.name_vec.size() +
+                       (circuit.param_table.Slot(name) < 0 ? 1 : 0);
+        reader.failed = reader.failed || !expr.Valid(slot_num);
+        if (!reader.failed)
+            circuit.param_table.Define(name, expr);
+    }
+}
+
+/**
+ * @brief Check the bindings read back: every device index inside its array
+ * and every expression safe to evaluate against the top level parameters,
+ * which EvaluateBindings() uses for the subckt bodies too
+ *
+ * @param circuit
+ * @param param_num parameter slots of the top level circuit
+ * @return true : Valid
+ * @return false : Corrupted
+ */
+static bool ValidBindings(const Circuit& circuit, const int param_num) {
+    for (auto& binding : circuit.param_binding_vec) {
+        std::size_t device_num = 0;
+        switch (binding.kind) {
+            case VSRC_KIND: device_num = circuit.vsrc_vec.size(); break;
+            case ISRC_KIND: device_num = circuit.isrc_vec.size(); break;
+            case VCCS_KIND: device_num = circuit.vccs_vec.size(); break;
+            case VCVS_KIND: device_num = circuit.vcvs_vec.size(); break;
+            case RES_KIND: device_num = circuit.res_vec.size(); break;
+            case CAP_KIND: device_num = circuit.cap_vec.size(); break;
+            case IND_KIND: device_num = circuit.ind_vec.size(); break;
+            default: return false;
+        }
+        if (binding.index < 0 || std::size_t(binding.index) >= device_num ||
+            !binding.expr.Valid(param_num))
+            return false;
+    }
+    for (auto& subckt : circuit.subckt_vec)
+        if (!ValidBindings(subckt.body, param_num))
+            return false;
+    return true;
+}
+
+/**
+ * @brief Serialize the parsed circuit and commands into `cache_name`.
+ *
+ * @param cache_name
+ * @param source_hash hash of the netlist the parser has just read
+ * @return true : Saved
+ * @return false : Failed to write
+ */
+bool Parser::SaveCompiled(const QString cache_name, const quint64 source_hash) {
+    UpdateNodeVec();
+
+    CompiledWriter writer;
+
+    WriteCircuit(writer, circuit);
+
+    // Commands
+    writer.Put<quint8>(command_op);
+    writer.Put<quint8>(command_end);
+    writer.Put<qint32>(analysis_type);
+    writer.Put<qint32>(print_type);
+
+    writer.PutName(dc_analysis.Vsrc_name);
+    writer.Put<double>(dc_analysis.start);
+    writer.Put<double>(dc_analysis.end);
+    writer.Put<double>(dc_analysis.step);
+
+    writer.PutName(ac_analysis.Vsrc_name);
+    writer.Put<qint32>(ac_analysis.variation_type);
+    writer.Put<qint32>(ac_analysis.point_num);
+    writer.Put<double>(ac_analysis.f_start);
+    writer.Put<double>(ac_analysis.f_end);
+
+    writer.Put<double>(tran_analysis.t_step);
+    writer.Put<double>(tran_analysis.t_stop);
+    writer.Put<double>(tran_analysis.t_start);
+
+    writer.Put<qint32>(mc_analysis.sample_num);
+    writer.Put<quint32>(mc_analysis.seed);
+    writer.Put<quint32>(mc_analysis.tolerance_vec.size());
+    for (auto tolerance : mc_analysis.tolerance_vec) {
+        writer.PutName(tolerance.device);
+        writer.Put<double>(tolerance.tolerance);
+        writer.Put<qint32>(tolerance.distribution);
+    }
+
+    writer.Put<quint8>(step_analysis.param);
+    writer.PutName(step_analysis.name);
+    writer.Put<quint32>(step_analysis.value_vec.size());
+    for (auto value : step_analysis.value_vec)
+        writer.Put<double>(value);
+
+    writer.Put<quint32>(print_variable_vec.size());
+    for (auto print_variable : print_variable_vec) {
+        writer.Put<qint32>(print_variable.print_i_v);
+        writer.Put<qint32>(print_variable.analysis_variable_type);
+        writer.PutName(print_variable.node);
+    }
+
+    writer.PutName(title);
+    writer.Put<quint32>(options.size());
+    for (auto option : options) {
+        writer.PutName(option.first);
+        writer.PutName(option.second);
+    }
+
+    // The deck hash does not cover included files, keep theirs as well.
+    writer.Put<quint32>(include_file_vec.size());
+    for (auto include_file : include_file_vec) {
+        writer.PutName(include_file.file_name);
+        writer.Put<quint64>(include_file.hash);
+    }
+
+    if (!WriteCompiledFile(cache_name, writer, source_hash)) {
+        cout << "Failed to write compiled netlist " << cache_name << endl;
+        return false;
+    }
+
+    cout << "Saved compiled netlist " << cache_name << " (" << writer.string_vec.size()
+         << " names)" << endl;
+    return true;
+}
+
+/**
+ * @brief Map `cache_name` and restore the parser state from it.
+ * The parser is left untouched unless the whole file is valid and was compiled
+ * from a netlist with the same hash.
+ *
+ * @param cache_name
+ * @param source_hash hash of the current netlist
+ * @return true : Loaded, no need to parse the netlist
+ * @return false : Missing, stale or corrupted cache
+ */
+bool Parser::LoadCompiled(const QString cache_name, const quint64 source_hash) {
+    QFile file(cache_name);
+    uchar* data = MapCompiledFile(file, source_hash);
+    if (data == nullptr)
+        return false;
+
+    CompiledReader reader(data, data + file.size());
+    reader.ReadHeader();
+
+    Circuit c;
+    ReadCircuit(reader, c);
+
+    bool op = reader.Get<quint8>();
+    bool end = reader.Get<quint8>();
+    AnalysisType a_type = static_cast<AnalysisType>(reader.Get<qint32>());
+    PrintType p_type = static_cast<PrintType>(reader.Get<qint32>());
+
+    DcAnalysis dc;
+    dc.Vsrc_name = reader.GetName();
+    dc.start = reader.Get<double>();
+    dc.end = reader.Get<double>();
+    dc.step = reader.Get<double>();
+
+    AcAnalysis ac;
+    ac.Vsrc_name = reader.GetName();
+    ac.variation_type = static_cast<AcVariationType>(reader.Get<qint32>());
+    ac.point_num = reader.Get<qint32>();
+    ac.f_start = reader.Get<double>();
+    ac.f_end = reader.Get<double>();
+
+    TranAnalysis tran;
+    tran.t_step = reader.Get<double>();
+    tran.t_stop = reader.Get<double>();
+    tran.t_start = reader.Get<double>();
+
+    McAnalysis mc;
+    mc.sample_num = reader.Get<qint32>();
+    mc.seed = reader.Get<quint32>();
+    quint32 num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        McTolerance tolerance;
+        tolerance.device = reader.GetName();
+        tolerance.tolerance = reader.Get<double>();
+        tolerance.distribution = static_cast<McDistribution>(reader.Get<qint32>());
+        mc.tolerance_vec.push_back(tolerance);
+    }
+
+    StepAnalysis step;
+    step.param = reader.Get<quint8>();
+    step.name = reader.GetName();
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++)
+        step.value_vec.push_back(reader.Get<double>());
+
+    std::vector<PrintVariable> prints;
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        PrintVariable print_variable;
+        print_variable.print_i_v = static_cast<PrintIV>(reader.Get<qint32>());
+        print_variable.analysis_variable_type =
+            static_cast<AnalysisVariableT>(reader.Get<qint32>());
+        print_variable.node = reader.GetName();
+        prints.push_back(print_variable);
+    }
+
+    QString deck_title = reader.GetName();
+    SimulationOptions deck_options;
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        QString key = reader.GetName();
+        deck_options[key] = reader.GetName();
+    }
+
+    std::vector<IncludeFile> includes;
+    num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        IncludeFile include_file;
+        include_file.file_name = reader.GetName();
+        include_file.hash = reader.Get<quint64>();
+        includes.push_back(include_file);
+    }
+
+    bool failed = reader.failed || reader.cursor != reader.end ||
+                  !ValidBindings(c, c.param_table.name_vec.size());
+    file.unmap(data);
+
+    if (failed) {
+        cout << "Compiled netlist " << cache_name << " is corrupted, ignored" << endl;
+        return false;
+    }
+
+    for (auto include_file : includes) {
+        if (HashFile(include_file.file_name) != include_file.hash) {
+            cout << "Included file " << include_file.file_name
+                 << " changed, compiled netlist ignored" << endl;
+            return false;
+        }
+    }
+
+    circuit = c;
+    command_op = op;
+    command_end = end;
+    analysis_type = a_type;
+    print_type = p_type;
+    dc_analysis = dc;
+    ac_analysis = ac;
+    tran_analysis = tran;
+    mc_analysis = mc;
+    step_analysis = step;
+    print_variable_vec = prints;
+    include_file_vec = includes;
+    title = deck_title;
+    options = deck_options;
+
+    cout << "Loaded compiled netlist " << cache_name << endl;
+    return true;
+}
+
+/**
+ * @brief Store a parsed include (see parser_include.cpp) in `cache_name`, so
+ * other processes reuse it
+ *
+ * @param cache_name
+ * @param key_hash hash of the include cache key
+ * @param circuit what the file contributes
+ * @param include_file_vec its nested includes
+ * @param inherited_definition_num .param definitions it was parsed with
+ * @return true : Saved
+ * @return false : Failed to write
+ */
+bool SaveIncludeFragment(const QString cache_name, const quint64 key_hash,
+                         const Circuit& circuit,
+                         const std::vector<IncludeFile>& include_file_vec,
+                         const std::size_t inherited_definition_num) {
+    CompiledWriter writer;
+    WriteCircuit(writer, circuit);
+    writer.Put<quint64>(inherited_definition_num);
+    writer.Put<quint32>(include_file_vec.size());
+    for (auto include_file : include_file_vec) {
+        writer.PutName(include_file.file_name);
+        writer.Put<quint64>(include_file.hash);
+    }
+    return WriteCompiledFile(cache_name, writer, key_hash);
+}
+
+/**
+ * @brief Read back what SaveIncludeFragment() stored. The outputs are left
+ * untouched unless the file is valid and its nested includes unchanged.
+ *
+ * @return true : Loaded
+ * @return false : Missing, stale or corrupted
+ */
+bool LoadIncludeFragment(const QString cache_name, const quint64 key_hash,
+                         Circuit& circuit, std::vector<IncludeFile>& include_file_vec,
+                         std::size_t& inherited_definition_num) {
+    QFile file(cache_name);
+    uchar* data = MapCompiledFile(file, key_hash);
+    if (data == nullptr)
+        return false;
+
+    CompiledReader reader(data, data + file.size());
+    reader.ReadHeader();
+
+    Circuit c;
+    ReadCircuit(reader, c);
+    quint64 inherited_num = reader.Get<quint64>();
+    std::vector<IncludeFile> includes;
+    quint32 num = reader.GetCount(sizeof(quint32));
+    for (quint32 i = 0; i < num && !reader.failed; i++) {
+        IncludeFile include_file;
+        include_file.file_name = reader.GetName();
+        include_file.hash = reader.Get<quint64>();
+        includes.push_back(include_file);
+    }
+
+    bool failed = reader.failed || reader.cursor != reader.end ||
+                  inherited_num > c.param_table.definition_vec.size() ||
+                  !ValidBindings(c, c.param_table.name_vec.size());
+    file.unmap(data);
+    if (failed) {
+        cout << "Cached include " << cache_name << " is corrupted, ignored" << endl;
+        return false;
+    }
+
+    for (auto include_file : includes)
+        if (HashFile(include_file.file_name) != include_file.hash)
+            return false;
+
+    circuit = c;
+    include_file_vec = includes;
+    inherited_definition_num = inherited_num;
+    return true;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file parser_document.cpp
+ * @author Yaotian Liu
+ * @brief Parsing the deck held in the editor, reusing unchanged lines
+ * @date 2026-10-19
+ */
+
+#include <QDir>
+#include <QFileInfo>
+
+#include "../utils/utils.h"
+#include "parser.h"
+
+using std::cout;
+using std::endl;
+
+template <typename T>
+bool HasName(const std::vector<T>& device_vec, const DeviceName name) {
+    for (auto& device : device_vec)
+        if (device.name == name)
+            return true;
+    return false;
+}
+
+int DeviceCount(const Circuit& fragment) {
+    return fragment.vsrc_vec.size() + fragment.isrc_vec.size() + fragment.vccs_vec.size() +
+           fragment.vcvs_vec.size() + fragment.res_vec.size() + fragment.cap_vec.size() +
+           fragment.ind_vec.size() + fragment.diode_vec.size() +
+           fragment.instance_vec.size();
+}
+
+/**
+ * @brief Parse the lines of the editor. A line whose `fragment` is set is
+ * unchanged since the last run and is appended as parsed then; every device
+ * line parsed now gets its fragment filled in for the next run.
+ *
+ * @param line_vec the lines of the deck, the first one is the title
+ * @param deck_text the text the lines point into
+ * @param file_name where the deck is saved, for relative .include paths
+ */
+void Parser::ParseLines(std::vector<SourceLine>& line_vec, const QString& deck_text,
+                        const QString file_name) {
+    deck_dir = file_name.isEmpty() ? QDir::currentPath()
+                                   : QFileInfo(file_name).absolutePath();
+
+    int reused_num = 0;
+    for (std::size_t i = 0; i < line_vec.size(); i++) {
+        SourceLine& source = line_vec[i];
+        int lineNum = i + 1;
+
+        if (lineNum == 1) {
+            title = deck_text.mid(source.start, source.length);
+            cout << "Parsed Title: " << title << endl;
+            Output(QString("Parsed Title: ") + title);
+            continue;
+        }
+
+        if (source.fragment) {
+            if (!SkippingLines()) {
+                AppendLineFragment(*source.fragment, lineNum);
+                reused_num++;
+            }
+            continue;
+        }
+
+        QString text = deck_text.mid(source.start, source.length);
+        if (!IsReusableLine(text) || SkippingLines()) {
+            ParseLine(text, lineNum);
+            continue;
+        }
+
+        // Parse the device into a circuit of its own, so the result can be kept
+        // for the line; everything else the parser knows so far still applies.
+        Circuit parsed;
+        fragment_target = &parsed;
+        DeviceParser(text.toLower(), lineNum);
+        fragment_target = nullptr;
+        if (DeviceCount(parsed) != 1)
+            continue;  // Error printed; parse it again next time
+
+        auto fragment = std::make_shared<const Circuit>(std::move(parsed));
+        AppendLineFragment(*fragment, lineNum);
+        source.fragment = fragment;
+    }
+
+    cout << "Reused " << reused_num << " unchanged lines of " << line_vec.size() << endl;
+}
+
+/**
+ * @brief Whether a line parses to the same device wherever it is in the deck:
+ * a device line without expressions (those depend on the .param above it).
+ *
+ * @param line
+ */
+bool Parser::IsReusableLine(const QString line) {
+    QString trimmed = line.trimmed();
+    if (trimmed.isEmpty() || trimmed.contains('{') || trimmed.contains('\''))
+        return false;
+    return QString("vicrlgedx").contains(trimmed[0].toLower());
+}
+
+/**
+ * @brief Append the device parsed from one line to the circuit being parsed
+ * (top level or the open .subckt)
+ *
+ * @param fragment
+ * @param lineNum
+ */
+void Parser::AppendLineFragment(const Circuit& fragment, const int lineNum) {
+    Circuit& target = CurrentCircuit();
+
+    bool repeated = false;
+    DeviceName name;
+    for (auto& d : fragment.vsrc_vec)
+        repeated = HasName(target.vsrc_vec, name = d.name);
+    for (auto& d : fragment.isrc_vec)
+        repeated = HasName(target.isrc_vec, name = d.name);
+    for (auto& d : fragment.vccs_vec)
+        repeated = HasName(target.vccs_vec, name = d.name);
+    for (auto& d : fragment.vcvs_vec)
+        repeated = HasName(target.vcvs_vec, name = d.name);
+    for (auto& d : fragment.res_vec)
+        repeated = HasName(target.res_vec, name = d.name);
+    for (auto& d : fragment.cap_vec)
+        repeated = HasName(target.cap_vec, name = d.name);
+    for (auto& d : fragment.ind_vec)
+        repeated = HasName(target.ind_vec, name = d.name);
+    for (auto& d : fragment.diode_vec)
+        repeated = HasName(target.diode_vec, name = d.name);
+    for (auto& d : fragment.instance_vec)
+        repeated = HasName(target.instance_vec, name = d.name);
+
+    if (repeated) {
+        ParseError("which already exits.", name, lineNum);
+        return;
+    }
+
+    // A device line defines no parameters
+    MergeCircuit(fragment, 0, lineNum);
+}
@@ -0,0 +1,213 @@
+/**
+ * @file parser_include.cpp
+ * @author Yaotian Liu
+ * @brief .include / .lib handling with a cache of parsed files
+ * @date 2026-10-19
+ */
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <memory>
+
+#include "../utils/utils.h"
+#include "parser.h"
+
+using std::cout;
+using std::endl;
+
+const int MAX_INCLUDE_DEPTH = 16;
+
+// What an included file (or one section of a library) contributes to a deck.
+struct IncludeFragment {
+    Circuit circuit;
+    std::vector<IncludeFile> include_file_vec;  // Nested includes
+    std::size_t inherited_definition_num;       // .param definitions seen before
+};
+
+// Parsed files, keyed by content hash, section and directory (nested includes
+// are resolved relative to the file). Shared by the decks parsed in this
+// process, e.g. every run of the GUI.
+static QMutex include_cache_mutex;
+static QHash<QString, std::shared_ptr<const IncludeFragment>> include_cache;
+// Where parsed files are also stored, one file per key, for the decks parsed
+// by other processes: a batch run starts one process per deck.
+static QString include_cache_dir;
+
+/**
+ * @brief Keep the parsed includes in `dir` as well, empty for memory only
+ */
+void SetIncludeCacheDir(const QString dir) {
+    QMutexLocker locker(&include_cache_mutex);
+    include_cache_dir = dir;
+}
+
+/**
+ * @brief Parser for .include / .inc / .lib
+ * .include file
+ * .lib file section
+ *
+ * @param line the line with its original case
+ * @param lineNum
+ */
+void Parser::IncludeParser(const QString line, const int lineNum) {
+    QStringList elements = line.simplified().split(" ");
+    int num_elements = elements.length();
+    QString command = elements[0].toLower();
+
+    if ((command == ".lib" && num_elements != 3) ||
+        (command != ".lib" && num_elements != 2)) {
+        ParseError("", command, lineNum);
+        return;
+    }
+
+    QString path = elements[1];
+    if (path.size() >= 2 && (path.startsWith('"') || path.startsWith('\'')))
+        path = path.mid(1, path.size() - 2);
+    QString section = command == ".lib" ? elements[2].toLower() : QString();
+
+    QString file_name = QDir(deck_dir).absoluteFilePath(path);
+    if (!QFileInfo(file_name).isReadable()) {
+        ParseError("file not found", path, lineNum);
+        return;
+    }
+    if (include_depth >= MAX_INCLUDE_DEPTH) {
+        ParseError("too many nested includes", path, lineNum);
+        return;
+    }
+
+    // Included files see the parameters defined so far, so the parameter names
+    // (their slots) are part of the key as well.
+    QByteArray param_names;
+    for (auto& name : circuit.param_table.name_vec)
+        param_names.append(name.c_str()).append(',');
+    quint64 param_hash = HashBytes(reinterpret_cast<const uchar*>(param_names.constData()),
+                                   param_names.size());
+
+    quint64 hash = HashFile(file_name);
+    QString key = QString::number(hash, 16) + ":" + section + ":" +
+                  QFileInfo(file_name).absolutePath() + ":" +
+                  QString::number(param_hash, 16);
+
+    std::shared_ptr<const IncludeFragment> fragment;
+    QString cache_dir;
+    {
+        QMutexLocker locker(&include_cache_mutex);
+        fragment = include_cache.value(key);
+        cache_dir = include_cache_dir;
+    }
+
+    QByteArray key_utf8 = key.toUtf8();
+    quint64 key_hash =
+        HashBytes(reinterpret_cast<const uchar*>(key_utf8.constData()), key_utf8.size());
+    QString cache_name;
+    if (!cache_dir.isEmpty())
+        cache_name = QDir(cache_dir).filePath(QString::number(key_hash, 16) + ".sinc");
+
+    if (!fragment && !cache_name.isEmpty()) {
+        auto loaded = std::make_shared<IncludeFragment>();
+        if (LoadIncludeFragment(cache_name, key_hash, loaded->circuit,
+                                loaded->include_file_vec,
+                                loaded->inherited_definition_num)) {
+            fragment = loaded;
+            QMutexLocker locker(&include_cache_mutex);
+            include_cache.insert(key, fragment);
+        }
+    }
+
+    if (fragment) {
+        cout << "Reused parsed include " << file_name << endl;
+    } else {
+        Parser child(output);
+        child.include_depth = include_depth + 1;
+        child.lib_section = section;
+        child.circuit.param_table = circuit.param_table;
+        child.ParseFile(file_name, false);
+
+        auto parsed = std::make_shared<IncludeFragment>();
+        parsed->circuit = child.circuit;
+        parsed->include_file_vec = child.include_file_vec;
+        parsed->inherited_definition_num = circuit.param_table.definition_vec.size();
+        fragment = parsed;
+        if (!cache_name.isEmpty())
+            SaveIncludeFragment(cache_name, key_hash, parsed->circuit,
+                                parsed->include_file_vec,
+                                parsed->inherited_definition_num);
+
+        QMutexLocker locker(&include_cache_mutex);
+        include_cache.insert(key, fragment);
+    }
+
+    cout << "Parsed Include (File: " << file_name;
+    if (!section.isEmpty())
+        cout << "; Section: " << section;
+    cout << ")" << endl;
+    Output(QString("Parsed Include: ") + file_name);
+
+    include_file_vec.push_back(IncludeFile{file_name, hash});
+    for (auto include_file : fragment->include_file_vec)
+        include_file_vec.push_back(include_file);
+
+    MergeCircuit(fragment->circuit, fragment->inherited_definition_num, lineNum);
+}
+
+/**
+ * @brief Add the devices of an included file to the circuit being parsed.
+ * Devices and instances go where the .include line is (top level or the open
+ * .subckt), definitions always go to the top level.
+ *
+ * @param fragment
+ * @param inherited_definition_num .param definitions the file was parsed with
+ * @param lineNum
+ */
+void Parser::MergeCircuit(const Circuit& fragment,
+                          const std::size_t inherited_definition_num, const int lineNum) {
+    Circuit& target = CurrentCircuit();
+
+    // Replay the definitions the file made on top of ours, redefinitions of our
+    // parameters included, as if its .param lines stood here. New parameters
+    // keep their slots.
+    const ParamTable& fragment_params = fragment.param_table;
+    for (std::size_t k = inherited_definition_num;
+         k < fragment_params.definition_vec.size(); k++) {
+        auto& definition = fragment_params.definition_vec[k];
+        circuit.param_table.Define(fragment_params.name_vec[definition.first],
+                                   definition.second);
+    }
+
+    AppendBindings(fragment, target);
+
+    target.vsrc_vec.insert(target.vsrc_vec.end(), fragment.vsrc_vec.begin(),
+                           fragment.vsrc_vec.end());
+    target.isrc_vec.insert(target.isrc_vec.end(), fragment.isrc_vec.begin(),
+                           fragment.isrc_vec.end());
+    target.vccs_vec.insert(target.vccs_vec.end(), fragment.vccs_vec.begin(),
+                           fragment.vccs_vec.end());
+    target.vcvs_vec.insert(target.vcvs_vec.end(), fragment.vcvs_vec.begin(),
+                           fragment.vcvs_vec.end());
+    target.res_vec.insert(target.res_vec.end(), fragment.res_vec.begin(),
+                          fragment.res_vec.end());
+    target.cap_vec.insert(target.cap_vec.end(), fragment.cap_vec.begin(),
+                          fragment.cap_vec.end());
+    target.ind_vec.insert(target.ind_vec.end(), fragment.ind_vec.begin(),
+                          fragment.ind_vec.end());
+    target.diode_vec.insert(target.diode_vec.end(), fragment.diode_vec.begin(),
+                            fragment.diode_vec.end());
+    target.instance_vec.insert(target.instance_vec.end(), fragment.instance_vec.begin(),
+                               fragment.instance_vec.end());
+
+    // `target` may point into subckt_vec, do not use it after this point.
+    for (auto& subckt : fragment.subckt_vec) {
+        if (FindSubckt(circuit, subckt.name) != nullptr) {
+            ParseError("which already exits.", subckt.name, lineNum);
+            continue;
+        }
+        circuit.subckt_vec.push_back(subckt);
+    }
+
+    // The cached file may have been parsed with other parameter values.
+    if (!fragment.param_binding_vec.empty() || !fragment.subckt_vec.empty())
+        EvaluateParams(circuit);
+}
@@ -0,0 +1,176 @@
+/**
+ * @file parser_param.cpp
+ * @author Yaotian Liu
+ * @brief .param and {expr} device values
+ * @date 2026-10-19
+ */
+
+#include "../utils/utils.h"
+#include "parser.h"
+
+using std::cout;
+using std::endl;
+
+/**
+ * @brief Whether a value is written as an expression, `{...}` or `'...'`
+ *
+ * @param value_in_str
+ * @return true : Expression
+ * @return false : Plain number
+ */
+bool IsExpression(const QString value_in_str) {
+    return (value_in_str.startsWith("{") && value_in_str.endsWith("}")) ||
+           (value_in_str.size() >= 2 && value_in_str.startsWith("'") &&
+            value_in_str.endsWith("'"));
+}
+
+/**
+ * @brief Compile `{expr}` / `'expr'` (or a bare expression) against the
+ * parameters defined so far.
+ *
+ * @param value_in_str
+ * @param expr output
+ * @return true : Compiled
+ * @return false : Error printed
+ */
+bool Parser::CompileValue(const QString value_in_str, Expression& expr) {
+    QString text = value_in_str;
+    if (IsExpression(text))
+        text = text.mid(1, text.size() - 2);
+
+    std::string error;
+    if (!CompileExpression(str(text), circuit.param_table, expr, error)) {
+        cout << "Error: failed to compile expression " << value_in_str << ", " << error
+             << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the value of a device. An expression depending on parameters is
+ * kept as a binding, so sweeps only re-run the byte code.
+ *
+ * @param target circuit the device is added to
+ * @param kind
+ * @param index index the device will have in its array
+ * @param value_in_str
+ * @return double the value with the current parameters
+ */
+double Parser::ParseDeviceValue(Circuit& target, const DeviceKind kind, const int index,
+                                const QString value_in_str) {
+    if (!IsExpression(value_in_str))
+        return ParseValue(value_in_str);
+
+    Expression expr;
+    if (!CompileValue(value_in_str, expr))
+        return MAGIC;
+
+    if (!expr.IsConstant())
+        target.param_binding_vec.push_back(ParamBinding{kind, index, expr});
+
+    return expr.Evaluate(circuit.param_table.value_vec);
+}
+
+/**
+ * @brief Parser for .param
+ * .param a=1k b={a*2} c = 'sqrt(a)'
+ *
+ * @param line
+ * @param lineNum
+ */
+void Parser::ParamParser(const QString line, const int lineNum) {
+    QString assignments = line.mid(QString(".param").size()).trimmed();
+    assignments.replace(QRegularExpression("\\s*=\\s*"), "=");
+
+    // A new assignment starts at every `name=` outside of an expression
+    QStringList items =
+        assignments.split(QRegularExpression("\\s+(?=[a-z_][a-z0-9_]*=)"));
+
+    if (assignments.isEmpty()) {
+        ParseError("need parameters", ".param", lineNum);
+        return;
+    }
+
+    for (QString item : items) {
+        int equal = item.indexOf('=');
+        if (equal <= 0) {
+            ParseError("expect name=value", item, lineNum);
+            continue;
+        }
+
+        QString name = item.left(equal);
+        QString value_in_str = item.mid(equal + 1);
+
+        Expression expr;
+        if (!CompileValue(value_in_str, expr)) {
+            ParseError("bad expression", name, lineNum);
+            continue;
+        }
+
+        int slot = circuit.param_table.Define(str(name), expr);
+
+        cout << "Parsed Parameter (Name: " << name
+             << "; Value: " << circuit.param_table.value_vec[slot]
+             << (expr.IsConstant() ? "" : "; Expression") << ")" << endl;
+    }
+}
+
+/**
+ * @brief Reference to the value of a device
+ */
+double& DeviceValue(Circuit& circuit, const DeviceKind kind, const int index) {
+    switch (kind) {
+        case VSRC_KIND: return circuit.vsrc_vec[index].value;
+        case ISRC_KIND: return circuit.isrc_vec[index].value;
+        case VCCS_KIND: return circuit.vccs_vec[index].value;
+        case VCVS_KIND: return circuit.vcvs_vec[index].value;
+        case RES_KIND: return circuit.res_vec[index].value;
+        case CAP_KIND: return circuit.cap_vec[index].value;
+        default: return circuit.ind_vec[index].value;
+    }
+}
+
+/**
+ * @brief Copy the bindings of `source` into `target`, shifting the device
+ * indices. Must be called before the devices of `source` are appended.
+ *
+ * @param source
+ * @param target
+ */
+void AppendBindings(const Circuit& source, Circuit& target) {
+    for (ParamBinding binding : source.param_binding_vec) {
+        switch (binding.kind) {
+            case VSRC_KIND: binding.index += target.vsrc_vec.size(); break;
+            case ISRC_KIND: binding.index += target.isrc_vec.size(); break;
+            case VCCS_KIND: binding.index += target.vccs_vec.size(); break;
+            case VCVS_KIND: binding.index += target.vcvs_vec.size(); break;
+            case RES_KIND: binding.index += target.res_vec.size(); break;
+            case CAP_KIND: binding.index += target.cap_vec.size(); break;
+            case IND_KIND: binding.index += target.ind_vec.size(); break;
+        }
+        target.param_binding_vec.push_back(binding);
+    }
+}
+
+void EvaluateBindings(Circuit& circuit, const std::vector<double>& param_value_vec) {
+    for (auto& binding : circuit.param_binding_vec)
+        DeviceValue(circuit, binding.kind, binding.index) =
+            binding.expr.Evaluate(param_value_vec);
+
+    for (auto& subckt : circuit.subckt_vec)
+        EvaluateBindings(subckt.body, param_value_vec);
+}
+
+/**
+ * @brief Re-evaluate the parameters and every device value bound to them, e.g.
+ * once per sweep point or Monte Carlo sample.
+ *
+ * @param circuit the top level circuit
+ * @param override_vec (slot, value) of parameters forced to a value
+ */
+void EvaluateParams(Circuit& circuit,
+                    const std::vector<std::pair<int, double>>& override_vec) {
+    circuit.param_table.Evaluate(override_vec);
+    EvaluateBindings(circuit, circuit.param_table.value_vec);
+}
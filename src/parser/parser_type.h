@@ -10,14 +10,19 @@
 
 #include <QString>
 #include <iostream>
+#include <map>
+#include <memory>
+
+#include "expression.h"
 
 typedef QString DeviceName;
 typedef QString NodeName;
 typedef QString ModelName;
 
-enum AnalysisType { NONE, DC, AC, TRAN, NOISE, DISTO };
+enum AnalysisType { NONE, DC, AC, TRAN, NOISE, DISTO, MC };
 typedef AnalysisType PrintType;
-const std::string AnalysisType_lookup[] = {"NONE", "DC", "AC", "TRAN", "NOISE", "DISTO"};
+const std::string AnalysisType_lookup[] = {"NONE",  "DC",    "AC", "TRAN",
+                                           "NOISE", "DISTO", "MC"};
 
 struct Pulse {
     bool chosen = false;
@@ -152,6 +157,25 @@ struct DiodeModel {
 
 const std::vector<DiodeModel> diode_model_lut = {DiodeModel(QString("diode"), 1)};
 
+// Which device array a parameterized value lives in
+enum DeviceKind { VSRC_KIND, ISRC_KIND, VCCS_KIND, VCVS_KIND, RES_KIND, CAP_KIND, IND_KIND };
+
+// A device value written as {expr}; re-evaluated whenever parameters change.
+struct ParamBinding {
+    DeviceKind kind;
+    int index;  // in the device array of the circuit holding the binding
+    Expression expr;
+};
+
+// X1 n1 n2 ... subckt
+struct SubcktInstance {
+    DeviceName name;
+    ModelName subckt;
+    std::vector<NodeName> node_vec;  // in the order of the subckt ports
+};
+
+struct SubcktDef;
+
 struct Circuit {
     std::vector<Vsrc> vsrc_vec;
     std::vector<Isrc> isrc_vec;
@@ -162,8 +186,44 @@ struct Circuit {
     std::vector<Ind> ind_vec;
     std::vector<Diode> diode_vec;
     std::vector<NodeName> node_vec;
+
+    // Hierarchy: instances only refer to a definition by name, so every
+    // definition is stored once no matter how often it is instantiated.
+    // Definitions live in the top level circuit only.
+    std::vector<SubcktInstance> instance_vec;
+    std::vector<SubcktDef> subckt_vec;
+
+    // .param values are global: the table lives in the top level circuit, while
+    // every circuit keeps the bindings of its own devices.
+    std::vector<ParamBinding> param_binding_vec;
+    ParamTable param_table;
 };
 
+// .subckt name port_1 port_2 ... / .ends
+struct SubcktDef {
+    ModelName name;
+    std::vector<NodeName> port_vec;
+    Circuit body;
+};
+
+// A file pulled in by .include / .lib, with the hash of its content
+struct IncludeFile {
+    QString file_name;
+    quint64 hash;
+};
+
+// One line of a deck held in the editor, as a range of the text of the whole
+// deck. `fragment` is what the line parsed into last time; while the line is
+// unchanged it is reused and its text is not read.
+struct SourceLine {
+    int start;
+    int length;
+    std::shared_ptr<const Circuit> fragment;
+};
+
+// .options key=value ..., interpreted by the analyzer
+typedef std::map<QString, QString> SimulationOptions;
+
 // TODO: CC
 
 struct ScaledUnit {
@@ -198,6 +258,35 @@ struct TranAnalysis {
     double t_start;
 };
 
+enum McDistribution { GAUSS, UNIFORM };
+const std::vector<std::string> McDistribution_lookup = {"gauss", "unif"};
+
+// .tol device tolerance [gauss|unif]: relative; gauss draws with sigma = tol / 3,
+// unif draws within +-tol.
+struct McTolerance {
+    DeviceName device;
+    double tolerance;
+    McDistribution distribution;
+};
+
+// .mc sample_num [seed]; operating point of every sample
+struct McAnalysis {
+    int sample_num = 0;
+    quint32 seed = 1;
+    std::vector<McTolerance> tolerance_vec;
+};
+
+// .step [lin|dec|oct] [param] name start stop step|points, or
+// .step [param] name list value ...: the analysis runs once per value.
+struct StepAnalysis {
+    bool param = false;  // `name` is a .param, otherwise a device
+    QString name;
+    std::vector<double> value_vec;  // Empty without .step
+};
+
+// Longest sweep accepted by .step
+const std::size_t MAX_STEP_NUM = 100000;
+
 enum AnalysisVariableT { MAG, REAL, IMAGINE, PHASE, DB };
 const std::string AnalysisVariableT_lookup[] = {"MAG", "REAL", "IMAGINE", "PHASE", "DB"};
 
@@ -0,0 +1,170 @@
+/**
+ * @file subckt.cpp
+ * @author Yaotian Liu
+ * @brief Elaboration of the subckt hierarchy into a flat circuit
+ * @date 2026-10-19
+ */
+
+#include <QHash>
+
+#include "../utils/utils.h"
+#include "parser.h"
+
+using std::cout;
+using std::endl;
+
+// Guard against a subckt instantiating itself.
+const int MAX_SUBCKT_DEPTH = 64;
+
+typedef QHash<ModelName, const SubcktDef*> SubcktTable;
+
+/**
+ * @brief Find a subckt definition by name
+ *
+ * @param circuit the top level circuit holding the definitions
+ * @param name
+ * @return const SubcktDef* nullptr if not defined
+ */
+const SubcktDef* FindSubckt(const Circuit& circuit, const ModelName name) {
+    for (auto& subckt : circuit.subckt_vec)
+        if (subckt.name == name)
+            return &subckt;
+    return nullptr;
+}
+
+/**
+ * @brief Map a node of a definition to the flat name: ports are replaced by the
+ * nodes the instance connects to, ground stays global, and internal nodes get the
+ * instance path as prefix, e.g. `x1.x2.n3`.
+ */
+NodeName MapNode(const NodeName node, const QHash<NodeName, NodeName>& port_map,
+                 const QString prefix) {
+    if (node == "0" || prefix.isEmpty())
+        return node;
+    auto it = port_map.find(node);
+    if (it != port_map.end())
+        return it.value();
+    return prefix + "." + node;
+}
+
+template <typename T>
+void CopyDevices(const std::vector<T>& device_vec, std::vector<T>& flat_vec,
+                 const QHash<NodeName, NodeName>& port_map, const QString prefix) {
+    for (T device : device_vec) {
+        device.name = prefix + "." + device.name;
+        device.node_1 = MapNode(device.node_1, port_map, prefix);
+        device.node_2 = MapNode(device.node_2, port_map, prefix);
+        flat_vec.push_back(device);
+    }
+}
+
+template <typename T>
+void CopyDependentSources(const std::vector<T>& source_vec, std::vector<T>& flat_vec,
+                          const QHash<NodeName, NodeName>& port_map,
+                          const QString prefix) {
+    for (T source : source_vec) {
+        source.name = prefix + "." + source.name;
+        source.node_1 = MapNode(source.node_1, port_map, prefix);
+        source.node_2 = MapNode(source.node_2, port_map, prefix);
+        source.ctrl_node_1 = MapNode(source.ctrl_node_1, port_map, prefix);
+        source.ctrl_node_2 = MapNode(source.ctrl_node_2, port_map, prefix);
+        flat_vec.push_back(source);
+    }
+}
+
+bool ExpandInstances(const std::vector<SubcktInstance>& instance_vec,
+                     const SubcktTable& table, const QHash<NodeName, NodeName>& port_map,
+                     const QString prefix, const int depth, Circuit& flat);
+
+/**
+ * @brief Copy the body of one instance into the flat circuit
+ */
+bool ExpandInstance(const SubcktInstance& instance, const SubcktTable& table,
+                    const QHash<NodeName, NodeName>& parent_port_map,
+                    const QString parent_prefix, const int depth, Circuit& flat) {
+    const SubcktDef* subckt = table.value(instance.subckt, nullptr);
+    if (subckt == nullptr || subckt->port_vec.size() != instance.node_vec.size()) {
+        cout << "Error: failed to expand " << instance.name << endl;
+        return false;
+    }
+    if (depth > MAX_SUBCKT_DEPTH) {
+        cout << "Error: subckt " << subckt->name << " is recursive" << endl;
+        return false;
+    }
+
+    QString prefix = parent_prefix.isEmpty() ? instance.name
+                                             : parent_prefix + "." + instance.name;
+
+    QHash<NodeName, NodeName> port_map;
+    for (std::size_t i = 0; i < subckt->port_vec.size(); i++)
+        port_map.insert(subckt->port_vec[i],
+                        MapNode(instance.node_vec[i], parent_port_map, parent_prefix));
+
+    const Circuit& body = subckt->body;
+    AppendBindings(body, flat);
+    CopyDevices(body.vsrc_vec, flat.vsrc_vec, port_map, prefix);
+    CopyDevices(body.isrc_vec, flat.isrc_vec, port_map, prefix);
+    CopyDevices(body.res_vec, flat.res_vec, port_map, prefix);
+    CopyDevices(body.cap_vec, flat.cap_vec, port_map, prefix);
+    CopyDevices(body.ind_vec, flat.ind_vec, port_map, prefix);
+    CopyDevices(body.diode_vec, flat.diode_vec, port_map, prefix);
+    CopyDependentSources(body.vccs_vec, flat.vccs_vec, port_map, prefix);
+    CopyDependentSources(body.vcvs_vec, flat.vcvs_vec, port_map, prefix);
+
+    return ExpandInstances(body.instance_vec, table, port_map, prefix, depth + 1, flat);
+}
+
+bool ExpandInstances(const std::vector<SubcktInstance>& instance_vec,
+                     const SubcktTable& table, const QHash<NodeName, NodeName>& port_map,
+                     const QString prefix, const int depth, Circuit& flat) {
+    for (auto& instance : instance_vec)
+        if (!ExpandInstance(instance, table, port_map, prefix, depth, flat))
+            return false;
+    return true;
+}
+
+/**
+ * @brief Elaborate the hierarchy into a flat circuit for matrix assembly.
+ * The parsed circuit keeps one copy per definition. The analyzer flattens it
+ * at the start of every run and drops the flat copy once the matrices are
+ * assembled, except for AC, which assembles them at every frequency.
+ *
+ * @param circuit the parsed top level circuit
+ * @param flat output, no instances and node_vec updated
+ * @return true : Flattened
+ * @return false : An instance could not be expanded, `flat` is incomplete
+ */
+bool FlattenCircuit(const Circuit& circuit, Circuit& flat) {
+    if (circuit.instance_vec.empty()) {
+        flat = circuit;
+        return true;
+    }
+
+    SubcktTable table;
+    for (auto& subckt : circuit.subckt_vec)
+        table.insert(subckt.name, &subckt);
+
+    flat = Circuit();
+    flat.vsrc_vec = circuit.vsrc_vec;
+    flat.isrc_vec = circuit.isrc_vec;
+    flat.vccs_vec = circuit.vccs_vec;
+    flat.vcvs_vec = circuit.vcvs_vec;
+    flat.res_vec = circuit.res_vec;
+    flat.cap_vec = circuit.cap_vec;
+    flat.ind_vec = circuit.ind_vec;
+    flat.diode_vec = circuit.diode_vec;
+    flat.param_binding_vec = circuit.param_binding_vec;
+    flat.param_table = circuit.param_table;
+
+    if (!ExpandInstances(circuit.instance_vec, table, QHash<NodeName, NodeName>(),
+                         QString(), 0, flat))
+        return false;
+
+    flat.node_vec = CollectNodeVec(flat);
+
+    cout << "Flattened " << circuit.instance_vec.size() << " top level instances of "
+         << circuit.subckt_vec.size() << " subckts into " << flat.node_vec.size()
+         << " nodes" << endl;
+
+    return true;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file components.cpp
+ * @author Yaotian Liu
+ * @brief Independent blocks of a system: connected components of its graph
+ * @date 2026-10-19
+ */
+
+#include "components.h"
+
+#include <algorithm>
+
+/**
+ * @brief Connected components, by breadth first search. On the graph of a
+ * reduced MNA matrix (ground removed) these are the parts of the circuit that
+ * only share ground, whose blocks can be solved on their own.
+ *
+ * @param graph
+ * @return std::vector<std::vector<int>> nodes of each component, sorted;
+ * components ordered by their first node
+ */
+std::vector<std::vector<int>> ConnectedComponents(const Graph& graph) {
+    int n = graph.size();
+    std::vector<int> component_of(n, -1);
+    std::vector<std::vector<int>> component_vec;
+
+    for (int start = 0; start < n; start++) {
+        if (component_of[start] >= 0)
+            continue;
+
+        int id = component_vec.size();
+        std::vector<int> component{start};
+        component_of[start] = id;
+        for (std::size_t head = 0; head < component.size(); head++) {
+            for (int u : graph[component[head]]) {
+                if (component_of[u] < 0) {
+                    component_of[u] = id;
+                    component.push_back(u);
+                }
+            }
+        }
+        std::sort(component.begin(), component.end());
+        component_vec.push_back(std::move(component));
+    }
+    return component_vec;
+}
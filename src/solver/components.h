@@ -0,0 +1,17 @@
+/**
+ * @file components.h
+ * @author Yaotian Liu
+ * @brief Independent blocks of a system: connected components of its graph
+ * @date 2026-10-19
+ */
+
+#if !defined(COMPONENTS_H)
+#define COMPONENTS_H
+
+#include <vector>
+
+#include "sparse_matrix.h"
+
+std::vector<std::vector<int>> ConnectedComponents(const Graph& graph);
+
+#endif  // COMPONENTS_H
@@ -0,0 +1,340 @@
+/**
+ * @file iterative_solver.cpp
+ * @author Yaotian Liu
+ * @brief Preconditioned Krylov solvers: PCG, GMRES and BiCGSTAB
+ * @date 2026-10-19
+ */
+
+#include "iterative_solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using arma::mat;
+using arma::vec;
+using std::cout;
+using std::endl;
+using std::vector;
+
+void IterativeStats::Add(const IterativeStats& other) {
+    solve_num += other.solve_num;
+    iteration_num += other.iteration_num;
+    failed_num += other.failed_num;
+    worst_residual = std::max(worst_residual, other.worst_residual);
+}
+
+/**
+ * @brief A = A^T up to rounding, with a positive diagonal: what PCG and IC0
+ * need, though it does not prove A positive definite
+ */
+bool SymmetricPositiveDiagonal(const CscMatrix& a) {
+    CscMatrix t = Transpose(a);
+    if (t.col_ptr != a.col_ptr || t.row_index != a.row_index)
+        return false;
+
+    double largest = 0;
+    for (double value : a.value)
+        largest = std::max(largest, std::fabs(value));
+    for (int p = 0; p < a.NonZeros(); p++)
+        if (std::fabs(a.value[p] - t.value[p]) > 1e-12 * largest)
+            return false;
+
+    for (int j = 0; j < a.n_cols; j++) {
+        bool positive = false;
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+            if (a.row_index[p] == j)
+                positive = a.value[p] > 0;
+        if (!positive)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Keep `a` and build its preconditioner. A preconditioner that does
+ * not apply to `a` (AMG or IC0 on a matrix with zero diagonal entries, as
+ * branch currents give) falls back to ILU0, then to none.
+ *
+ * @param a square
+ * @param method
+ * @param preconditioner
+ * @return true : Ready
+ * @return false : `a` is not square
+ */
+bool IterativeSolver::Setup(const CscMatrix& a, const KrylovMethod method,
+                            const PreconditionerType preconditioner) {
+    Clear();
+    if (a.n_cols == 0 || a.n_rows != a.n_cols)
+        return false;
+
+    this->a = a;
+    bool symmetric = SymmetricPositiveDiagonal(a);
+    this->method = method;
+    if (method == AUTO_KRYLOV)
+        this->method = symmetric ? PCG_KRYLOV : GMRES_KRYLOV;
+    if (this->method == PCG_KRYLOV && !symmetric)
+        cout << "PCG needs a symmetric matrix, it may not converge" << endl;
+
+    this->preconditioner = preconditioner;
+    if (preconditioner == AUTO_PRECONDITIONER)
+        this->preconditioner = this->method == PCG_KRYLOV ? IC0_PRECONDITIONER
+                                                          : ILU0_PRECONDITIONER;
+
+    if (this->preconditioner == AMG_PRECONDITIONER && !amg.Setup(a)) {
+        cout << "AMG needs a positive diagonal, using ILU0" << endl;
+        this->preconditioner = ILU0_PRECONDITIONER;
+    }
+    if (this->preconditioner == IC0_PRECONDITIONER && !symmetric) {
+        cout << "IC0 needs a symmetric matrix, using ILU0" << endl;
+        this->preconditioner = ILU0_PRECONDITIONER;
+    }
+    if (this->preconditioner == IC0_PRECONDITIONER && !incomplete_lu.Factor(a, true)) {
+        cout << "IC0 broke down, using ILU0" << endl;
+        this->preconditioner = ILU0_PRECONDITIONER;
+    }
+    if (this->preconditioner == ILU0_PRECONDITIONER && !incomplete_lu.Factor(a, false)) {
+        cout << "ILU0 broke down, using no preconditioner" << endl;
+        this->preconditioner = NO_PRECONDITIONER;
+    }
+
+    if (this->preconditioner == JACOBI_PRECONDITIONER) {
+        inv_diag.assign(a.n_cols, 1);
+        for (int j = 0; j < a.n_cols; j++)
+            for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+                if (a.row_index[p] == j && a.value[p] != 0)
+                    inv_diag[j] = 1 / a.value[p];
+    }
+
+    n = a.n_cols;
+    return true;
+}
+
+void IterativeSolver::Clear() {
+    n = 0;
+    a = CscMatrix();
+    inv_diag.clear();
+    incomplete_lu = IncompleteLu();
+    amg = Amg();
+    stats = IterativeStats();
+}
+
+vec IterativeSolver::Precondition(const vec& r) const {
+    switch (preconditioner) {
+        case JACOBI_PRECONDITIONER: {
+            vec z = r;
+            for (int i = 0; i < n; i++)
+                z(i) *= inv_diag[i];
+            return z;
+        }
+        case ILU0_PRECONDITIONER:
+        case IC0_PRECONDITIONER: return incomplete_lu.Solve(r);
+        case AMG_PRECONDITIONER: return amg.Cycle(r);
+        default: return r;
+    }
+}
+
+/**
+ * @brief Solve A x = rhs
+ *
+ * @param rhs
+ * @param guess starting point, empty for zero
+ * @param tolerance on the residual, relative to rhs
+ * @param max_iterations
+ * @return vec the last iterate, also when it did not converge (counted in
+ * Stats())
+ */
+vec IterativeSolver::Solve(const vec& rhs, const vec& guess, const double tolerance,
+                           const int max_iterations) {
+    vec x = guess.n_elem == rhs.n_elem ? guess : vec(rhs.n_elem, arma::fill::zeros);
+    double residual = 0;
+    int iteration_num = 0;
+    switch (method) {
+        case PCG_KRYLOV:
+            iteration_num = Pcg(rhs, x, tolerance, max_iterations, residual);
+            break;
+        case BICGSTAB_KRYLOV:
+            iteration_num = BiCgStab(rhs, x, tolerance, max_iterations, residual);
+            break;
+        default: iteration_num = Gmres(rhs, x, tolerance, max_iterations, residual); break;
+    }
+
+    stats.solve_num++;
+    stats.iteration_num += iteration_num;
+    stats.worst_residual = std::max(stats.worst_residual, residual);
+    if (!(residual <= tolerance))
+        stats.failed_num++;
+    return x;
+}
+
+/**
+ * @brief Preconditioned conjugate gradients, for symmetric positive definite
+ * A and M
+ *
+ * @return int iterations
+ */
+int IterativeSolver::Pcg(const vec& b, vec& x, const double tolerance,
+                         const int max_iterations, double& residual) const {
+    double b_norm = arma::norm(b);
+    if (b_norm == 0) {
+        x.zeros();
+        residual = 0;
+        return 0;
+    }
+
+    vec r = b - Multiply(a, x);
+    residual = arma::norm(r) / b_norm;
+    if (residual <= tolerance)
+        return 0;
+
+    vec z = Precondition(r);
+    vec p = z;
+    double rz = arma::dot(r, z);
+    for (int k = 1; k <= max_iterations; k++) {
+        vec ap = Multiply(a, p);
+        double alpha = rz / arma::dot(p, ap);
+        x += alpha * p;
+        r -= alpha * ap;
+        residual = arma::norm(r) / b_norm;
+        if (residual <= tolerance || !std::isfinite(residual))
+            return k;
+
+        z = Precondition(r);
+        double rz_next = arma::dot(r, z);
+        p = z + (rz_next / rz) * p;
+        rz = rz_next;
+    }
+    return max_iterations;
+}
+
+/**
+ * @brief Restarted GMRES, preconditioned on the right so the residual it
+ * minimizes is the true one
+ *
+ * @return int iterations
+ */
+int IterativeSolver::Gmres(const vec& b, vec& x, const double tolerance,
+                           const int max_iterations, double& residual) const {
+    double b_norm = arma::norm(b);
+    if (b_norm == 0) {
+        x.zeros();
+        residual = 0;
+        return 0;
+    }
+
+    int k = 0;
+    while (true) {
+        vec r = b - Multiply(a, x);
+        double beta = arma::norm(r);
+        residual = beta / b_norm;
+        if (residual <= tolerance || k >= max_iterations || !std::isfinite(residual))
+            return k;
+
+        // Arnoldi with modified Gram-Schmidt; Givens rotations keep the
+        // Hessenberg matrix triangular and give the residual at every step
+        int m = GMRES_RESTART;
+        vector<vec> v_vec(1, r / beta);
+        vector<vec> z_vec;
+        mat h(m + 1, m, arma::fill::zeros);
+        vec cs(m, arma::fill::zeros);
+        vec sn(m, arma::fill::zeros);
+        vec g(m + 1, arma::fill::zeros);
+        g(0) = beta;
+
+        int j = 0;
+        while (j < m && k < max_iterations) {
+            z_vec.push_back(Precondition(v_vec[j]));
+            vec w = Multiply(a, z_vec[j]);
+            for (int i = 0; i <= j; i++) {
+                h(i, j) = arma::dot(w, v_vec[i]);
+                w -= h(i, j) * v_vec[i];
+            }
+            h(j + 1, j) = arma::norm(w);
+            v_vec.push_back(h(j + 1, j) > 0 ? vec(w / h(j + 1, j)) : w);
+
+            for (int i = 0; i < j; i++) {
+                double upper = cs(i) * h(i, j) + sn(i) * h(i + 1, j);
+                h(i + 1, j) = -sn(i) * h(i, j) + cs(i) * h(i + 1, j);
+                h(i, j) = upper;
+            }
+            double radius = std::hypot(h(j, j), h(j + 1, j));
+            cs(j) = radius > 0 ? h(j, j) / radius : 1;
+            sn(j) = radius > 0 ? h(j + 1, j) / radius : 0;
+            h(j, j) = radius;
+            h(j + 1, j) = 0;
+            g(j + 1) = -sn(j) * g(j);
+            g(j) = cs(j) * g(j);
+
+            j++;
+            k++;
+            if (std::fabs(g(j)) / b_norm <= tolerance)
+                break;
+        }
+
+        // x += Z y, with H y = g by back substitution
+        vec y(j, arma::fill::zeros);
+        for (int i = j - 1; i >= 0; i--) {
+            double sum = g(i);
+            for (int l = i + 1; l < j; l++)
+                sum -= h(i, l) * y(l);
+            y(i) = h(i, i) != 0 ? sum / h(i, i) : 0;
+        }
+        for (int i = 0; i < j; i++)
+            x += y(i) * z_vec[i];
+    }
+}
+
+/**
+ * @brief BiCGSTAB, preconditioned on the right: short recurrences, so less
+ * memory than GMRES, at the cost of a less steady residual
+ *
+ * @return int iterations
+ */
+int IterativeSolver::BiCgStab(const vec& b, vec& x, const double tolerance,
+                              const int max_iterations, double& residual) const {
+    double b_norm = arma::norm(b);
+    if (b_norm == 0) {
+        x.zeros();
+        residual = 0;
+        return 0;
+    }
+
+    vec r = b - Multiply(a, x);
+    residual = arma::norm(r) / b_norm;
+    if (residual <= tolerance)
+        return 0;
+
+    vec r_hat = r;
+    vec p(n, arma::fill::zeros);
+    vec v(n, arma::fill::zeros);
+    double rho = 1;
+    double alpha = 1;
+    double omega = 1;
+    for (int k = 1; k <= max_iterations; k++) {
+        double rho_next = arma::dot(r_hat, r);
+        if (rho_next == 0 || omega == 0)
+            return k - 1;  // Broke down
+        p = r + (rho_next / rho) * (alpha / omega) * (p - omega * v);
+        rho = rho_next;
+
+        vec p_hat = Precondition(p);
+        v = Multiply(a, p_hat);
+        alpha = rho / arma::dot(r_hat, v);
+        vec s = r - alpha * v;
+        if (arma::norm(s) / b_norm <= tolerance) {
+            x += alpha * p_hat;
+            residual = arma::norm(s) / b_norm;
+            return k;
+        }
+
+        vec s_hat = Precondition(s);
+        vec t = Multiply(a, s_hat);
+        omega = arma::dot(t, s) / arma::dot(t, t);
+        x += alpha * p_hat + omega * s_hat;
+        r = s - omega * t;
+        residual = arma::norm(r) / b_norm;
+        if (residual <= tolerance || !std::isfinite(residual))
+            return k;
+    }
+    return max_iterations;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file iterative_solver.h
+ * @author Yaotian Liu
+ * @brief Preconditioned Krylov solvers: PCG, GMRES and BiCGSTAB
+ * @date 2026-10-19
+ */
+
+#if !defined(ITERATIVE_SOLVER_H)
+#define ITERATIVE_SOLVER_H
+
+#include <armadillo>
+#include <vector>
+
+#include "preconditioner.h"
+#include "solver_options.h"
+#include "sparse_matrix.h"
+
+// GMRES keeps this many basis vectors before it restarts
+const int GMRES_RESTART = 50;
+
+struct IterativeStats {
+    long long solve_num = 0;
+    long long iteration_num = 0;
+    int failed_num = 0;          // Solves that stopped above the tolerance
+    double worst_residual = 0;  // Relative to the right hand side
+
+    void Add(const IterativeStats& other);
+};
+
+/**
+ * @brief Solves A x = b without factoring A: only A and a preconditioner M
+ * are kept, which is what fits in memory for the largest grids. Each solve
+ * starts from a guess, e.g. the solution of the previous sweep point or time
+ * step, which is usually close.
+ */
+class IterativeSolver {
+  public:
+    bool Setup(const CscMatrix& a, const KrylovMethod method,
+               const PreconditionerType preconditioner);
+    void Clear();
+
+    bool Ready() const { return n > 0; }
+    KrylovMethod Method() const { return method; }
+    PreconditionerType Preconditioner() const { return preconditioner; }
+    const IterativeStats& Stats() const { return stats; }
+
+    arma::vec Solve(const arma::vec& rhs, const arma::vec& guess, const double tolerance,
+                    const int max_iterations);
+
+  private:
+    int n = 0;
+    CscMatrix a;
+    KrylovMethod method = AUTO_KRYLOV;
+    PreconditionerType preconditioner = AUTO_PRECONDITIONER;
+    std::vector<double> inv_diag;
+    IncompleteLu incomplete_lu;
+    Amg amg;
+    IterativeStats stats;
+
+    arma::vec Precondition(const arma::vec& r) const;
+    int Pcg(const arma::vec& b, arma::vec& x, const double tolerance, const int max_iterations,
+            double& residual) const;
+    int Gmres(const arma::vec& b, arma::vec& x, const double tolerance,
+              const int max_iterations, double& residual) const;
+    int BiCgStab(const arma::vec& b, arma::vec& x, const double tolerance,
+                 const int max_iterations, double& residual) const;
+};
+
+#endif  // ITERATIVE_SOLVER_H
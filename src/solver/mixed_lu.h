@@ -0,0 +1,168 @@
+/**
+ * @file mixed_lu.h
+ * @author Yaotian Liu
+ * @brief Dense LU in single precision, refined to double precision
+ * @date 2026-10-19
+ */
+
+#if !defined(MIXED_LU_H)
+#define MIXED_LU_H
+
+#include <armadillo>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <limits>
+
+// Refinement steps before a solve gives up on single precision
+const int MIXED_MAX_REFINE = 10;
+
+// Each refinement step must shrink the residual at least this much
+const double MIXED_MIN_PROGRESS = 0.5;
+
+template <typename T>
+struct SinglePrecision {
+    typedef float type;
+};
+template <>
+struct SinglePrecision<std::complex<double>> {
+    typedef std::complex<float> type;
+};
+
+struct MixedStats {
+    long long solve_num = 0;
+    long long refine_num = 0;
+    bool fallback = false;  // Factored in double precision after all
+
+    void Add(const MixedStats& other) {
+        solve_num += other.solve_num;
+        refine_num += other.refine_num;
+        fallback = fallback || other.fallback;
+    }
+};
+
+/**
+ * @brief LU factors in single precision, half the memory traffic of double
+ * and twice the SIMD width, with the accuracy of double recovered by
+ * iterative refinement (as LAPACK dsgesv does): x += A^-1 (b - A x), the
+ * residual in double, the correction from the single precision factors.
+ * The matrix itself is only kept as a sparse copy for the residual, so the
+ * factors are the one dense n x n held, in single precision. When a matrix
+ * does not fit single precision, or refinement stalls because it is too ill
+ * conditioned, it is factored again in double and stays so.
+ *
+ * @tparam T double or std::complex<double>
+ */
+template <typename T>
+class MixedLu {
+  public:
+    typedef arma::Mat<T> Matrix;
+    typedef arma::Col<T> Vector;
+    typedef typename SinglePrecision<T>::type S;
+
+    /**
+     * @return true : Factored, in single or double precision
+     * @return false : Singular
+     */
+    bool Factor(const Matrix& matrix) {
+        Clear();
+        a = arma::SpMat<T>(matrix);
+        a_norm = arma::norm(matrix, "inf");
+
+        arma::Mat<S> p;
+        arma::Mat<S> single = arma::conv_to<arma::Mat<S>>::from(matrix);
+        if (single.is_finite() && arma::lu(lower, upper, p, single) &&
+            WellPivoted(arma::conv_to<arma::vec>::from(arma::abs(upper.diag())),
+                        std::numeric_limits<float>::epsilon())) {
+            perm = arma::conv_to<arma::uvec>::from(
+                arma::real(p) * arma::regspace<arma::Col<float>>(0, a.n_rows - 1.0));
+            return true;
+        }
+        return FactorDouble();
+    }
+
+    void Clear() {
+        a.reset();
+        lower.reset();
+        upper.reset();
+        lower_double.reset();
+        upper_double.reset();
+        perm.reset();
+        stats = MixedStats();
+    }
+
+    const MixedStats& Stats() const { return stats; }
+
+    Vector Solve(const Vector& rhs) {
+        stats.solve_num++;
+        if (stats.fallback)
+            return SolveDouble(rhs);
+
+        // Converged once the residual is at rounding level of a double solve
+        double limit = a_norm * std::sqrt(double(a.n_rows)) * arma::datum::eps;
+        Vector x = SolveSingle(rhs);
+        double last = std::numeric_limits<double>::infinity();
+        for (int k = 0; k <= MIXED_MAX_REFINE; k++) {
+            Vector r = rhs - a * x;
+            double residual = arma::norm(r, "inf");
+            if (residual <= limit * arma::norm(x, "inf"))
+                return x;
+            if (!(residual < MIXED_MIN_PROGRESS * last) || k == MIXED_MAX_REFINE)
+                break;
+            last = residual;
+            x += SolveSingle(r);
+            stats.refine_num++;
+        }
+
+        std::cout << "Refinement stalled, factoring in double precision" << std::endl;
+        if (!FactorDouble())
+            return x;
+        return SolveDouble(rhs);
+    }
+
+  private:
+    arma::SpMat<T> a;  // For the residual, and to factor again in double
+    double a_norm = 0;
+    arma::Mat<S> lower;
+    arma::Mat<S> upper;
+    Matrix lower_double;
+    Matrix upper_double;
+    arma::uvec perm;  // Row i of L U is row perm(i) of A
+    MixedStats stats;
+
+    static bool WellPivoted(const arma::vec& pivot, const double eps) {
+        return pivot.is_finite() && pivot.min() > pivot.max() * pivot.n_elem * eps;
+    }
+
+    // The single precision factors are kept if this fails
+    bool FactorDouble() {
+        Matrix p;
+        if (!arma::lu(lower_double, upper_double, p, Matrix(a)) ||
+            !WellPivoted(arma::conv_to<arma::vec>::from(arma::abs(upper_double.diag())),
+                         arma::datum::eps)) {
+            lower_double.reset();
+            upper_double.reset();
+            return false;
+        }
+        lower.reset();
+        upper.reset();
+        stats.fallback = true;
+        perm = arma::conv_to<arma::uvec>::from(arma::real(p) *
+                                               arma::regspace<arma::vec>(0, a.n_rows - 1.0));
+        return true;
+    }
+
+    Vector SolveSingle(const Vector& rhs) const {
+        arma::Col<S> permuted = arma::conv_to<arma::Col<S>>::from(Vector(rhs.elem(perm)));
+        arma::Col<S> y = arma::solve(arma::trimatl(lower), permuted);
+        return arma::conv_to<Vector>::from(arma::Col<S>(arma::solve(arma::trimatu(upper), y)));
+    }
+
+    Vector SolveDouble(const Vector& rhs) const {
+        Vector permuted = rhs.elem(perm);
+        Vector y = arma::solve(arma::trimatl(lower_double), permuted);
+        return arma::solve(arma::trimatu(upper_double), y);
+    }
+};
+
+#endif  // MIXED_LU_H
@@ -0,0 +1,483 @@
+/**
+ * @file ordering.cpp
+ * @author Yaotian Liu
+ * @brief Fill-reducing orderings of sparse systems, and their fill estimates
+ * @date 2026-10-19
+ */
+
+#include "ordering.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+using std::cout;
+using std::endl;
+using std::setw;
+using std::vector;
+
+/**
+ * @brief Breadth first level structures on a subgraph: the nodes whose part
+ * is `id`. Visits are stamped, so walking a small part does not touch the
+ * whole graph.
+ */
+struct LevelWalker {
+    const Graph& graph;
+    vector<int> part;
+    vector<int> seen;
+    int stamp = 0;
+
+    LevelWalker(const Graph& graph)
+        : graph(graph), part(graph.size(), 0), seen(graph.size(), -1) {}
+
+    vector<vector<int>> Levels(const int root, const int id) {
+        stamp++;
+        vector<vector<int>> level_vec{{root}};
+        seen[root] = stamp;
+        while (true) {
+            vector<int> next;
+            for (int v : level_vec.back()) {
+                for (int u : graph[v]) {
+                    if (part[u] == id && seen[u] != stamp) {
+                        seen[u] = stamp;
+                        next.push_back(u);
+                    }
+                }
+            }
+            if (next.empty())
+                break;
+            level_vec.push_back(std::move(next));
+        }
+        return level_vec;
+    }
+
+    // George and Liu: restart from the node of the last level with the fewest
+    // neighbours while that makes the structure deeper.
+    int PseudoPeripheral(int root, const int id) {
+        std::size_t depth = 0;
+        while (true) {
+            vector<vector<int>> level_vec = Levels(root, id);
+            if (level_vec.size() <= depth)
+                return root;
+            depth = level_vec.size();
+
+            int next = level_vec.back()[0];
+            for (int v : level_vec.back())
+                if (graph[v].size() < graph[next].size())
+                    next = v;
+            if (next == root)
+                return root;
+            root = next;
+        }
+    }
+};
+
+/**
+ * @brief Approximate minimum degree (Amestoy, Davis and Duff) on the graph of
+ * the nodes in `node_vec` (edges leaving them are ignored). The elimination
+ * graph is kept as a quotient graph: an eliminated node becomes an element,
+ * the set of nodes it joined into a clique, and every node lists the nodes
+ * and elements next to it, so the cliques are never formed. Elements inside
+ * the new one are absorbed by it. The degrees are not counted exactly but
+ * bounded from above with |L_e \ L_p| of the neighbouring elements e of the
+ * new element p, which takes one pass over them per elimination.
+ *
+ * @param graph
+ * @param node_vec
+ * @param local scratch, -1 for every node of the graph, restored on return
+ * @return vector<int> the nodes of node_vec in elimination order
+ */
+vector<int> MinimumDegree(const Graph& graph, const vector<int>& node_vec, vector<int>& local) {
+    int n = node_vec.size();
+    for (int k = 0; k < n; k++)
+        local[node_vec[k]] = k;
+
+    // Quotient graph: A_i variables and E_i elements next to node i, L_e the
+    // variables of element e (named after the node it was)
+    Graph a_vec(n);
+    Graph e_vec(n);
+    Graph l_vec(n);
+    vector<int> mark(n, -1);  // -2 - k while in the neighbours of k, p in L_p
+    for (int k = 0; k < n; k++) {
+        for (int u : graph[node_vec[k]]) {
+            if (local[u] >= 0 && local[u] != k && mark[local[u]] != -2 - k) {
+                mark[local[u]] = -2 - k;
+                a_vec[k].push_back(local[u]);
+            }
+        }
+    }
+
+    vector<char> eliminated(n, 0);
+    vector<char> absorbed(n, 0);
+    vector<int> degree(n);
+
+    // Nodes by degree, as doubly linked lists
+    vector<int> head(n, -1);
+    vector<int> next(n, -1);
+    vector<int> prev(n, -1);
+    auto insert = [&](const int i) {
+        prev[i] = -1;
+        next[i] = head[degree[i]];
+        if (next[i] >= 0)
+            prev[next[i]] = i;
+        head[degree[i]] = i;
+    };
+    auto remove = [&](const int i) {
+        if (prev[i] >= 0)
+            next[prev[i]] = next[i];
+        else
+            head[degree[i]] = next[i];
+        if (next[i] >= 0)
+            prev[next[i]] = prev[i];
+    };
+    for (int i = 0; i < n; i++) {
+        degree[i] = a_vec[i].size();
+        insert(i);
+    }
+
+    vector<int> w(n, 0);  // |L_e \ L_p|, valid while w_stamp[e] == p
+    vector<int> w_stamp(n, -1);
+    vector<int> order;
+    int min_degree = 0;
+    for (int k = 0; k < n; k++) {
+        while (head[min_degree] < 0)
+            min_degree++;
+        int p = head[min_degree];
+        remove(p);
+        eliminated[p] = 1;
+        order.push_back(node_vec[p]);
+
+        // L_p: the variables next to p, directly or through its elements,
+        // which p absorbs
+        vector<int>& l_p = l_vec[p];
+        auto add = [&](const int i) {
+            if (!eliminated[i] && mark[i] != p) {
+                mark[i] = p;
+                l_p.push_back(i);
+            }
+        };
+        for (int i : a_vec[p])
+            add(i);
+        for (int e : e_vec[p]) {
+            if (absorbed[e])
+                continue;
+            for (int i : l_vec[e])
+                add(i);
+            absorbed[e] = 1;
+            vector<int>().swap(l_vec[e]);
+        }
+        vector<int>().swap(a_vec[p]);
+        vector<int>().swap(e_vec[p]);
+
+        // |L_e \ L_p| of the other elements next to L_p
+        for (int i : l_p) {
+            for (int e : e_vec[i]) {
+                if (absorbed[e])
+                    continue;
+                if (w_stamp[e] != p) {
+                    w_stamp[e] = p;
+                    w[e] = l_vec[e].size();
+                }
+                w[e]--;
+            }
+        }
+
+        int remaining = n - k - 1;
+        int l_p_size = l_p.size();
+        for (int i : l_p) {
+            remove(i);
+
+            // Elements inside L_p are absorbed by p as well
+            int element_degree = 0;
+            std::size_t kept = 0;
+            for (int e : e_vec[i]) {
+                if (absorbed[e])
+                    continue;
+                if (w[e] == 0) {
+                    absorbed[e] = 1;
+                    vector<int>().swap(l_vec[e]);
+                    continue;
+                }
+                element_degree += w[e];
+                e_vec[i][kept++] = e;
+            }
+            e_vec[i].resize(kept);
+            e_vec[i].push_back(p);
+
+            // Variables in L_p are reached through p from now on
+            kept = 0;
+            for (int j : a_vec[i])
+                if (!eliminated[j] && mark[j] != p)
+                    a_vec[i][kept++] = j;
+            a_vec[i].resize(kept);
+
+            int bound = int(a_vec[i].size()) + (l_p_size - 1) + element_degree;
+            degree[i] = std::min({remaining - 1, degree[i] + l_p_size - 1, bound});
+            degree[i] = std::max(degree[i], 0);
+            insert(i);
+            min_degree = std::min(min_degree, degree[i]);
+        }
+    }
+
+    for (int node : node_vec)
+        local[node] = -1;
+    return order;
+}
+
+vector<int> MinimumDegreeOrdering(const Graph& graph) {
+    vector<int> node_vec(graph.size());
+    std::iota(node_vec.begin(), node_vec.end(), 0);
+    vector<int> local(graph.size(), -1);
+    return MinimumDegree(graph, node_vec, local);
+}
+
+/**
+ * @brief Reverse Cuthill-McKee: breadth first from a pseudo-peripheral node,
+ * neighbours by increasing degree, reversed. Keeps the profile narrow rather
+ * than minimizing fill.
+ */
+vector<int> RcmOrdering(const Graph& graph) {
+    int n = graph.size();
+    LevelWalker walker(graph);
+    vector<char> placed(n, 0);
+    vector<int> order;
+
+    auto by_degree = [&](int u, int w) { return graph[u].size() < graph[w].size(); };
+    vector<int> start_vec(n);
+    std::iota(start_vec.begin(), start_vec.end(), 0);
+    std::stable_sort(start_vec.begin(), start_vec.end(), by_degree);
+
+    // One component per start that is not placed yet
+    for (int start : start_vec) {
+        if (placed[start])
+            continue;
+        int root = walker.PseudoPeripheral(start, 0);
+
+        std::size_t head = order.size();
+        order.push_back(root);
+        placed[root] = 1;
+        while (head < order.size()) {
+            int v = order[head++];
+            vector<int> next;
+            for (int u : graph[v]) {
+                if (!placed[u]) {
+                    placed[u] = 1;
+                    next.push_back(u);
+                }
+            }
+            std::stable_sort(next.begin(), next.end(), by_degree);
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+/**
+ * @brief Split the nodes of part `id` in two halves and a separator: the
+ * middle level of a level structure separates the levels before it from the
+ * ones after it. A part that is not connected splits into the component of
+ * the root and the rest, with no separator.
+ *
+ * @return true : Split
+ * @return false : Too shallow to split (fewer than 3 levels)
+ */
+bool Split(LevelWalker& walker, const vector<int>& node_vec, const int id, vector<int>& left,
+           vector<int>& right, vector<int>& separator) {
+    left.clear();
+    right.clear();
+    separator.clear();
+
+    for (int v : node_vec)
+        walker.part[v] = id;
+    int root = walker.PseudoPeripheral(node_vec[0], id);
+    vector<vector<int>> level_vec = walker.Levels(root, id);
+
+    for (auto& level : level_vec)
+        left.insert(left.end(), level.begin(), level.end());
+    if (left.size() < node_vec.size()) {
+        for (int v : node_vec)
+            if (walker.seen[v] != walker.stamp)
+                right.push_back(v);
+        return true;
+    }
+
+    left.clear();
+    if (level_vec.size() < 3)
+        return false;
+
+    std::size_t half = node_vec.size() / 2;
+    std::size_t count = 0;
+    std::size_t middle = 0;
+    for (; middle < level_vec.size(); middle++) {
+        count += level_vec[middle].size();
+        if (count >= half)
+            break;
+    }
+    middle = std::min(std::max<std::size_t>(middle, 1), level_vec.size() - 2);
+
+    for (std::size_t k = 0; k < level_vec.size(); k++) {
+        if (k < middle)
+            left.insert(left.end(), level_vec[k].begin(), level_vec[k].end());
+        else if (k > middle)
+            right.insert(right.end(), level_vec[k].begin(), level_vec[k].end());
+    }
+    separator = level_vec[middle];
+    return true;
+}
+
+/**
+ * @brief Split the nodes of `node_vec` in two halves with no edge between
+ * them and the separator that joins them
+ *
+ * @param graph
+ * @param node_vec not empty; edges leaving it are ignored
+ * @param left
+ * @param right
+ * @param separator
+ * @return true : Split
+ * @return false : Too shallow to split
+ */
+bool BisectGraph(const Graph& graph, const vector<int>& node_vec, vector<int>& left,
+                 vector<int>& right, vector<int>& separator) {
+    LevelWalker walker(graph);
+    return Split(walker, node_vec, 1, left, right, separator);
+}
+
+/**
+ * @brief Order `node_vec` by nested dissection: both halves of a split are
+ * ordered the same way and the separator goes last.
+ */
+void Dissect(LevelWalker& walker, const vector<int>& node_vec, int& next_id,
+             vector<int>& local, vector<int>& order) {
+    if (node_vec.empty())
+        return;
+
+    vector<int> left;
+    vector<int> right;
+    vector<int> separator;
+    if (int(node_vec.size()) <= ND_LEAF_SIZE ||
+        !Split(walker, node_vec, ++next_id, left, right, separator)) {
+        vector<int> leaf_order = MinimumDegree(walker.graph, node_vec, local);
+        order.insert(order.end(), leaf_order.begin(), leaf_order.end());
+        return;
+    }
+
+    Dissect(walker, left, next_id, local, order);
+    Dissect(walker, right, next_id, local, order);
+    order.insert(order.end(), separator.begin(), separator.end());
+}
+
+vector<int> NestedDissectionOrdering(const Graph& graph) {
+    vector<int> node_vec(graph.size());
+    std::iota(node_vec.begin(), node_vec.end(), 0);
+
+    LevelWalker walker(graph);
+    vector<int> local(graph.size(), -1);
+    vector<int> order;
+    int next_id = 0;
+    Dissect(walker, node_vec, next_id, local, order);
+    return order;
+}
+
+/**
+ * @brief Column order of a square matrix for factorization: perm[k] is the
+ * unknown eliminated k-th. AMD, RCM and ND work on the graph of A + A^T and
+ * assume pivots mostly on the diagonal; COLAMD works on the graph of A^T A,
+ * which holds whatever rows are pivoted.
+ *
+ * @param a
+ * @param ordering
+ * @return vector<int>
+ */
+vector<int> ComputeOrdering(const CscMatrix& a, const OrderingType ordering) {
+    switch (ordering) {
+        case AMD_ORDERING: return MinimumDegreeOrdering(SymmetricGraph(a));
+        case COLAMD_ORDERING: return MinimumDegreeOrdering(ColumnGraph(a));
+        case RCM_ORDERING: return RcmOrdering(SymmetricGraph(a));
+        case ND_ORDERING: return NestedDissectionOrdering(SymmetricGraph(a));
+        default: {
+            vector<int> perm(a.n_cols);
+            std::iota(perm.begin(), perm.end(), 0);
+            return perm;
+        }
+    }
+}
+
+/**
+ * @brief Symbolic factorization of the permuted A + A^T: the pattern of a
+ * column of L is its own entries below the diagonal joined with the patterns
+ * of its children in the elimination tree.
+ *
+ * @param a
+ * @param perm
+ * @return FillEstimate
+ */
+FillEstimate EstimateFill(const CscMatrix& a, const vector<int>& perm) {
+    Graph graph = SymmetricGraph(a);
+    int n = graph.size();
+    vector<int> pinv(n);
+    for (int k = 0; k < n; k++)
+        pinv[perm[k]] = k;
+
+    FillEstimate estimate;
+    estimate.nnz_a = a.NonZeros();
+    estimate.nnz_lu = n;
+
+    Graph col_struct(n);  // Rows of L below the diagonal, until merged into the parent
+    Graph child_vec(n);
+    vector<int> pattern;
+    vector<int> merged;
+    for (int j = 0; j < n; j++) {
+        pattern.clear();
+        for (int u : graph[perm[j]])
+            if (pinv[u] > j)
+                pattern.push_back(pinv[u]);
+        std::sort(pattern.begin(), pattern.end());
+
+        for (int c : child_vec[j]) {
+            merged.clear();
+            std::set_union(pattern.begin(), pattern.end(), col_struct[c].begin(),
+                           col_struct[c].end(), std::back_inserter(merged));
+            pattern.swap(merged);
+            vector<int>().swap(col_struct[c]);
+        }
+        // Children have j, their parent, as first row
+        if (!pattern.empty() && pattern[0] == j)
+            pattern.erase(pattern.begin());
+
+        if (!pattern.empty())
+            child_vec[pattern[0]].push_back(j);
+
+        double count = pattern.size();
+        estimate.nnz_lu += 2 * pattern.size();
+        estimate.flops += count + 2 * count * count;
+        col_struct[j] = pattern;
+    }
+    return estimate;
+}
+
+/**
+ * @brief Print the time, fill and work of every ordering of `a`
+ */
+void PrintOrderingReport(const CscMatrix& a) {
+    cout << "Ordering report: " << a.n_cols << " unknowns, " << a.NonZeros() << " nonzeros"
+         << endl;
+    cout << setw(10) << "ordering" << setw(12) << "time (ms)" << setw(14) << "nnz(L+U)"
+         << setw(10) << "fill" << setw(14) << "flops" << endl;
+
+    for (std::size_t k = 0; k < OrderingType_lookup.size(); k++) {
+        auto begin = std::chrono::steady_clock::now();
+        vector<int> perm = ComputeOrdering(a, OrderingType(k));
+        std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+
+        FillEstimate estimate = EstimateFill(a, perm);
+        cout << setw(10) << OrderingType_lookup[k] << setw(12) << ms.count() << setw(14)
+             << estimate.nnz_lu << setw(10)
+             << double(estimate.nnz_lu) / std::max(1LL, estimate.nnz_a) << setw(14)
+             << estimate.flops << endl;
+    }
+}
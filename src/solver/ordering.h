@@ -0,0 +1,43 @@
+/**
+ * @file ordering.h
+ * @author Yaotian Liu
+ * @brief Fill-reducing orderings of sparse systems, and their fill estimates
+ * @date 2026-10-19
+ */
+
+#if !defined(ORDERING_H)
+#define ORDERING_H
+
+#include <string>
+#include <vector>
+
+#include "sparse_matrix.h"
+
+// `.options ordering=...`
+enum OrderingType { NATURAL_ORDERING, AMD_ORDERING, COLAMD_ORDERING, RCM_ORDERING, ND_ORDERING };
+const std::vector<std::string> OrderingType_lookup = {"natural", "amd", "colamd", "rcm", "nd"};
+
+// Nested dissection stops bisecting at this many nodes and orders the rest by
+// minimum degree
+const int ND_LEAF_SIZE = 64;
+
+// Entries and work of a factorization with diagonal pivots, from the
+// symbolic factorization of the permuted A + A^T
+struct FillEstimate {
+    long long nnz_a = 0;
+    long long nnz_lu = 0;  // L + U, diagonal once
+    double flops = 0;
+};
+
+std::vector<int> ComputeOrdering(const CscMatrix& a, const OrderingType ordering);
+std::vector<int> MinimumDegreeOrdering(const Graph& graph);
+std::vector<int> RcmOrdering(const Graph& graph);
+std::vector<int> NestedDissectionOrdering(const Graph& graph);
+
+bool BisectGraph(const Graph& graph, const std::vector<int>& node_vec, std::vector<int>& left,
+                 std::vector<int>& right, std::vector<int>& separator);
+
+FillEstimate EstimateFill(const CscMatrix& a, const std::vector<int>& perm);
+void PrintOrderingReport(const CscMatrix& a);
+
+#endif  // ORDERING_H
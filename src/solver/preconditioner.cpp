@@ -0,0 +1,260 @@
+/**
+ * @file preconditioner.cpp
+ * @author Yaotian Liu
+ * @brief Preconditioners of the iterative solver: incomplete factorizations
+ * and algebraic multigrid
+ * @date 2026-10-19
+ */
+
+#include "preconditioner.h"
+
+#include <cmath>
+
+#include "ordering.h"
+
+using arma::vec;
+using std::vector;
+
+/**
+ * @brief Factor `a`, retrying with a growing diagonal shift while the
+ * factorization breaks down
+ *
+ * @param a square
+ * @param symmetric IC0: pivots must be positive
+ * @return true : Factored
+ * @return false : Broke down with every shift
+ */
+bool IncompleteLu::Factor(const CscMatrix& a, const bool symmetric) {
+    for (double shift : ILU_SHIFT_VEC)
+        if (FactorShifted(a, symmetric, shift))
+            return true;
+    n = 0;
+    return false;
+}
+
+bool IncompleteLu::FactorShifted(const CscMatrix& a, const bool symmetric,
+                                 const double shift) {
+    // Rows of A are the columns of A^T
+    CscMatrix t = Transpose(a);
+    n = a.n_cols;
+    row_ptr.assign(n + 1, 0);
+    col_index.clear();
+    value.clear();
+    diag.assign(n, -1);
+
+    for (int i = 0; i < n; i++) {
+        bool has_diag = false;
+        for (int p = t.col_ptr[i]; p < t.col_ptr[i + 1]; p++) {
+            int j = t.row_index[p];
+            if (j > i && !has_diag) {
+                diag[i] = col_index.size();
+                col_index.push_back(i);
+                value.push_back(0);
+                has_diag = true;
+            }
+            if (j == i) {
+                diag[i] = col_index.size();
+                has_diag = true;
+            }
+            col_index.push_back(j);
+            value.push_back(t.value[p]);
+        }
+        if (!has_diag) {
+            diag[i] = col_index.size();
+            col_index.push_back(i);
+            value.push_back(0);
+        }
+        row_ptr[i + 1] = col_index.size();
+        value[diag[i]] += shift * std::fabs(value[diag[i]]);
+    }
+
+    // Row i is reduced by the rows above it, in column order, keeping only
+    // the entries of its pattern
+    vector<int> position(n, -1);
+    for (int i = 0; i < n; i++) {
+        for (int p = row_ptr[i]; p < row_ptr[i + 1]; p++)
+            position[col_index[p]] = p;
+
+        for (int p = row_ptr[i]; p < diag[i]; p++) {
+            int k = col_index[p];
+            value[p] /= value[diag[k]];
+            for (int q = diag[k] + 1; q < row_ptr[k + 1]; q++)
+                if (position[col_index[q]] >= 0)
+                    value[position[col_index[q]]] -= value[p] * value[q];
+        }
+
+        for (int p = row_ptr[i]; p < row_ptr[i + 1]; p++)
+            position[col_index[p]] = -1;
+
+        double pivot = value[diag[i]];
+        if (pivot == 0 || !std::isfinite(pivot) || (symmetric && pivot < 0))
+            return false;
+    }
+    return true;
+}
+
+vec IncompleteLu::Solve(const vec& rhs) const {
+    vec x = rhs;
+    for (int i = 0; i < n; i++)
+        for (int p = row_ptr[i]; p < diag[i]; p++)
+            x(i) -= value[p] * x(col_index[p]);
+    for (int i = n - 1; i >= 0; i--) {
+        for (int p = diag[i] + 1; p < row_ptr[i + 1]; p++)
+            x(i) -= value[p] * x(col_index[p]);
+        x(i) /= value[diag[i]];
+    }
+    return x;
+}
+
+/**
+ * @brief Aggregates of strongly connected unknowns: first whole
+ * neighbourhoods that are still free, then the unknowns left over join a
+ * neighbouring aggregate, or make their own.
+ *
+ * @param a
+ * @param diagonal
+ * @param aggregate_num output
+ * @return vector<int> aggregate of every unknown
+ */
+vector<int> Aggregate(const CscMatrix& a, const vector<double>& diagonal, int& aggregate_num) {
+    int n = a.n_cols;
+    Graph strong(n);
+    for (int j = 0; j < n; j++) {
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++) {
+            int i = a.row_index[p];
+            if (i != j &&
+                std::fabs(a.value[p]) >= AMG_STRENGTH * std::sqrt(diagonal[i] * diagonal[j]))
+                strong[j].push_back(i);
+        }
+    }
+
+    vector<int> aggregate(n, -1);
+    aggregate_num = 0;
+    for (int i = 0; i < n; i++) {
+        if (aggregate[i] >= 0)
+            continue;
+        bool all_free = true;
+        for (int u : strong[i])
+            all_free = all_free && aggregate[u] < 0;
+        if (!all_free)
+            continue;
+        aggregate[i] = aggregate_num;
+        for (int u : strong[i])
+            aggregate[u] = aggregate_num;
+        aggregate_num++;
+    }
+
+    vector<int> first = aggregate;
+    for (int i = 0; i < n; i++) {
+        if (aggregate[i] >= 0)
+            continue;
+        for (int u : strong[i]) {
+            if (first[u] >= 0) {
+                aggregate[i] = first[u];
+                break;
+            }
+        }
+        if (aggregate[i] < 0)
+            aggregate[i] = aggregate_num++;
+    }
+    return aggregate;
+}
+
+/**
+ * @brief Build the levels down to a coarse matrix small enough to factor
+ *
+ * @param a square, positive diagonal
+ * @return true : Set up
+ * @return false : A diagonal entry is not positive, or the coarse matrix is
+ * singular
+ */
+bool Amg::Setup(const CscMatrix& a) {
+    level_vec.clear();
+    coarse_lu.Clear();
+
+    CscMatrix current = a;
+    while (current.n_cols > AMG_COARSE_SIZE) {
+        int n = current.n_cols;
+        vector<double> diagonal(n, 0);
+        for (int j = 0; j < n; j++)
+            for (int p = current.col_ptr[j]; p < current.col_ptr[j + 1]; p++)
+                if (current.row_index[p] == j)
+                    diagonal[j] = current.value[p];
+        for (double d : diagonal)
+            if (!(d > 0))
+                return false;
+
+        int aggregate_num = 0;
+        vector<int> aggregate = Aggregate(current, diagonal, aggregate_num);
+        // Coarsening stalled, factor what is left
+        if (aggregate_num > 0.8 * n)
+            break;
+
+        CscMatrix tentative;
+        tentative.n_rows = n;
+        tentative.n_cols = aggregate_num;
+        tentative.col_ptr.assign(aggregate_num + 1, 0);
+        for (int i = 0; i < n; i++)
+            tentative.col_ptr[aggregate[i] + 1]++;
+        for (int k = 0; k < aggregate_num; k++)
+            tentative.col_ptr[k + 1] += tentative.col_ptr[k];
+        tentative.row_index.resize(n);
+        tentative.value.assign(n, 1);
+        vector<int> next(tentative.col_ptr.begin(), tentative.col_ptr.end() - 1);
+        for (int i = 0; i < n; i++)
+            tentative.row_index[next[aggregate[i]]++] = i;
+
+        // Smoother I - w D^-1 A
+        CscMatrix smoother = current;
+        for (int j = 0; j < n; j++) {
+            for (int p = smoother.col_ptr[j]; p < smoother.col_ptr[j + 1]; p++) {
+                int i = smoother.row_index[p];
+                smoother.value[p] *= -AMG_JACOBI_WEIGHT / diagonal[i];
+                if (i == j)
+                    smoother.value[p] += 1;
+            }
+        }
+
+        Level level;
+        level.a = current;
+        level.p = Multiply(smoother, tentative);
+        level.r = Transpose(level.p);
+        level.inv_diag.resize(n);
+        for (int i = 0; i < n; i++)
+            level.inv_diag[i] = 1 / diagonal[i];
+
+        current = Multiply(level.r, Multiply(current, level.p));
+        level_vec.push_back(std::move(level));
+    }
+
+    if (!coarse_lu.Factor(current, ComputeOrdering(current, AMD_ORDERING))) {
+        level_vec.clear();
+        return false;
+    }
+    return true;
+}
+
+void Amg::Smooth(const Level& level, const vec& rhs, vec& x) const {
+    for (int s = 0; s < AMG_SMOOTH_NUM; s++) {
+        vec residual = rhs - Multiply(level.a, x);
+        for (std::size_t i = 0; i < level.inv_diag.size(); i++)
+            x(i) += AMG_JACOBI_WEIGHT * level.inv_diag[i] * residual(i);
+    }
+}
+
+/**
+ * @brief One V-cycle from a zero guess: smooth, correct from the coarser
+ * level, smooth again
+ */
+vec Amg::Cycle(const std::size_t level, const vec& rhs) const {
+    if (level == level_vec.size())
+        return coarse_lu.Solve(rhs);
+
+    const Level& current = level_vec[level];
+    vec x(rhs.n_elem, arma::fill::zeros);
+    Smooth(current, rhs, x);
+    vec residual = rhs - Multiply(current.a, x);
+    x += Multiply(current.p, Cycle(level + 1, Multiply(current.r, residual)));
+    Smooth(current, rhs, x);
+    return x;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file preconditioner.h
+ * @author Yaotian Liu
+ * @brief Preconditioners of the iterative solver: incomplete factorizations
+ * and algebraic multigrid
+ * @date 2026-10-19
+ */
+
+#if !defined(PRECONDITIONER_H)
+#define PRECONDITIONER_H
+
+#include <armadillo>
+#include <vector>
+
+#include "sparse_lu.h"
+#include "sparse_matrix.h"
+
+// Diagonal shifts, relative to the diagonal, tried in turn when an
+// incomplete factorization breaks down
+const std::vector<double> ILU_SHIFT_VEC = {0, 1e-3, 1e-2, 1e-1};
+
+// Multigrid levels stop coarsening at this many unknowns, which are factored
+const int AMG_COARSE_SIZE = 200;
+// a_ij is a strong connection when |a_ij| >= AMG_STRENGTH sqrt(a_ii a_jj)
+const double AMG_STRENGTH = 0.08;
+// Damped Jacobi smoothing, sweeps before and after the coarse correction
+const double AMG_JACOBI_WEIGHT = 2.0 / 3;
+const int AMG_SMOOTH_NUM = 2;
+
+/**
+ * @brief Incomplete LU with the pattern of A plus the diagonal (ILU0): the
+ * elimination keeps only the entries A already has. On a symmetric matrix
+ * the upper factor is D L^T, which makes it the incomplete Cholesky (IC0)
+ * that PCG needs, as long as every pivot stays positive.
+ */
+class IncompleteLu {
+  public:
+    bool Factor(const CscMatrix& a, const bool symmetric);
+    arma::vec Solve(const arma::vec& rhs) const;
+
+  private:
+    int n = 0;
+    // Rows of L (unit diagonal, not stored) and U together, as CSR
+    std::vector<int> row_ptr;
+    std::vector<int> col_index;
+    std::vector<int> diag;  // Position of the diagonal in every row
+    std::vector<double> value;
+
+    bool FactorShifted(const CscMatrix& a, const bool symmetric, const double shift);
+};
+
+/**
+ * @brief Smoothed aggregation multigrid for matrices with a positive
+ * diagonal (resistive grids). Strongly connected unknowns are aggregated
+ * into one coarse unknown, the piecewise constant interpolation is smoothed
+ * by a Jacobi step, and the coarse matrix is R A P with R = P^T. Applied as
+ * one V-cycle.
+ */
+class Amg {
+  public:
+    bool Setup(const CscMatrix& a);
+    int LevelNum() const { return level_vec.size() + 1; }
+
+    arma::vec Cycle(const arma::vec& rhs) const { return Cycle(0, rhs); }
+
+  private:
+    struct Level {
+        CscMatrix a;
+        CscMatrix p;  // To this level from the next, coarser one
+        CscMatrix r;
+        std::vector<double> inv_diag;
+    };
+
+    std::vector<Level> level_vec;
+    SparseLu coarse_lu;
+
+    arma::vec Cycle(const std::size_t level, const arma::vec& rhs) const;
+    void Smooth(const Level& level, const arma::vec& rhs, arma::vec& x) const;
+};
+
+#endif  // PRECONDITIONER_H
@@ -0,0 +1,164 @@
+/**
+ * @file prima.cpp
+ * @author Yaotian Liu
+ * @brief Model order reduction of linear RLC networks by Krylov projection
+ * (PRIMA)
+ * @date 2026-10-19
+ */
+
+#include "prima.h"
+
+#include <cmath>
+#include <iostream>
+
+#include "ordering.h"
+#include "sparse_lu.h"
+
+using arma::mat;
+using arma::vec;
+using std::cout;
+using std::endl;
+using std::vector;
+
+/**
+ * @brief Orthogonalize `v` against the basis, twice by modified Gram-Schmidt
+ * as once loses orthogonality on long Krylov sequences, and normalize it
+ *
+ * @param basis_vec orthonormal
+ * @param v
+ * @return true : `v` is new, now of unit length
+ * @return false : `v` lies in the span of the basis (deflated)
+ */
+static bool Orthogonalize(const vector<vec>& basis_vec, vec& v) {
+    double length = arma::norm(v);
+    if (length == 0)
+        return false;
+    for (int pass = 0; pass < 2; pass++)
+        for (const vec& b : basis_vec)
+            v -= arma::dot(v, b) * b;
+
+    double left = arma::norm(v);
+    if (left <= PRIMA_DEFLATION_TOL * length)
+        return false;
+    v = v / left;
+    return true;
+}
+
+static vec Column(const CscMatrix& a, const int j) {
+    vec column(a.n_rows, arma::fill::zeros);
+    for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+        column(a.row_index[p]) = a.value[p];
+    return column;
+}
+
+/**
+ * @brief Reduce the network G x + C dx/dt = B i of its ports (PRIMA,
+ * Odabasioglu et al.). The internal unknowns are projected onto an
+ * orthonormal basis V of the block Krylov spaces
+ * K_q((G_ii + s C_ii)^-1 C_ii, (G_ii + s C_ii)^-1 [G_ip C_ip])
+ * at every expansion point s, which matches q block moments of the port
+ * admittance there. Points where G_ii + s C_ii is singular, such as DC for
+ * internal nodes without a resistive path, are skipped and not matched. The
+ * port voltages are kept as they are, so the model is the congruence
+ * transform diag(I, V)^T {G, C} diag(I, V): with G + G^T and C positive
+ * semidefinite, as RLC stamps in MNA form are (the branch rows of inductors
+ * negated), it stays passive.
+ *
+ * @param g ports first, then the internal unknowns
+ * @param c same pattern of unknowns as `g`
+ * @param port_num
+ * @param s_vec real expansion points, 0 for DC; singular ones are skipped
+ * @param order block moments per expansion point
+ * @param g_reduced output, ports first, then the states
+ * @param c_reduced output
+ * @return true : Reduced
+ * @return false : G_ii + s C_ii is singular at every expansion point
+ */
+bool PrimaReduce(const CscMatrix& g, const CscMatrix& c, const int port_num,
+                 const vector<double>& s_vec, const int order, mat& g_reduced,
+                 mat& c_reduced) {
+    int n = g.n_cols;
+    int internal_num = n - port_num;
+
+    vector<int> port_vec;
+    vector<int> internal_vec;
+    vector<int> port_map(n, -1);
+    vector<int> internal_map(n, -1);
+    for (int i = 0; i < n; i++) {
+        if (i < port_num) {
+            port_map[i] = port_vec.size();
+            port_vec.push_back(i);
+        } else {
+            internal_map[i] = internal_vec.size();
+            internal_vec.push_back(i);
+        }
+    }
+
+    CscMatrix g_ii = Extract(g, internal_map, internal_vec, internal_num);
+    CscMatrix c_ii = Extract(c, internal_map, internal_vec, internal_num);
+    CscMatrix g_ip = Extract(g, internal_map, port_vec, internal_num);
+    CscMatrix c_ip = Extract(c, internal_map, port_vec, internal_num);
+
+    vector<vec> basis_vec;
+    bool expanded = false;
+    for (double s : s_vec) {
+        CscMatrix k = Add(g_ii, c_ii, s);
+        SparseLu lu;
+        if (!lu.Factor(k, ComputeOrdering(k, AMD_ORDERING))) {
+            cout << "PRIMA: singular at s = " << s << ", expansion point skipped" << endl;
+            continue;
+        }
+        expanded = true;
+
+        vector<vec> block;
+        for (int j = 0; j < port_num; j++) {
+            block.push_back(lu.Solve(Column(g_ip, j)));
+            block.push_back(lu.Solve(Column(c_ip, j)));
+        }
+        for (int moment = 0; moment < order && !block.empty(); moment++) {
+            vector<vec> next_block;
+            for (vec& v : block) {
+                if (Orthogonalize(basis_vec, v)) {
+                    basis_vec.push_back(v);
+                    next_block.push_back(lu.Solve(Multiply(c_ii, v)));
+                }
+            }
+            block = next_block;
+        }
+    }
+    if (!expanded)
+        return false;
+
+    // diag(I, V)^T A diag(I, V), block by block
+    int state_num = basis_vec.size();
+    auto project = [&](const CscMatrix& a, mat& reduced) {
+        reduced.zeros(port_num + state_num, port_num + state_num);
+        for (int j = 0; j < port_num; j++)
+            for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+                if (a.row_index[p] < port_num)
+                    reduced(a.row_index[p], j) = a.value[p];
+
+        CscMatrix a_pi = Extract(a, port_map, internal_vec, port_num);
+        CscMatrix a_ip = Extract(a, internal_map, port_vec, internal_num);
+        CscMatrix a_ii = Extract(a, internal_map, internal_vec, internal_num);
+        for (int b = 0; b < state_num; b++) {
+            vec a_pi_v = Multiply(a_pi, basis_vec[b]);
+            for (int i = 0; i < port_num; i++)
+                reduced(i, port_num + b) = a_pi_v(i);
+
+            for (int j = 0; j < port_num; j++) {
+                double sum = 0;
+                for (int p = a_ip.col_ptr[j]; p < a_ip.col_ptr[j + 1]; p++)
+                    sum += basis_vec[b](a_ip.row_index[p]) * a_ip.value[p];
+                reduced(port_num + b, j) = sum;
+            }
+
+            vec a_ii_v = Multiply(a_ii, basis_vec[b]);
+            for (int i = 0; i < state_num; i++)
+                reduced(port_num + i, port_num + b) = arma::dot(basis_vec[i], a_ii_v);
+        }
+    };
+    project(g, g_reduced);
+    project(c, c_reduced);
+    return true;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file prima.h
+ * @author Yaotian Liu
+ * @brief Model order reduction of linear RLC networks by Krylov projection
+ * (PRIMA)
+ * @date 2026-10-19
+ */
+
+#if !defined(PRIMA_H)
+#define PRIMA_H
+
+#include <armadillo>
+#include <vector>
+
+#include "sparse_matrix.h"
+
+// Block moments matched at every expansion point, see `.options reduceorder=...`
+const int DEFAULT_PRIMA_ORDER = 4;
+
+// A Krylov vector left shorter than this by orthogonalization, relative to
+// its length before, adds nothing new and is dropped
+const double PRIMA_DEFLATION_TOL = 1e-10;
+
+bool PrimaReduce(const CscMatrix& g, const CscMatrix& c, const int port_num,
+                 const std::vector<double>& s_vec, const int order, arma::mat& g_reduced,
+                 arma::mat& c_reduced);
+
+#endif  // PRIMA_H
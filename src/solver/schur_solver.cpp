@@ -0,0 +1,320 @@
+/**
+ * @file schur_solver.cpp
+ * @author Yaotian Liu
+ * @brief Domain decomposition: partitions factored in parallel, joined by a
+ * Schur complement on their interface
+ * @date 2026-10-19
+ */
+
+#include "schur_solver.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "../utils/work_stealing_pool.h"
+
+using arma::vec;
+using std::vector;
+
+/**
+ * @brief Partition of every unknown, -1 for the interface. The largest part
+ * is bisected until there are `partition_num`, its separator going to the
+ * interface each time.
+ *
+ * @param a
+ * @param partition_num
+ * @return vector<int>
+ */
+vector<int> SchurSolver::AssignPartitions(const CscMatrix& a, const int partition_num) const {
+    Graph graph = SymmetricGraph(a);
+    vector<vector<int>> node_vec_vec(1, vector<int>(a.n_cols));
+    std::iota(node_vec_vec[0].begin(), node_vec_vec[0].end(), 0);
+    vector<char> whole(1, 0);  // Too shallow to bisect
+
+    vector<int> left;
+    vector<int> right;
+    vector<int> separator;
+    while (int(node_vec_vec.size()) < partition_num) {
+        int largest = -1;
+        for (std::size_t k = 0; k < node_vec_vec.size(); k++)
+            if (!whole[k] &&
+                (largest < 0 || node_vec_vec[k].size() > node_vec_vec[largest].size()))
+                largest = k;
+        if (largest < 0)
+            break;
+
+        if (!BisectGraph(graph, node_vec_vec[largest], left, right, separator)) {
+            whole[largest] = 1;
+            continue;
+        }
+        node_vec_vec[largest].swap(left);
+        node_vec_vec.push_back(right);
+        whole.push_back(0);
+    }
+
+    vector<int> owner(a.n_cols, -1);
+    for (std::size_t k = 0; k < node_vec_vec.size(); k++)
+        for (int v : node_vec_vec[k])
+            owner[v] = k;
+
+    // An unknown without a diagonal entry (a branch current) pivots on a
+    // neighbour; with none left inside its partition, A_ii would be singular.
+    vector<char> has_diag(a.n_cols, 0);
+    for (int j = 0; j < a.n_cols; j++)
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+            if (a.row_index[p] == j && a.value[p] != 0)
+                has_diag[j] = 1;
+
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int v = 0; v < a.n_cols; v++) {
+            if (owner[v] < 0 || has_diag[v])
+                continue;
+            bool paired = std::any_of(graph[v].begin(), graph[v].end(),
+                                      [&](int u) { return owner[u] == owner[v]; });
+            if (!paired) {
+                owner[v] = -1;
+                moved = true;
+            }
+        }
+    }
+    return owner;
+}
+
+/**
+ * @brief Factor A_ii of a partition and work out what it takes from the
+ * Schur complement
+ *
+ * @param part interior and border set, the rest is filled
+ * @param a
+ * @param ordering column order of A_ii
+ * @param contribution output, A_bi A_ii^-1 A_ib, border by border
+ * @return true : Factored
+ * @return false : A_ii is singular
+ */
+bool SchurSolver::FactorPartition(Partition& part, const CscMatrix& a,
+                                  const OrderingType ordering,
+                                  vector<double>& contribution) const {
+    int interior_num = part.interior.size();
+    int border_num = part.border.size();
+
+    vector<int> border_col(border_num);
+    for (int k = 0; k < border_num; k++)
+        border_col[k] = interface_vec[part.border[k]];
+
+    vector<int> row_map(a.n_rows, -1);
+    for (int k = 0; k < interior_num; k++)
+        row_map[part.interior[k]] = k;
+    CscMatrix a_ii = Extract(a, row_map, part.interior, interior_num);
+    part.a_ib = Extract(a, row_map, border_col, interior_num);
+
+    for (int v : part.interior)
+        row_map[v] = -1;
+    for (int k = 0; k < border_num; k++)
+        row_map[border_col[k]] = k;
+    part.a_bi = Extract(a, row_map, part.interior, border_num);
+
+    if (!part.interior_lu.Factor(a_ii, ComputeOrdering(a_ii, ordering)))
+        return false;
+
+    // One solve per border column
+    contribution.assign(std::size_t(border_num) * border_num, 0);
+    for (int j = 0; j < border_num; j++) {
+        vec col(interior_num, arma::fill::zeros);
+        for (int p = part.a_ib.col_ptr[j]; p < part.a_ib.col_ptr[j + 1]; p++)
+            col(part.a_ib.row_index[p]) = part.a_ib.value[p];
+        vec c = Multiply(part.a_bi, part.interior_lu.Solve(col));
+        for (int i = 0; i < border_num; i++)
+            contribution[std::size_t(j) * border_num + i] = c(i);
+    }
+    return true;
+}
+
+/**
+ * @brief Partition `a` and factor it
+ *
+ * @param a square
+ * @param partition_num 0 for one per thread
+ * @param ordering column order within the partitions and the interface
+ * @param thread_num 0 for one per core
+ * @return true : Factored
+ * @return false : Singular, or fewer than two partitions came out
+ */
+bool SchurSolver::Factor(const CscMatrix& a, const int partition_num,
+                         const OrderingType ordering, const int thread_num) {
+    Clear();
+    if (a.n_cols == 0 || a.n_rows != a.n_cols)
+        return false;
+
+    if (!pool || pool->ThreadNum() != WorkStealingPool(thread_num).ThreadNum())
+        pool = std::make_shared<WorkStealingPool>(thread_num);
+    int target = partition_num > 0 ? partition_num : pool->ThreadNum();
+    vector<int> owner = AssignPartitions(a, std::max(2, target));
+
+    // Partitions emptied by moving unknowns to the interface are dropped
+    vector<int> part_index(a.n_cols, -1);
+    vector<int> s_index(a.n_cols, -1);
+    for (int v = 0; v < a.n_cols; v++) {
+        if (owner[v] < 0) {
+            s_index[v] = interface_vec.size();
+            interface_vec.push_back(v);
+            continue;
+        }
+        if (part_index[owner[v]] < 0) {
+            part_index[owner[v]] = part_vec.size();
+            part_vec.emplace_back();
+        }
+        owner[v] = part_index[owner[v]];
+        part_vec[owner[v]].interior.push_back(v);
+    }
+    if (part_vec.size() < 2) {
+        Clear();
+        return false;
+    }
+
+    for (int j = 0; j < a.n_cols; j++) {
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++) {
+            int i = a.row_index[p];
+            if (owner[i] >= 0 && owner[j] < 0)
+                part_vec[owner[i]].border.push_back(s_index[j]);
+            else if (owner[i] < 0 && owner[j] >= 0)
+                part_vec[owner[j]].border.push_back(s_index[i]);
+        }
+    }
+    for (auto& part : part_vec) {
+        std::sort(part.border.begin(), part.border.end());
+        part.border.erase(std::unique(part.border.begin(), part.border.end()),
+                          part.border.end());
+    }
+
+    vector<vector<double>> contribution_vec(part_vec.size());
+    vector<char> factored_vec(part_vec.size(), 0);
+    vector<WorkStealingPool::Job> job_vec;
+    for (std::size_t k = 0; k < part_vec.size(); k++)
+        job_vec.push_back([&, k]() {
+            factored_vec[k] = FactorPartition(part_vec[k], a, ordering, contribution_vec[k]);
+        });
+    pool->Run(job_vec);
+    if (std::count(factored_vec.begin(), factored_vec.end(), 0) > 0) {
+        Clear();
+        return false;
+    }
+
+    // S column by column: A_SS less what every partition on it takes
+    int interface_num = interface_vec.size();
+    vector<vector<std::pair<int, int>>> user_vec(interface_num);  // Partition, border
+    for (std::size_t k = 0; k < part_vec.size(); k++)
+        for (std::size_t b = 0; b < part_vec[k].border.size(); b++)
+            user_vec[part_vec[k].border[b]].push_back({int(k), int(b)});
+
+    CscMatrix s;
+    s.n_rows = s.n_cols = interface_num;
+    s.col_ptr.assign(interface_num + 1, 0);
+    vector<double> work(interface_num, 0);
+    vector<char> touched(interface_num, 0);
+    vector<int> row_vec;
+    auto add = [&](int i, double value) {
+        if (!touched[i]) {
+            touched[i] = 1;
+            row_vec.push_back(i);
+        }
+        work[i] += value;
+    };
+
+    for (int k = 0; k < interface_num; k++) {
+        int j = interface_vec[k];
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+            if (s_index[a.row_index[p]] >= 0)
+                add(s_index[a.row_index[p]], a.value[p]);
+        for (auto& user : user_vec[k]) {
+            const Partition& part = part_vec[user.first];
+            const vector<double>& contribution = contribution_vec[user.first];
+            std::size_t border_num = part.border.size();
+            for (std::size_t i = 0; i < border_num; i++)
+                add(part.border[i], -contribution[user.second * border_num + i]);
+        }
+
+        std::sort(row_vec.begin(), row_vec.end());
+        for (int i : row_vec) {
+            if (work[i] != 0) {
+                s.row_index.push_back(i);
+                s.value.push_back(work[i]);
+            }
+            work[i] = 0;
+            touched[i] = 0;
+        }
+        row_vec.clear();
+        s.col_ptr[k + 1] = s.row_index.size();
+    }
+
+    if (interface_num > 0 && !interface_lu.Factor(s, ComputeOrdering(s, ordering))) {
+        Clear();
+        return false;
+    }
+
+    n = a.n_cols;
+    return true;
+}
+
+void SchurSolver::Clear() {
+    n = 0;
+    part_vec.clear();
+    interface_vec.clear();
+    interface_lu.Clear();
+}
+
+/**
+ * @brief Solve the factored matrix for `rhs`: y_i = A_ii^-1 b_i, then the
+ * interface x_S = S^-1 (b_S - sum A_Si y_i), then the interiors
+ * x_i = A_ii^-1 (b_i - A_iS x_S)
+ */
+vec SchurSolver::Solve(const vec& rhs) const {
+    vector<vec> interior_rhs(part_vec.size());
+    vector<vec> y_vec(part_vec.size());
+    vector<WorkStealingPool::Job> job_vec;
+    for (std::size_t k = 0; k < part_vec.size(); k++)
+        job_vec.push_back([&, k]() {
+            const Partition& part = part_vec[k];
+            interior_rhs[k] = vec(part.interior.size());
+            for (std::size_t i = 0; i < part.interior.size(); i++)
+                interior_rhs[k](i) = rhs(part.interior[i]);
+            y_vec[k] = part.interior_lu.Solve(interior_rhs[k]);
+        });
+    pool->Run(job_vec);
+
+    int interface_num = interface_vec.size();
+    vec rhs_s(interface_num);
+    for (int k = 0; k < interface_num; k++)
+        rhs_s(k) = rhs(interface_vec[k]);
+    for (std::size_t k = 0; k < part_vec.size(); k++) {
+        vec c = Multiply(part_vec[k].a_bi, y_vec[k]);
+        for (std::size_t i = 0; i < part_vec[k].border.size(); i++)
+            rhs_s(part_vec[k].border[i]) -= c(i);
+    }
+
+    vec x(n);
+    vec x_s = interface_num > 0 ? interface_lu.Solve(rhs_s) : rhs_s;
+    for (int k = 0; k < interface_num; k++)
+        x(interface_vec[k]) = x_s(k);
+
+    // Partitions write disjoint entries of x
+    job_vec.clear();
+    for (std::size_t k = 0; k < part_vec.size(); k++)
+        job_vec.push_back([&, k]() {
+            const Partition& part = part_vec[k];
+            vec x_b(part.border.size());
+            for (std::size_t i = 0; i < part.border.size(); i++)
+                x_b(i) = x_s(part.border[i]);
+            vec b = interior_rhs[k];
+            vec t = Multiply(part.a_ib, x_b);
+            for (std::size_t i = 0; i < part.interior.size(); i++)
+                b(i) -= t(i);
+            vec x_i = part.interior_lu.Solve(b);
+            for (std::size_t i = 0; i < part.interior.size(); i++)
+                x(part.interior[i]) = x_i(i);
+        });
+    pool->Run(job_vec);
+    return x;
+}
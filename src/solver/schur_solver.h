@@ -0,0 +1,75 @@
+/**
+ * @file schur_solver.h
+ * @author Yaotian Liu
+ * @brief Domain decomposition: partitions factored in parallel, joined by a
+ * Schur complement on their interface
+ * @date 2026-10-19
+ */
+
+#if !defined(SCHUR_SOLVER_H)
+#define SCHUR_SOLVER_H
+
+#include <armadillo>
+#include <memory>
+#include <vector>
+
+#include "../utils/work_stealing_pool.h"
+#include "ordering.h"
+#include "sparse_lu.h"
+#include "sparse_matrix.h"
+
+// Smaller systems are factored whole; splitting them costs more than it saves
+const int SCHUR_MIN_SIZE = 1000;
+
+/**
+ * @brief The unknowns are split into partitions that only meet through the
+ * interface S, so with the interiors of all partitions first
+ *
+ *     | A_11           A_1S |
+ *     |       A_22     A_2S |
+ *     |             .. ..   |
+ *     | A_S1  A_S2  .. A_SS |
+ *
+ * Every A_ii is factored on its own thread, then the interface is solved
+ * with the Schur complement S = A_SS - sum A_Si A_ii^-1 A_iS, and the
+ * interiors follow from it, again in parallel.
+ *
+ * DC and TRAN of a linear circuit assemble their stamps straight into CSC
+ * for this solver, so memory and time follow the nonzeros, not n^2, and a
+ * power grid of a million nodes fits. Nonlinear circuits and AC still come
+ * in dense and are converted with ToCsc().
+ */
+class SchurSolver {
+  public:
+    bool Factor(const CscMatrix& a, const int partition_num, const OrderingType ordering,
+                const int thread_num);
+    void Clear();
+
+    bool Factored() const { return n > 0; }
+    int PartitionNum() const { return part_vec.size(); }
+    int InterfaceNum() const { return interface_vec.size(); }
+
+    arma::vec Solve(const arma::vec& rhs) const;
+
+  private:
+    struct Partition {
+        std::vector<int> interior;  // Unknowns of A, sorted
+        std::vector<int> border;    // Interface unknowns coupled to them, as rows of S
+        CscMatrix a_ib;             // Interior rows, border columns
+        CscMatrix a_bi;             // Border rows, interior columns
+        SparseLu interior_lu;
+    };
+
+    int n = 0;
+    // Kept from Factor() on, so the solves start no threads; shared by copies
+    std::shared_ptr<WorkStealingPool> pool;
+    std::vector<Partition> part_vec;
+    std::vector<int> interface_vec;  // Unknowns of A, sorted
+    SparseLu interface_lu;
+
+    std::vector<int> AssignPartitions(const CscMatrix& a, const int partition_num) const;
+    bool FactorPartition(Partition& part, const CscMatrix& a, const OrderingType ordering,
+                         std::vector<double>& contribution) const;
+};
+
+#endif  // SCHUR_SOLVER_H
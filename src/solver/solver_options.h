@@ -0,0 +1,64 @@
+/**
+ * @file solver_options.h
+ * @author Yaotian Liu
+ * @brief How the linear engines factor their matrices
+ * @date 2026-10-19
+ */
+
+#if !defined(SOLVER_OPTIONS_H)
+#define SOLVER_OPTIONS_H
+
+#include <string>
+#include <vector>
+
+#include "ordering.h"
+
+// `.options solver=...`
+enum SolverType { DENSE_SOLVER, SPARSE_SOLVER, SCHUR_SOLVER, ITERATIVE_SOLVER, MIXED_SOLVER };
+const std::vector<std::string> SolverType_lookup = {"dense", "sparse", "schur", "iterative",
+                                                    "mixed"};
+
+// `.options method=...`, Krylov method of the iterative solver. Auto takes
+// PCG for symmetric matrices with a positive diagonal, GMRES otherwise.
+enum KrylovMethod { AUTO_KRYLOV, PCG_KRYLOV, GMRES_KRYLOV, BICGSTAB_KRYLOV };
+const std::vector<std::string> KrylovMethod_lookup = {"auto", "pcg", "gmres", "bicgstab"};
+
+// `.options precond=...`. Auto takes IC0 for PCG, ILU0 otherwise.
+enum PreconditionerType {
+    AUTO_PRECONDITIONER,
+    NO_PRECONDITIONER,
+    JACOBI_PRECONDITIONER,
+    ILU0_PRECONDITIONER,
+    IC0_PRECONDITIONER,
+    AMG_PRECONDITIONER
+};
+const std::vector<std::string> PreconditionerType_lookup = {"auto", "none", "jacobi",
+                                                            "ilu0", "ic0",  "amg"};
+
+// `.options itol=... maxiter=...`: the iterative solver stops once the
+// residual is below itol times the right hand side
+const double DEFAULT_ITERATIVE_TOL = 1e-9;
+const int DEFAULT_MAX_ITERATIONS = 1000;
+
+struct SolverOptions {
+    SolverType solver = DENSE_SOLVER;
+    OrderingType ordering = AMD_ORDERING;  // Sparse and Schur solvers
+    int partition_num = 0;                 // Schur solver, 0 for one per thread
+    bool split = true;                     // Factor independent blocks on their own
+    int thread_num = 0;                    // 0 for one per core
+
+    KrylovMethod method = AUTO_KRYLOV;  // Iterative solver
+    PreconditionerType preconditioner = AUTO_PRECONDITIONER;
+    double tolerance = DEFAULT_ITERATIVE_TOL;
+    int max_iterations = DEFAULT_MAX_ITERATIONS;
+
+    // Same factors; the thread count and the stopping criteria do not change
+    // them
+    bool SameFactors(const SolverOptions& other) const {
+        return solver == other.solver && ordering == other.ordering &&
+               partition_num == other.partition_num && split == other.split &&
+               method == other.method && preconditioner == other.preconditioner;
+    }
+};
+
+#endif  // SOLVER_OPTIONS_H
@@ -0,0 +1,203 @@
+/**
+ * @file sparse_lu.cpp
+ * @author Yaotian Liu
+ * @brief Sparse LU factorization with threshold partial pivoting
+ * @date 2026-10-19
+ */
+
+#include "sparse_lu.h"
+
+#include <cmath>
+#include <limits>
+
+using std::vector;
+
+/**
+ * @brief Rows reached from the entries of column `col` of A in the graph of
+ * the columns of L factored so far, in topological order: xi[top .. n).
+ *
+ * @param a
+ * @param col
+ * @param xi size n, output
+ * @param mark size n, all 0, left all 0
+ * @return int top
+ */
+int SparseLu::Reach(const CscMatrix& a, const int col, vector<int>& xi, vector<char>& mark) {
+    vector<int> stack;
+    vector<int> pstack;
+    int top = n;
+
+    for (int p = a.col_ptr[col]; p < a.col_ptr[col + 1]; p++) {
+        int start = a.row_index[p];
+        if (mark[start])
+            continue;
+
+        // Depth first search, iterative; a row not pivoted yet is a leaf
+        stack.assign(1, start);
+        pstack.assign(1, -1);
+        while (!stack.empty()) {
+            int j = stack.back();
+            int jcol = pinv[j];
+            if (!mark[j]) {
+                mark[j] = 1;
+                pstack.back() = jcol < 0 ? 0 : lower.col_ptr[jcol] + 1;
+            }
+
+            bool done = true;
+            int end = jcol < 0 ? 0 : lower.col_ptr[jcol + 1];
+            for (int r = pstack.back(); r < end; r++) {
+                int i = lower.row_index[r];
+                if (mark[i])
+                    continue;
+                pstack.back() = r + 1;
+                stack.push_back(i);
+                pstack.push_back(-1);
+                done = false;
+                break;
+            }
+            if (done) {
+                stack.pop_back();
+                pstack.pop_back();
+                xi[--top] = j;
+            }
+        }
+    }
+
+    for (int p = top; p < n; p++)
+        mark[xi[p]] = 0;
+    return top;
+}
+
+/**
+ * @brief Factor `a`, eliminating its columns in the order `col_perm`
+ *
+ * @param a square
+ * @param col_perm e.g. from ComputeOrdering
+ * @return true : Factored
+ * @return false : Singular
+ */
+bool SparseLu::Factor(const CscMatrix& a, const vector<int>& col_perm) {
+    Clear();
+    if (a.n_cols == 0 || a.n_rows != a.n_cols)
+        return false;
+
+    n = a.n_cols;
+    q = col_perm;
+    pinv.assign(n, -1);
+    lower = CscMatrix();
+    upper = CscMatrix();
+    lower.n_rows = lower.n_cols = upper.n_rows = upper.n_cols = n;
+    lower.col_ptr.assign(n + 1, 0);
+    upper.col_ptr.assign(n + 1, 0);
+    lower.row_index.reserve(2 * a.NonZeros());
+    lower.value.reserve(2 * a.NonZeros());
+    upper.row_index.reserve(2 * a.NonZeros());
+    upper.value.reserve(2 * a.NonZeros());
+
+    vector<double> x(n, 0);
+    vector<int> xi(n);
+    vector<char> mark(n, 0);
+    double pivot_min = std::numeric_limits<double>::max();
+    double pivot_max = 0;
+
+    for (int k = 0; k < n; k++) {
+        lower.col_ptr[k] = lower.row_index.size();
+        upper.col_ptr[k] = upper.row_index.size();
+        int col = q[k];
+
+        // x = L \ A(:, col) on the reached rows only
+        int top = Reach(a, col, xi, mark);
+        for (int p = top; p < n; p++)
+            x[xi[p]] = 0;
+        for (int p = a.col_ptr[col]; p < a.col_ptr[col + 1]; p++)
+            x[a.row_index[p]] = a.value[p];
+        for (int px = top; px < n; px++) {
+            int j = xi[px];
+            int jcol = pinv[j];
+            if (jcol < 0)
+                continue;
+            for (int p = lower.col_ptr[jcol] + 1; p < lower.col_ptr[jcol + 1]; p++)
+                x[lower.row_index[p]] -= lower.value[p] * x[j];
+        }
+
+        // Rows pivoted before go to U, the largest of the others is the pivot
+        int ipiv = -1;
+        double largest = -1;
+        for (int p = top; p < n; p++) {
+            int i = xi[p];
+            if (pinv[i] < 0) {
+                if (std::fabs(x[i]) > largest) {
+                    largest = std::fabs(x[i]);
+                    ipiv = i;
+                }
+            } else {
+                upper.row_index.push_back(pinv[i]);
+                upper.value.push_back(x[i]);
+            }
+        }
+        if (ipiv < 0 || largest <= 0) {
+            Clear();
+            return false;
+        }
+        if (pinv[col] < 0 && std::fabs(x[col]) >= largest * SPARSE_PIVOT_TOL)
+            ipiv = col;
+
+        double pivot = x[ipiv];
+        pivot_min = std::min(pivot_min, std::fabs(pivot));
+        pivot_max = std::max(pivot_max, std::fabs(pivot));
+        upper.row_index.push_back(k);
+        upper.value.push_back(pivot);
+        pinv[ipiv] = k;
+        lower.row_index.push_back(ipiv);
+        lower.value.push_back(1);
+        for (int p = top; p < n; p++) {
+            int i = xi[p];
+            if (pinv[i] < 0) {
+                lower.row_index.push_back(i);
+                lower.value.push_back(x[i] / pivot);
+            }
+            x[i] = 0;
+        }
+    }
+    lower.col_ptr[n] = lower.row_index.size();
+    upper.col_ptr[n] = upper.row_index.size();
+
+    // Rows of L were kept as rows of A while factoring
+    for (auto& row : lower.row_index)
+        row = pinv[row];
+
+    if (pivot_min <= pivot_max * n * std::numeric_limits<double>::epsilon()) {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+void SparseLu::Clear() {
+    n = 0;
+    lower = CscMatrix();
+    upper = CscMatrix();
+    pinv.clear();
+    q.clear();
+}
+
+arma::vec SparseLu::Solve(const arma::vec& rhs) const {
+    vector<double> x(n);
+    for (int i = 0; i < n; i++)
+        x[pinv[i]] = rhs(i);
+
+    for (int j = 0; j < n; j++) {
+        for (int p = lower.col_ptr[j] + 1; p < lower.col_ptr[j + 1]; p++)
+            x[lower.row_index[p]] -= lower.value[p] * x[j];
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        x[j] /= upper.value[upper.col_ptr[j + 1] - 1];
+        for (int p = upper.col_ptr[j]; p < upper.col_ptr[j + 1] - 1; p++)
+            x[upper.row_index[p]] -= upper.value[p] * x[j];
+    }
+
+    arma::vec result(n);
+    for (int k = 0; k < n; k++)
+        result(q[k]) = x[k];
+    return result;
+}
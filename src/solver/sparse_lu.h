@@ -0,0 +1,48 @@
+/**
+ * @file sparse_lu.h
+ * @author Yaotian Liu
+ * @brief Sparse LU factorization with threshold partial pivoting
+ * @date 2026-10-19
+ */
+
+#if !defined(SPARSE_LU_H)
+#define SPARSE_LU_H
+
+#include <armadillo>
+#include <vector>
+
+#include "sparse_matrix.h"
+
+// The diagonal is kept as pivot while it is at least this fraction of the
+// largest candidate, so the fill follows the ordering; rows with no usable
+// diagonal (branch currents) pivot on the largest entry.
+const double SPARSE_PIVOT_TOL = 1e-3;
+
+/**
+ * @brief Left-looking LU (Gilbert-Peierls): column k of L and U comes from a
+ * sparse triangular solve with the columns before it, whose pattern is found
+ * by a depth first search in the graph of L. P A Q = L U, with Q the given
+ * column order and P chosen while factoring.
+ */
+class SparseLu {
+  public:
+    bool Factor(const CscMatrix& a, const std::vector<int>& col_perm);
+    void Clear();
+
+    bool Factored() const { return n > 0; }
+    long long NonZeros() const { return lower.NonZeros() + upper.NonZeros() - n; }
+
+    arma::vec Solve(const arma::vec& rhs) const;
+
+  private:
+    int n = 0;
+    CscMatrix lower;  // Unit diagonal, stored first in each column
+    CscMatrix upper;  // Diagonal stored last in each column
+    std::vector<int> pinv;  // Row i of A is row pinv[i] of L U
+    std::vector<int> q;     // Column k of L U is column q[k] of A
+
+    int Reach(const CscMatrix& a, const int col, std::vector<int>& xi,
+              std::vector<char>& mark);
+};
+
+#endif  // SPARSE_LU_H
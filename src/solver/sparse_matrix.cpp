@@ -0,0 +1,260 @@
+/**
+ * @file sparse_matrix.cpp
+ * @author Yaotian Liu
+ * @brief Compressed sparse column matrices and their graphs
+ * @date 2026-10-19
+ */
+
+#include "sparse_matrix.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Compress the nonzero entries of a dense matrix
+ */
+CscMatrix ToCsc(const arma::mat& matrix) {
+    CscMatrix a;
+    a.n_rows = matrix.n_rows;
+    a.n_cols = matrix.n_cols;
+    a.col_ptr.assign(a.n_cols + 1, 0);
+
+    for (int j = 0; j < a.n_cols; j++) {
+        const double* col = matrix.colptr(j);
+        for (int i = 0; i < a.n_rows; i++) {
+            if (col[i] != 0) {
+                a.row_index.push_back(i);
+                a.value.push_back(col[i]);
+            }
+        }
+        a.col_ptr[j + 1] = a.row_index.size();
+    }
+    return a;
+}
+
+/**
+ * @brief Expand to a dense matrix, for the dense solvers
+ */
+arma::mat ToDense(const CscMatrix& a) {
+    arma::mat matrix(a.n_rows, a.n_cols, arma::fill::zeros);
+    for (int j = 0; j < a.n_cols; j++)
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+            matrix(a.row_index[p], j) += a.value[p];
+    return matrix;
+}
+
+/**
+ * @brief Assemble a matrix from its entries, adding up the duplicates
+ *
+ * @param n_rows
+ * @param n_cols
+ * @param triplet_vec in any order
+ * @return CscMatrix
+ */
+CscMatrix FromTriplets(const int n_rows, const int n_cols,
+                       const std::vector<Triplet>& triplet_vec) {
+    CscMatrix a;
+    a.n_rows = n_rows;
+    a.n_cols = n_cols;
+    a.col_ptr.assign(n_cols + 1, 0);
+
+    std::vector<Triplet> sorted = triplet_vec;
+    std::sort(sorted.begin(), sorted.end(), [](const Triplet& x, const Triplet& y) {
+        return x.col != y.col ? x.col < y.col : x.row < y.row;
+    });
+    for (std::size_t k = 0; k < sorted.size(); k++) {
+        const Triplet& t = sorted[k];
+        if (k > 0 && t.col == sorted[k - 1].col && t.row == sorted[k - 1].row)
+            a.value.back() += t.value;
+        else {
+            a.row_index.push_back(t.row);
+            a.value.push_back(t.value);
+            a.col_ptr[t.col + 1]++;
+        }
+    }
+    for (int j = 0; j < n_cols; j++)
+        a.col_ptr[j + 1] += a.col_ptr[j];
+    return a;
+}
+
+CscMatrix Transpose(const CscMatrix& a) {
+    CscMatrix t;
+    t.n_rows = a.n_cols;
+    t.n_cols = a.n_rows;
+    t.col_ptr.assign(t.n_cols + 1, 0);
+    t.row_index.resize(a.NonZeros());
+    t.value.resize(a.NonZeros());
+
+    for (int p = 0; p < a.NonZeros(); p++)
+        t.col_ptr[a.row_index[p] + 1]++;
+    for (int i = 0; i < t.n_cols; i++)
+        t.col_ptr[i + 1] += t.col_ptr[i];
+
+    // Columns are visited in order, so the rows of `t` come out sorted
+    std::vector<int> next(t.col_ptr.begin(), t.col_ptr.end() - 1);
+    for (int j = 0; j < a.n_cols; j++) {
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++) {
+            int q = next[a.row_index[p]]++;
+            t.row_index[q] = j;
+            t.value[q] = a.value[p];
+        }
+    }
+    return t;
+}
+
+arma::vec Multiply(const CscMatrix& a, const arma::vec& x) {
+    arma::vec y(a.n_rows, arma::fill::zeros);
+    for (int j = 0; j < a.n_cols; j++) {
+        double xj = x(j);
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++)
+            y(a.row_index[p]) += a.value[p] * xj;
+    }
+    return y;
+}
+
+/**
+ * @brief A B, column by column: column j of the product gathers the columns
+ * of A picked by the entries of column j of B
+ */
+CscMatrix Multiply(const CscMatrix& a, const CscMatrix& b) {
+    CscMatrix c;
+    c.n_rows = a.n_rows;
+    c.n_cols = b.n_cols;
+    c.col_ptr.assign(c.n_cols + 1, 0);
+
+    std::vector<double> work(a.n_rows, 0);
+    std::vector<char> touched(a.n_rows, 0);
+    std::vector<int> row_vec;
+    for (int j = 0; j < b.n_cols; j++) {
+        for (int q = b.col_ptr[j]; q < b.col_ptr[j + 1]; q++) {
+            int k = b.row_index[q];
+            for (int p = a.col_ptr[k]; p < a.col_ptr[k + 1]; p++) {
+                int i = a.row_index[p];
+                if (!touched[i]) {
+                    touched[i] = 1;
+                    row_vec.push_back(i);
+                }
+                work[i] += a.value[p] * b.value[q];
+            }
+        }
+
+        std::sort(row_vec.begin(), row_vec.end());
+        for (int i : row_vec) {
+            c.row_index.push_back(i);
+            c.value.push_back(work[i]);
+            work[i] = 0;
+            touched[i] = 0;
+        }
+        row_vec.clear();
+        c.col_ptr[j + 1] = c.row_index.size();
+    }
+    return c;
+}
+
+/**
+ * @brief A + beta B, merging the sorted rows of each column
+ */
+CscMatrix Add(const CscMatrix& a, const CscMatrix& b, const double beta) {
+    CscMatrix c;
+    c.n_rows = a.n_rows;
+    c.n_cols = a.n_cols;
+    c.col_ptr.assign(c.n_cols + 1, 0);
+
+    for (int j = 0; j < a.n_cols; j++) {
+        int p = a.col_ptr[j];
+        int q = b.col_ptr[j];
+        while (p < a.col_ptr[j + 1] || q < b.col_ptr[j + 1]) {
+            int i_a = p < a.col_ptr[j + 1] ? a.row_index[p] : a.n_rows;
+            int i_b = q < b.col_ptr[j + 1] ? b.row_index[q] : b.n_rows;
+            double value = 0;
+            if (i_a <= i_b)
+                value += a.value[p++];
+            if (i_b <= i_a)
+                value += beta * b.value[q++];
+            c.row_index.push_back(std::min(i_a, i_b));
+            c.value.push_back(value);
+        }
+        c.col_ptr[j + 1] = c.row_index.size();
+    }
+    return c;
+}
+
+/**
+ * @brief The submatrix of the columns `col_vec`, with row i of `a` moved to
+ * row_map[i] and dropped where that is -1
+ *
+ * @param a
+ * @param row_map size a.n_rows, increasing over the rows kept
+ * @param col_vec
+ * @param n_rows rows of the submatrix
+ * @return CscMatrix
+ */
+CscMatrix Extract(const CscMatrix& a, const std::vector<int>& row_map,
+                  const std::vector<int>& col_vec, const int n_rows) {
+    CscMatrix sub;
+    sub.n_rows = n_rows;
+    sub.n_cols = col_vec.size();
+    sub.col_ptr.assign(sub.n_cols + 1, 0);
+
+    for (int k = 0; k < sub.n_cols; k++) {
+        int j = col_vec[k];
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++) {
+            int i = row_map[a.row_index[p]];
+            if (i >= 0) {
+                sub.row_index.push_back(i);
+                sub.value.push_back(a.value[p]);
+            }
+        }
+        sub.col_ptr[k + 1] = sub.row_index.size();
+    }
+    return sub;
+}
+
+void SortUnique(Graph& graph) {
+    for (auto& adj : graph) {
+        std::sort(adj.begin(), adj.end());
+        adj.erase(std::unique(adj.begin(), adj.end()), adj.end());
+    }
+}
+
+/**
+ * @brief Graph of A + A^T: the elimination graph of a symmetric permutation
+ */
+Graph SymmetricGraph(const CscMatrix& a) {
+    Graph graph(a.n_cols);
+    for (int j = 0; j < a.n_cols; j++) {
+        for (int p = a.col_ptr[j]; p < a.col_ptr[j + 1]; p++) {
+            int i = a.row_index[p];
+            if (i == j)
+                continue;
+            graph[i].push_back(j);
+            graph[j].push_back(i);
+        }
+    }
+    SortUnique(graph);
+    return graph;
+}
+
+/**
+ * @brief Graph of A^T A, where two columns are joined when they share a row:
+ * what column orderings work on, whatever rows partial pivoting picks. Dense
+ * rows would join almost every column and are left out, as COLAMD does.
+ */
+Graph ColumnGraph(const CscMatrix& a) {
+    CscMatrix t = Transpose(a);
+    int dense_row = std::max(16, int(10 * std::sqrt(double(a.n_cols))));
+
+    Graph graph(a.n_cols);
+    for (int i = 0; i < t.n_cols; i++) {
+        int begin = t.col_ptr[i];
+        int end = t.col_ptr[i + 1];
+        if (end - begin > dense_row)
+            continue;
+        for (int p = begin; p < end; p++)
+            for (int q = begin; q < end; q++)
+                if (p != q)
+                    graph[t.row_index[p]].push_back(t.row_index[q]);
+    }
+    SortUnique(graph);
+    return graph;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file sparse_matrix.h
+ * @author Yaotian Liu
+ * @brief Compressed sparse column matrices and their graphs
+ * @date 2026-10-19
+ */
+
+#if !defined(SPARSE_MATRIX_H)
+#define SPARSE_MATRIX_H
+
+#include <armadillo>
+#include <vector>
+
+/**
+ * @brief Compressed sparse column matrix: the entries of column j are
+ * row_index / value[col_ptr[j] .. col_ptr[j + 1]), rows sorted.
+ */
+struct CscMatrix {
+    int n_rows = 0;
+    int n_cols = 0;
+    std::vector<int> col_ptr;
+    std::vector<int> row_index;
+    std::vector<double> value;
+
+    int NonZeros() const { return col_ptr.empty() ? 0 : col_ptr.back(); }
+};
+
+// One entry of a matrix being assembled, duplicates add up
+struct Triplet {
+    int row;
+    int col;
+    double value;
+};
+
+// Adjacency lists, sorted, without self loops
+typedef std::vector<std::vector<int>> Graph;
+
+CscMatrix ToCsc(const arma::mat& matrix);
+arma::mat ToDense(const CscMatrix& a);
+CscMatrix FromTriplets(const int n_rows, const int n_cols,
+                       const std::vector<Triplet>& triplet_vec);
+CscMatrix Transpose(const CscMatrix& a);
+arma::vec Multiply(const CscMatrix& a, const arma::vec& x);
+CscMatrix Multiply(const CscMatrix& a, const CscMatrix& b);
+CscMatrix Add(const CscMatrix& a, const CscMatrix& b, const double beta);
+CscMatrix Extract(const CscMatrix& a, const std::vector<int>& row_map,
+                  const std::vector<int>& col_vec, const int n_rows);
+
+Graph SymmetricGraph(const CscMatrix& a);
+Graph ColumnGraph(const CscMatrix& a);
+
+#endif  // SPARSE_MATRIX_H
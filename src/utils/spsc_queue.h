@@ -0,0 +1,94 @@
+/**
+ * @file spsc_queue.h
+ * @author Yaotian Liu
+ * @brief Lock-free single producer / single consumer ring buffer
+ * @date 2026-10-19
+ */
+
+#if !defined(SPSC_QUEUE_H)
+#define SPSC_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Bounded ring buffer for one producer thread and one consumer thread,
+ * without locks: each side only writes its own index, and the release/acquire
+ * pair on the indices publishes the items. Items are pushed in groups that
+ * become visible together, so a consumer popping whole groups never sees half
+ * a record.
+ */
+template <typename T>
+class SpscQueue {
+  public:
+    SpscQueue(const std::size_t min_capacity) {
+        std::size_t capacity = 1;
+        while (capacity < min_capacity)
+            capacity <<= 1;
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    std::size_t Capacity() const { return buffer.size(); }
+
+    /**
+     * @brief Producer side: push `num` items, all or none
+     *
+     * @return false : Not enough room, nothing pushed
+     */
+    bool Push(const T* item, const std::size_t num) {
+        std::size_t head = write_index.load(std::memory_order_relaxed);
+        std::size_t tail = read_index.load(std::memory_order_acquire);
+        if (buffer.size() - (head - tail) < num)
+            return false;
+
+        for (std::size_t i = 0; i < num; i++)
+            buffer[(head + i) & mask] = item[i];
+        write_index.store(head + num, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side: pop up to `max_num` items
+     *
+     * @return std::size_t items popped
+     */
+    std::size_t Pop(T* item, const std::size_t max_num) {
+        std::size_t tail = read_index.load(std::memory_order_relaxed);
+        std::size_t head = write_index.load(std::memory_order_acquire);
+        std::size_t num = std::min(head - tail, max_num);
+
+        for (std::size_t i = 0; i < num; i++)
+            item[i] = buffer[(tail + i) & mask];
+        read_index.store(tail + num, std::memory_order_release);
+        return num;
+    }
+
+    /**
+     * @brief Consumer side: items ready to pop
+     */
+    std::size_t Size() const {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Drop everything. Only while neither side is running.
+     */
+    void Clear() {
+        write_index.store(0);
+        read_index.store(0);
+    }
+
+  private:
+    std::vector<T> buffer;
+    std::size_t mask;
+
+    // On separate cache lines, so the two threads do not bounce one line
+    alignas(64) std::atomic<std::size_t> write_index{0};
+    alignas(64) std::atomic<std::size_t> read_index{0};
+};
+
+#endif  // SPSC_QUEUE_H
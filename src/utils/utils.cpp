@@ -1,5 +1,8 @@
 #include "utils.h"
 
+#include <QFile>
+#include <cstring>
+
 std::ostream& operator<<(std::ostream& os, const QString& qstr) {
     os << qstr.toStdString();
     return os;
@@ -22,4 +25,43 @@ arma::mat GetReal(const arma::cx_mat cx_mat) {
     }
 
     return real;
-}
\ No newline at end of file
+}
+
+quint64 HashBytes(const uchar* data, qint64 size, quint64 seed) {
+    const quint64 prime = 0x100000001b3ULL;
+    quint64 hash = seed;
+
+    // Consume 8 bytes per round; multi-GB netlists are hashed on every run.
+    qint64 i = 0;
+    for (; i + 8 <= size; i += 8) {
+        quint64 word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ data[i]) * prime;
+
+    return hash ^ static_cast<quint64>(size);
+}
+
+quint64 HashFile(const QString file_name) {
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    qint64 size = file.size();
+    if (size == 0)
+        return HashBytes(nullptr, 0);
+
+    uchar* data = file.map(0, size);
+    if (data == nullptr) {
+        QByteArray content = file.readAll();
+        return HashBytes(reinterpret_cast<const uchar*>(content.constData()),
+                         content.size());
+    }
+
+    quint64 hash = HashBytes(data, size);
+    file.unmap(data);
+    return hash;
+}
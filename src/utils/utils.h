@@ -24,4 +24,23 @@ QString qstr(const std::string str);
  */
 arma::mat GetReal(const arma::cx_mat cx_mat);
 
+/**
+ * @brief 64-bit FNV-1a style hash over a raw byte range
+ *
+ * @param data
+ * @param size
+ * @param seed chain a previous hash to combine several ranges
+ * @return quint64
+ */
+quint64 HashBytes(const uchar* data, qint64 size, quint64 seed = 0xcbf29ce484222325ULL);
+
+/**
+ * @brief Hash the whole content of a file, mapping it into memory instead of
+ * reading it through a stream. Returns 0 if the file cannot be opened.
+ *
+ * @param file_name
+ * @return quint64
+ */
+quint64 HashFile(const QString file_name);
+
 #endif  // UTILS_H
@@ -0,0 +1,121 @@
+/**
+ * @file work_stealing_pool.cpp
+ * @author Yaotian Liu
+ * @brief Thread pool where idle threads steal queued jobs from busy ones
+ * @date 2026-10-19
+ */
+
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+/**
+ * @param thread_num 0 for one thread per core
+ */
+WorkStealingPool::WorkStealingPool(const int thread_num) {
+    int core_num = std::max(1u, std::thread::hardware_concurrency());
+    this->thread_num = thread_num > 0 ? thread_num : core_num;
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex);
+        stopping = true;
+    }
+    batch_start.notify_all();
+    for (auto& thread : thread_vec)
+        thread.join();
+}
+
+/**
+ * @brief Run every job and return when all are done. Jobs may run on any
+ * thread (the calling one included) and must not add jobs. A single job, or
+ * a pool of one thread, runs on the calling thread alone.
+ *
+ * @param job_vec
+ */
+void WorkStealingPool::Run(std::vector<Job> job_vec) {
+    if (thread_num == 1 || job_vec.size() <= 1) {
+        for (auto& job : job_vec)
+            job();
+        return;
+    }
+
+    if (thread_vec.empty()) {
+        for (int i = 0; i < thread_num; i++)
+            queue_vec.push_back(std::make_unique<JobQueue>());
+        for (int i = 1; i < thread_num; i++)
+            thread_vec.emplace_back(&WorkStealingPool::ThreadLoop, this, i);
+    }
+
+    // Dealt before the batch starts, so no thread sees a partial batch
+    int worker_num = std::min<int>(thread_num, job_vec.size());
+    for (std::size_t i = 0; i < job_vec.size(); i++)
+        queue_vec[i % worker_num]->job_deque.push_back(std::move(job_vec[i]));
+
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex);
+        batch++;
+        busy_num = thread_num - 1;
+    }
+    batch_start.notify_all();
+    WorkerLoop(0);
+
+    std::unique_lock<std::mutex> lock(batch_mutex);
+    batch_done.wait(lock, [this]() { return busy_num == 0; });
+}
+
+/**
+ * @brief Body of the threads 1.., which take part in every batch until the
+ * pool is destroyed
+ */
+void WorkStealingPool::ThreadLoop(const int worker) {
+    long long done = 0;
+    std::unique_lock<std::mutex> lock(batch_mutex);
+    while (true) {
+        batch_start.wait(lock, [&]() { return stopping || batch != done; });
+        if (stopping)
+            return;
+        done = batch;
+
+        lock.unlock();
+        WorkerLoop(worker);
+        lock.lock();
+        if (--busy_num == 0)
+            batch_done.notify_one();
+    }
+}
+
+bool WorkStealingPool::Pop(const int worker, Job& job) {
+    JobQueue& queue = *queue_vec[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.job_deque.empty())
+        return false;
+    job = std::move(queue.job_deque.back());
+    queue.job_deque.pop_back();
+    return true;
+}
+
+/**
+ * @brief Take the oldest job of another thread, trying them in turn
+ */
+bool WorkStealingPool::Steal(const int worker, Job& job) {
+    int worker_num = queue_vec.size();
+    for (int i = 1; i < worker_num; i++) {
+        JobQueue& queue = *queue_vec[(worker + i) % worker_num];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.job_deque.empty())
+            continue;
+        job = std::move(queue.job_deque.front());
+        queue.job_deque.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerLoop(const int worker) {
+    Job job;
+    // No job adds jobs, so once every deque is empty the batch is done.
+    while (Pop(worker, job) || Steal(worker, job))
+        job();
+}
@@ -0,0 +1,65 @@
+/**
+ * @file work_stealing_pool.h
+ * @author Yaotian Liu
+ * @brief Thread pool where idle threads steal queued jobs from busy ones
+ * @date 2026-10-19
+ */
+
+#if !defined(WORK_STEALING_POOL_H)
+#define WORK_STEALING_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs a batch of independent jobs. Jobs are dealt round robin to one
+ * deque per thread; a thread takes its own jobs from the back and, once out
+ * of work, steals from the front of the others' deques, so jobs of uneven
+ * cost still keep every thread busy until the batch is done.
+ *
+ * The threads are started by the first batch and wait for the next one until
+ * the pool is destroyed, so a pool kept by its user costs no thread start per
+ * batch. One batch runs at a time: Run() must not be called from two threads
+ * at once.
+ */
+class WorkStealingPool {
+  public:
+    typedef std::function<void()> Job;
+
+    WorkStealingPool(const int thread_num = 0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int ThreadNum() const { return thread_num; }
+    void Run(std::vector<Job> job_vec);
+
+  private:
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<Job> job_deque;
+    };
+
+    int thread_num;
+    std::vector<std::unique_ptr<JobQueue>> queue_vec;  // One per thread
+    std::vector<std::thread> thread_vec;               // Worker 0 is the caller
+
+    std::mutex batch_mutex;
+    std::condition_variable batch_start;
+    std::condition_variable batch_done;
+    long long batch = 0;  // Batches started
+    int busy_num = 0;     // Threads still in the current batch
+    bool stopping = false;
+
+    bool Pop(const int worker, Job& job);
+    bool Steal(const int worker, Job& job);
+    void WorkerLoop(const int worker);
+    void ThreadLoop(const int worker);
+};
+
+#endif  // WORK_STEALING_POOL_H
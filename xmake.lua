@@ -15,7 +15,8 @@ target("simpleEDA")
 
 
     add_files("src/mainwindow/mainwindow.h")
-    add_headerfiles("src/**.h | mainwindow.h")
+    add_files("src/mainwindow/analysis_worker.h")
+    add_headerfiles("src/**.h | mainwindow.h | analysis_worker.h")
     add_files("src/**.cpp")
     add_files("src/**.qrc")
 